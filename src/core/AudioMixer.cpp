@@ -0,0 +1,813 @@
+/**
+ * @file AudioMixer.cpp
+ * @brief Implementation of the AudioMixer helpers.
+ */
+
+#include "AudioMixer.h"
+#include "ExportCache.h"
+#include "MediaProbe.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QProcess>
+#include <QSaveFile>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define DUBINSTANTE_MIX_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DUBINSTANTE_MIX_NEON
+#endif
+
+namespace {
+
+// Frames mixed per block: 4096 stereo floats = 32 KiB per buffer, L1/L2 friendly
+constexpr qint64 BLOCK_FRAMES = 4096;
+
+// Limiter ceiling (-0.2 dBFS) and release time constant
+constexpr float LIMITER_CEILING = 0.977f;
+constexpr double LIMITER_RELEASE_S = 0.05;
+
+// How long a decoding pipe may stay silent before it is considered stuck
+constexpr int PIPE_TIMEOUT_MS = 30000;
+
+// Live mixing: polling period of the growing takes, how long the recorder
+// may take to create its file, and to flush its last buffers after STOP
+constexpr int LIVE_POLL_MS = 100;
+constexpr int LIVE_OPEN_TIMEOUT_MS = 5000;
+constexpr int LIVE_SETTLE_MS = 2000;
+
+constexpr quint16 WAVE_FORMAT_PCM = 1;
+constexpr quint16 WAVE_FORMAT_IEEE_FLOAT = 3;
+constexpr quint16 WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// Largest data chunk whose RIFF size (data + 36 header bytes) fits 32 bits
+constexpr quint64 MAX_RIFF_DATA_BYTES = 0xFFFFFFFFull - 36;
+
+/**
+ * Reads one mix input as interleaved stereo float at SAMPLE_RATE.
+ * PCM and float WAV files at the mix rate (the recorded takes) are read
+ * directly; anything else is decoded by an FFmpeg pipe. Growing inputs are
+ * only read directly, up to what the recorder has written so far.
+ *
+ * A pipe that fails (FFmpeg missing, decode error, stuck) is not silence:
+ * read() returns 0 and hasFailed() is set, with the reason in errorString().
+ */
+class SourceReader {
+public:
+    explicit SourceReader(const MixInput &input)
+        : m_path(input.path)
+        , m_usePipe(false)
+        , m_growing(input.growing)
+        , m_valid(true)
+        , m_pipeFinished(false)
+        , m_pipeBytes(0)
+        , m_formatTag(0)
+        , m_channels(0)
+        , m_bitsPerSample(0)
+        , m_dataRemaining(0)
+    {
+        if (!openWav(input)) {
+            if (m_growing) {
+                m_valid = false;    // A pipe would stop at the current end
+            } else {
+                openPipe(input);
+            }
+        }
+    }
+
+    ~SourceReader()
+    {
+        if (m_process.state() != QProcess::NotRunning) {
+            m_process.kill();
+            m_process.waitForFinished(1000);
+        }
+    }
+
+    /** Reads up to @p frames frames; returns the number read (0 at the end). */
+    qint64 read(float *dst, qint64 frames)
+    {
+        return m_usePipe ? readPipe(dst, frames) : readWav(dst, frames);
+    }
+
+    bool isValid() const { return m_valid; }
+    bool isGrowing() const { return m_growing; }
+    bool hasFailed() const { return !m_error.isEmpty(); }
+    const QString &errorString() const { return m_error; }
+
+    /** Frames a growing input already holds past the read position. */
+    qint64 availableFrames() const
+    {
+        const qint64 frameBytes = m_channels * (m_bitsPerSample / 8);
+        return (m_file.size() - m_file.pos()) / frameBytes;
+    }
+
+private:
+    bool openWav(const MixInput &input)
+    {
+        m_file.setFileName(input.path);
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        QDataStream in(&m_file);
+        in.setByteOrder(QDataStream::LittleEndian);
+
+        // RF64: sizes past 4 GiB are in a ds64 chunk, the data size field
+        // holds 0xFFFFFFFF and is taken as "up to the end of the file"
+        char riff[4], wave[4];
+        quint32 riffSize;
+        if (in.readRawData(riff, 4) != 4
+            || (std::memcmp(riff, "RIFF", 4) != 0 && std::memcmp(riff, "RF64", 4) != 0)) {
+            m_file.close();
+            return false;
+        }
+        in >> riffSize;
+        if (in.readRawData(wave, 4) != 4 || std::memcmp(wave, "WAVE", 4) != 0) {
+            m_file.close();
+            return false;
+        }
+
+        quint32 sampleRate = 0;
+        bool haveFormat = false;
+        while (!in.atEnd()) {
+            char id[4];
+            quint32 size;
+            if (in.readRawData(id, 4) != 4) {
+                break;
+            }
+            in >> size;
+            qint64 chunkStart = m_file.pos();
+
+            if (std::memcmp(id, "fmt ", 4) == 0 && size >= 16) {
+                quint16 formatTag, channels, blockAlign, bits;
+                quint32 byteRate;
+                in >> formatTag >> channels >> sampleRate >> byteRate >> blockAlign >> bits;
+                if (formatTag == WAVE_FORMAT_EXTENSIBLE && size >= 26) {
+                    quint16 extSize, validBits;
+                    quint32 channelMask;
+                    in >> extSize >> validBits >> channelMask >> formatTag;  // Sub-format GUID
+                }
+                m_formatTag = formatTag;
+                m_channels = channels;
+                m_bitsPerSample = bits;
+                haveFormat = true;
+            } else if (std::memcmp(id, "data", 4) == 0 && haveFormat) {
+                // Recorders that were interrupted leave a 0 or bogus size
+                qint64 available = m_file.size() - chunkStart;
+                m_dataRemaining = (size == 0 || size > available) ? available : size;
+                break;
+            }
+            m_file.seek(chunkStart + size + (size & 1));
+        }
+
+        bool supported = haveFormat && (m_dataRemaining > 0 || m_growing)
+                         && static_cast<int>(sampleRate) == AudioMixer::SAMPLE_RATE
+                         && (m_channels == 1 || m_channels == 2)
+                         && ((m_formatTag == WAVE_FORMAT_PCM
+                              && (m_bitsPerSample == 16 || m_bitsPerSample == 24
+                                  || m_bitsPerSample == 32))
+                             || (m_formatTag == WAVE_FORMAT_IEEE_FLOAT && m_bitsPerSample == 32));
+        if (!supported) {
+            m_file.close();
+            return false;
+        }
+
+        qint64 frameBytes = m_channels * (m_bitsPerSample / 8);
+        qint64 skip = qMin(m_dataRemaining,
+                           input.startMs * AudioMixer::SAMPLE_RATE / 1000 * frameBytes);
+        m_file.seek(m_file.pos() + skip);
+        m_dataRemaining -= skip;
+        return true;
+    }
+
+    void openPipe(const MixInput &input)
+    {
+        m_usePipe = true;
+        m_process.start("ffmpeg", QStringList()
+            << "-v" << "error" << "-nostdin"
+            << "-ss" << QString::number(input.startMs / 1000.0, 'f', 3)
+            << "-i" << input.path
+            << "-vn"
+            << "-f" << "f32le"
+            << "-ac" << QString::number(AudioMixer::CHANNELS)
+            << "-ar" << QString::number(AudioMixer::SAMPLE_RATE)
+            << "pipe:1");
+        if (!m_process.waitForStarted()) {
+            qWarning() << "[AudioMixer] Cannot decode" << input.path;
+            m_valid = false;
+            m_error = QString("FFmpeg est introuvable, audio non décodé : %1").arg(input.path);
+        }
+    }
+
+    qint64 readWav(float *dst, qint64 frames)
+    {
+        const int bytesPerSample = m_bitsPerSample / 8;
+        const qint64 frameBytes = m_channels * bytesPerSample;
+        if (m_growing) {
+            m_dataRemaining = m_file.size() - m_file.pos();
+        }
+        frames = qMin(frames, m_dataRemaining / frameBytes);
+        if (frames <= 0) {
+            return 0;
+        }
+
+        m_raw.resize(static_cast<int>(frames * frameBytes));
+        qint64 got = m_file.read(m_raw.data(), m_raw.size()) / frameBytes;
+        m_dataRemaining -= got * frameBytes;
+
+        const uchar *p = reinterpret_cast<const uchar *>(m_raw.constData());
+        const qint64 samples = got * m_channels;
+        float *out = dst;
+        for (qint64 i = 0; i < samples; ++i, p += bytesPerSample) {
+            float value;
+            if (m_formatTag == WAVE_FORMAT_IEEE_FLOAT) {
+                std::memcpy(&value, p, sizeof(float));
+            } else if (bytesPerSample == 2) {
+                value = static_cast<qint16>(p[0] | (p[1] << 8)) * (1.0f / 32768.0f);
+            } else if (bytesPerSample == 3) {
+                quint32 v = (quint32(p[0]) << 8) | (quint32(p[1]) << 16) | (quint32(p[2]) << 24);
+                value = static_cast<qint32>(v) * (1.0f / 2147483648.0f);
+            } else {
+                quint32 v = quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16)
+                            | (quint32(p[3]) << 24);
+                value = static_cast<qint32>(v) * (1.0f / 2147483648.0f);
+            }
+
+            if (m_channels == 1) {
+                *out++ = value;     // Mono takes go to both sides
+                *out++ = value;
+            } else {
+                *out++ = value;
+            }
+        }
+        return got;
+    }
+
+    qint64 readPipe(float *dst, qint64 frames)
+    {
+        const qint64 frameBytes = AudioMixer::CHANNELS * sizeof(float);
+        const qint64 need = frames * frameBytes;
+        while (m_pipeBuffer.size() < need && !m_pipeFinished) {
+            if (m_process.bytesAvailable() == 0
+                && !m_process.waitForReadyRead(PIPE_TIMEOUT_MS)) {
+                finishPipe();
+                break;
+            }
+            const QByteArray data = m_process.read(need - m_pipeBuffer.size());
+            m_pipeBytes += data.size();
+            m_pipeBuffer += data;
+        }
+        if (hasFailed()) {
+            return 0;
+        }
+
+        qint64 got = m_pipeBuffer.size() / frameBytes;
+        std::memcpy(dst, m_pipeBuffer.constData(), got * frameBytes);
+        m_pipeBuffer.remove(0, static_cast<int>(got * frameBytes));
+        return got;
+    }
+
+    /** No more output: a clean end, or the reason FFmpeg stopped. */
+    void finishPipe()
+    {
+        m_pipeFinished = true;
+        if (m_process.state() != QProcess::NotRunning) {
+            m_process.kill();
+            m_process.waitForFinished(1000);
+            m_error = QString("Décodage audio bloqué (%1 s sans données) : %2")
+                          .arg(PIPE_TIMEOUT_MS / 1000).arg(m_path);
+            return;
+        }
+        if (m_process.exitStatus() == QProcess::NormalExit && m_process.exitCode() == 0) {
+            return;
+        }
+
+        // A video without an audio stream has nothing to decode: silence
+        if (m_pipeBytes == 0) {
+            const MediaInfo info = MediaProbe::probe(m_path);
+            if (info.valid && !info.hasAudio) {
+                return;
+            }
+        }
+        const QString details = QString::fromUtf8(m_process.readAllStandardError()).trimmed();
+        qWarning() << "[AudioMixer] Decoding" << m_path << "failed:" << details;
+        m_error = QString("Échec du décodage audio de %1 : %2")
+                      .arg(m_path, details.isEmpty() ? QString("FFmpeg s'est arrêté") : details);
+    }
+
+    QString m_path;
+    QString m_error;
+    bool m_usePipe;
+    bool m_growing;
+    bool m_valid;
+    bool m_pipeFinished;
+    qint64 m_pipeBytes;     ///< Decoded bytes received so far
+    QFile m_file;
+    QProcess m_process;
+    QByteArray m_raw;
+    QByteArray m_pipeBuffer;
+    quint16 m_formatTag;
+    quint16 m_channels;
+    quint16 m_bitsPerSample;
+    qint64 m_dataRemaining;
+};
+
+/**
+ * Instant-attack peak limiter: the gain drops at once to keep the sample
+ * under the ceiling, then recovers exponentially. Never overshoots.
+ */
+class PeakLimiter {
+public:
+    PeakLimiter()
+        : m_gain(1.0f)
+        , m_release(static_cast<float>(
+              1.0 - std::exp(-1.0 / (LIMITER_RELEASE_S * AudioMixer::SAMPLE_RATE))))
+    {}
+
+    void process(float *samples, qint64 frames)
+    {
+        for (qint64 i = 0; i < frames; ++i) {
+            float *frame = samples + i * AudioMixer::CHANNELS;
+            float peak = std::max(std::fabs(frame[0]), std::fabs(frame[1]));
+            float required = (peak > LIMITER_CEILING) ? LIMITER_CEILING / peak : 1.0f;
+
+            if (required < m_gain) {
+                m_gain = required;
+            } else {
+                m_gain += (required - m_gain) * m_release;
+            }
+            frame[0] *= m_gain;
+            frame[1] *= m_gain;
+        }
+    }
+
+private:
+    float m_gain;
+    float m_release;
+};
+
+/** Triangular-PDF dither to 16-bit with a tiny xorshift generator. */
+class Dither16 {
+public:
+    Dither16() : m_state(0x9E3779B9u) {}
+
+    void convert(const float *src, qint16 *dst, qint64 count)
+    {
+        for (qint64 i = 0; i < count; ++i) {
+            float noise = uniform() - uniform();    // TPDF, +/- 1 LSB
+            float value = std::round(src[i] * 32767.0f + noise);
+            dst[i] = static_cast<qint16>(std::clamp(value, -32768.0f, 32767.0f));
+        }
+    }
+
+private:
+    float uniform()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return (m_state >> 8) * (1.0f / 16777216.0f);
+    }
+
+    quint32 m_state;
+};
+
+/**
+ * WAV header for @p frames frames. Past MAX_RIFF_DATA_BYTES (3.1 hours of
+ * float stereo) the sizes no longer fit the 32-bit RIFF fields: the file is
+ * then RF64 (EBU Tech 3306), its real sizes in a ds64 chunk.
+ */
+QByteArray wavHeader(qint64 frames, bool pcm16)
+{
+    const quint16 bits = pcm16 ? 16 : 32;
+    const quint16 blockAlign = AudioMixer::CHANNELS * bits / 8;
+    const quint64 dataSize = quint64(frames) * blockAlign;
+    const bool rf64 = dataSize > MAX_RIFF_DATA_BYTES;
+
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData(rf64 ? "RF64" : "RIFF", 4);
+    out << quint32(rf64 ? 0xFFFFFFFFu : 36 + dataSize);
+    out.writeRawData("WAVE", 4);
+    if (rf64) {
+        // "WAVE" + ds64, fmt and data chunk headers, then the samples
+        out.writeRawData("ds64", 4);
+        out << quint32(28)
+            << quint64(4 + (8 + 28) + (8 + 16) + 8 + dataSize)
+            << dataSize
+            << quint64(frames)
+            << quint32(0);      // No table of other chunk sizes
+    }
+    out.writeRawData("fmt ", 4);
+    out << quint32(16)
+        << quint16(pcm16 ? WAVE_FORMAT_PCM : WAVE_FORMAT_IEEE_FLOAT)
+        << quint16(AudioMixer::CHANNELS)
+        << quint32(AudioMixer::SAMPLE_RATE)
+        << quint32(AudioMixer::SAMPLE_RATE * blockAlign)
+        << blockAlign
+        << bits;
+    out.writeRawData("data", 4);
+    out << quint32(rf64 ? 0xFFFFFFFFu : dataSize);
+    return header;
+}
+
+} // namespace
+
+namespace AudioMixer {
+
+void accumulate(float *dst, const float *src, qsizetype count, float gain)
+{
+    qsizetype i = 0;
+#if defined(DUBINSTANTE_MIX_SSE)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4) {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g));
+        _mm_storeu_ps(dst + i, sum);
+    }
+#elif defined(DUBINSTANTE_MIX_NEON)
+    const float32x4_t g = vdupq_n_f32(gain);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), g));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+bool mixToFile(const MixSettings &settings, const QString &outputPath, QString *errorMessage)
+{
+    return mixToFiles(QList<MixSettings>() << settings, QStringList() << outputPath,
+                      errorMessage);
+}
+
+bool mixToFiles(const QList<MixSettings> &mixes, const QStringList &outputPaths,
+                QString *errorMessage, const std::atomic<bool> *cancelled)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Every distinct (file, start) is read once and feeds all mixes using it
+    struct SharedSource {
+        std::unique_ptr<SourceReader> reader;
+        std::vector<float> block;
+        qint64 frames = 0;
+    };
+    struct MixState {
+        std::unique_ptr<QSaveFile> file;
+        QList<int> sources;     ///< Index in `sources` of each input
+        qint64 totalFrames = 0;
+        std::vector<float> buffer;
+        std::vector<qint16> pcm;
+        PeakLimiter limiter;
+        Dither16 dither;
+    };
+
+    std::vector<SharedSource> sources;
+    QHash<QPair<QString, qint64>, int> sourceIndex;
+    std::vector<MixState> states(mixes.size());
+    qint64 maxFrames = 0;
+    int inputCount = 0;
+
+    for (int m = 0; m < mixes.size(); ++m) {
+        const MixSettings &settings = mixes[m];
+        MixState &state = states[m];
+        state.totalFrames = settings.durationMs * SAMPLE_RATE / 1000;
+        if (state.totalFrames <= 0 || settings.inputs.isEmpty()) {
+            if (errorMessage) *errorMessage = "Rien à mixer.";
+            return false;
+        }
+
+        state.file = std::make_unique<QSaveFile>(outputPaths.value(m));
+        if (!state.file->open(QIODevice::WriteOnly)) {
+            if (errorMessage) *errorMessage = state.file->errorString();
+            return false;
+        }
+        state.file->write(wavHeader(state.totalFrames, settings.dither));
+        state.buffer.resize(BLOCK_FRAMES * CHANNELS);
+        if (settings.dither) {
+            state.pcm.resize(BLOCK_FRAMES * CHANNELS);
+        }
+
+        for (const MixInput &input : settings.inputs) {
+            QPair<QString, qint64> key(input.path, input.startMs);
+            if (!sourceIndex.contains(key)) {
+                sourceIndex.insert(key, static_cast<int>(sources.size()));
+                SharedSource source;
+                source.reader = std::make_unique<SourceReader>(input);
+                if (!source.reader->isValid()) {
+                    if (errorMessage) *errorMessage = source.reader->errorString();
+                    return false;
+                }
+                source.block.resize(BLOCK_FRAMES * CHANNELS);
+                sources.push_back(std::move(source));
+            }
+            state.sources.append(sourceIndex.value(key));
+        }
+        maxFrames = qMax(maxFrames, state.totalFrames);
+        inputCount += settings.inputs.size();
+    }
+
+    qint64 mixNs = 0;
+    qint64 mixedSamples = 0;
+
+    for (qint64 done = 0; done < maxFrames;) {
+        if (cancelled && *cancelled) {
+            if (errorMessage) *errorMessage = "Mixage annulé.";
+            return false;   // Unfinished QSaveFiles are discarded
+        }
+        const qint64 frames = qMin(BLOCK_FRAMES, maxFrames - done);
+        for (SharedSource &source : sources) {
+            source.frames = source.reader->read(source.block.data(), frames);
+            if (source.reader->hasFailed()) {
+                if (errorMessage) *errorMessage = source.reader->errorString();
+                return false;   // Unfinished QSaveFiles are discarded
+            }
+        }
+
+        for (int m = 0; m < mixes.size(); ++m) {
+            MixState &state = states[m];
+            const qint64 count = qMin(frames, state.totalFrames - done);
+            if (count <= 0) {
+                continue;
+            }
+            const qsizetype samples = count * CHANNELS;
+
+            QElapsedTimer blockTimer;
+            blockTimer.start();
+            std::fill(state.buffer.begin(), state.buffer.begin() + samples, 0.0f);
+            for (int i = 0; i < state.sources.size(); ++i) {
+                const SharedSource &source = sources[state.sources[i]];
+                accumulate(state.buffer.data(), source.block.data(),
+                           qMin(source.frames, count) * CHANNELS, mixes[m].inputs[i].gain);
+            }
+            mixNs += blockTimer.nsecsElapsed();
+            mixedSamples += samples * state.sources.size();
+
+            if (mixes[m].limiter) {
+                state.limiter.process(state.buffer.data(), count);
+            }
+
+            qint64 written;
+            if (mixes[m].dither) {
+                state.dither.convert(state.buffer.data(), state.pcm.data(), samples);
+                written = state.file->write(reinterpret_cast<const char *>(state.pcm.data()),
+                                            samples * sizeof(qint16));
+            } else {
+                written = state.file->write(reinterpret_cast<const char *>(state.buffer.data()),
+                                            samples * sizeof(float));
+            }
+            if (written < 0) {
+                if (errorMessage) *errorMessage = state.file->errorString();
+                for (MixState &other : states) {
+                    other.file->cancelWriting();
+                }
+                return false;
+            }
+        }
+        done += frames;
+    }
+
+    for (MixState &state : states) {
+        if (!state.file->commit()) {
+            if (errorMessage) *errorMessage = state.file->errorString();
+            return false;
+        }
+    }
+
+    // Throughput of the SIMD kernel alone, and of the whole stage (I/O + decode)
+    double audioSeconds = static_cast<double>(maxFrames) / SAMPLE_RATE;
+    qDebug() << "[AudioMixer] Mixed" << mixes.size() << "mixes from" << sources.size()
+             << "sources (" << inputCount << "inputs )," << audioSeconds
+             << "s of audio in" << timer.elapsed() << "ms"
+             << "- kernel:" << mixedSamples / qMax<qint64>(1, mixNs / 1000) << "Msamples/s";
+    return true;
+}
+
+namespace {
+
+QString cacheKey(const MixSettings &settings)
+{
+    // Everything the output depends on goes into the key
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const MixInput &input : settings.inputs) {
+        hash.addData(ExportCache::fingerprint(input.path).toLatin1());
+        hash.addData(QByteArray::number(input.gain, 'g', 9));
+        hash.addData(QByteArray::number(input.startMs));
+    }
+    hash.addData(QByteArray::number(settings.durationMs));
+    hash.addData(QByteArray(settings.limiter ? "L" : "-"));
+    hash.addData(QByteArray(settings.dither ? "D" : "-"));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+} // namespace
+
+QStringList cachedMixes(const QList<MixSettings> &mixes, const QString &cacheDir,
+                        const std::atomic<bool> *cancelled)
+{
+    QDir dir(cacheDir);
+    dir.mkpath(".");
+
+    QStringList paths;
+    QList<MixSettings> missing;
+    QStringList missingPaths;
+    for (const MixSettings &settings : mixes) {
+        QString path = dir.filePath(cacheKey(settings) + ".wav");
+        paths << path;
+        if (QFile::exists(path)) {
+            ExportCache::touch(path);
+            qDebug() << "[AudioMixer] Reusing cached mix" << path;
+        } else if (!missingPaths.contains(path)) {
+            missing << settings;
+            missingPaths << path;
+        }
+    }
+
+    if (!missing.isEmpty()) {
+        QString error;
+        if (!mixToFiles(missing, missingPaths, &error, cancelled)) {
+            if (!(cancelled && *cancelled)) {
+                qWarning() << "[AudioMixer] Mix failed:" << error;
+            }
+            return QStringList();
+        }
+    }
+    return paths;
+}
+
+QString cachedMix(const MixSettings &settings, const QString &cacheDir)
+{
+    return cachedMixes(QList<MixSettings>() << settings, cacheDir).value(0);
+}
+
+bool decode(const QString &path, const MixSink &sink,
+            const std::atomic<bool> *cancelled, QString *errorMessage)
+{
+    return decodeRange(path, 0, -1, sink, cancelled, errorMessage);
+}
+
+bool decodeRange(const QString &path, qint64 startMs, qint64 maxFrames, const MixSink &sink,
+                 const std::atomic<bool> *cancelled, QString *errorMessage)
+{
+    MixInput input;
+    input.path = path;
+    input.startMs = startMs;
+    SourceReader reader(input);
+    if (!reader.isValid()) {
+        if (errorMessage) {
+            *errorMessage = reader.hasFailed() ? reader.errorString()
+                                               : QString("Audio illisible : %1").arg(path);
+        }
+        return false;
+    }
+
+    std::vector<float> block(BLOCK_FRAMES * CHANNELS);
+    qint64 done = 0;
+    while (maxFrames < 0 || done < maxFrames) {
+        if (cancelled && *cancelled) {
+            if (errorMessage) *errorMessage = "Décodage annulé.";
+            return false;
+        }
+        const qint64 wanted = maxFrames < 0 ? BLOCK_FRAMES : qMin(BLOCK_FRAMES, maxFrames - done);
+        const qint64 frames = reader.read(block.data(), wanted);
+        if (reader.hasFailed()) {
+            if (errorMessage) *errorMessage = reader.errorString();
+            return false;
+        }
+        if (frames <= 0) {
+            break;
+        }
+        if (!sink(block.data(), frames)) {
+            if (errorMessage) *errorMessage = "Décodage interrompu.";
+            return false;
+        }
+        done += frames;
+    }
+
+    // No audio stream: the pipe just ends
+    if (done == 0) {
+        if (errorMessage) *errorMessage = QString("Aucun audio dans %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool mixLive(const MixSettings &settings, const MixSink &sink,
+             const std::atomic<qint64> &finalDurationMs,
+             const std::atomic<bool> &cancelled,
+             QString *errorMessage)
+{
+    std::vector<std::unique_ptr<SourceReader>> readers;
+    for (const MixInput &input : settings.inputs) {
+        auto reader = std::make_unique<SourceReader>(input);
+
+        // The recorder creates its file (and header) a moment after starting
+        QElapsedTimer wait;
+        wait.start();
+        while (!reader->isValid() && !cancelled && wait.elapsed() < LIVE_OPEN_TIMEOUT_MS) {
+            QThread::msleep(LIVE_POLL_MS);
+            reader = std::make_unique<SourceReader>(input);
+        }
+        if (!reader->isValid()) {
+            if (errorMessage && reader->hasFailed()) {
+                *errorMessage = reader->errorString();
+            } else if (errorMessage) {
+                *errorMessage = QString("Prise illisible pendant l'enregistrement "
+                                        "(WAV %1 Hz attendu): %2")
+                                    .arg(SAMPLE_RATE).arg(input.path);
+            }
+            return false;
+        }
+        readers.push_back(std::move(reader));
+    }
+
+    // Frames every growing input already holds
+    auto recordedFrames = [&readers]() {
+        qint64 frames = std::numeric_limits<qint64>::max();
+        for (const auto &reader : readers) {
+            if (reader->isGrowing()) {
+                frames = qMin(frames, reader->availableFrames());
+            }
+        }
+        return frames;
+    };
+
+    std::vector<float> mix(BLOCK_FRAMES * CHANNELS);
+    std::vector<float> block(BLOCK_FRAMES * CHANNELS);
+    PeakLimiter limiter;
+    QElapsedTimer settle;
+    qint64 done = 0;
+
+    for (;;) {
+        if (cancelled) {
+            if (errorMessage) *errorMessage = "Mixage annulé.";
+            return false;
+        }
+
+        qint64 frames = BLOCK_FRAMES;
+        const qint64 finalMs = finalDurationMs.load();
+        if (finalMs >= 0) {
+            const qint64 totalFrames = finalMs * SAMPLE_RATE / 1000;
+            if (done >= totalFrames) {
+                break;
+            }
+            frames = qMin(frames, totalFrames - done);
+
+            // Let the recorder flush its last buffers before padding the end
+            if (!settle.isValid()) {
+                settle.start();
+            }
+            if (recordedFrames() < frames && settle.elapsed() < LIVE_SETTLE_MS) {
+                QThread::msleep(LIVE_POLL_MS);
+                continue;
+            }
+        } else if (recordedFrames() < BLOCK_FRAMES) {
+            QThread::msleep(LIVE_POLL_MS);
+            continue;
+        }
+
+        const qsizetype samples = frames * CHANNELS;
+        std::fill(mix.begin(), mix.begin() + samples, 0.0f);
+        for (size_t i = 0; i < readers.size(); ++i) {
+            qint64 got = readers[i]->read(block.data(), frames);
+            if (readers[i]->hasFailed()) {
+                if (errorMessage) *errorMessage = readers[i]->errorString();
+                return false;
+            }
+            accumulate(mix.data(), block.data(), got * CHANNELS, settings.inputs[i].gain);
+        }
+        if (settings.limiter) {
+            limiter.process(mix.data(), frames);
+        }
+
+        if (!sink(mix.data(), frames)) {
+            if (errorMessage) *errorMessage = "L'encodeur a cessé de lire le mixage.";
+            return false;
+        }
+        done += frames;
+    }
+
+    qDebug() << "[AudioMixer] Live mix complete:"
+             << static_cast<double>(done) / SAMPLE_RATE << "s";
+    return true;
+}
+
+} // namespace AudioMixer
@@ -0,0 +1,166 @@
+/**
+ * @file AudioMixer.h
+ * @brief Native float mixer producing the export soundtrack.
+ *
+ * Mixes the original audio and the recorded takes with exact linear gains
+ * (no input-count normalisation as with FFmpeg's amix), optionally limits
+ * the peaks and dithers to 16-bit, and writes a single WAV the encoder only
+ * has to encode. Mixes are cached by content so re-exports reuse them.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note Blocking: call from worker threads. Compressed sources are decoded
+ *       through an FFmpeg pipe; plain PCM/float WAV files are read directly.
+ */
+
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+#include <functional>
+
+/**
+ * @struct MixInput
+ * @brief One source of a mix.
+ */
+struct MixInput {
+    QString path;           ///< Media file (any format FFmpeg reads)
+    float gain = 1.0f;      ///< Linear gain
+    qint64 startMs = 0;     ///< Position in the file where the mix starts
+    bool growing = false;   ///< WAV still being recorded (mixLive only): followed as it grows
+};
+
+/**
+ * @struct MixSettings
+ * @brief Complete description of a mix; also its cache key.
+ */
+struct MixSettings {
+    QList<MixInput> inputs;
+    qint64 durationMs = 0;  ///< Output length; shorter inputs are padded with silence
+    bool limiter = true;    ///< Peak limiter keeping the sum below full scale
+    bool dither = false;    ///< TPDF-dither to 16-bit PCM instead of writing float
+};
+
+/**
+ * @namespace AudioMixer
+ * @brief Streaming mixer and its SIMD kernel.
+ */
+namespace AudioMixer {
+
+/** @brief Output sample rate of every mix. */
+constexpr int SAMPLE_RATE = 48000;
+
+/** @brief Output channel count (interleaved stereo). */
+constexpr int CHANNELS = 2;
+
+/**
+ * @brief Adds @p src scaled by @p gain into @p dst (SSE/NEON when available).
+ * @param count Number of floats (not frames).
+ */
+void accumulate(float *dst, const float *src, qsizetype count, float gain);
+
+/**
+ * @brief Mixes the inputs into a WAV file.
+ * @param settings Inputs, length and processing options.
+ * @param outputPath WAV file to write.
+ * @param errorMessage Optional output for the failure reason.
+ * @return true on success.
+ */
+bool mixToFile(const MixSettings &settings, const QString &outputPath,
+               QString *errorMessage = nullptr);
+
+/**
+ * @brief Mixes several outputs from the same sources in one pass.
+ *
+ * Each distinct source (file and start position) is read or decoded once
+ * and feeds every mix that uses it, each with its own gains. A source that
+ * ends early is padded with silence; one FFmpeg fails to decode fails the
+ * mix. Outputs past 4 GiB of samples are written as RF64.
+ *
+ * @param mixes Mix descriptions.
+ * @param outputPaths WAV file of each mix, in the same order.
+ * @param errorMessage Optional output for the failure reason.
+ * @param cancelled Optional: aborts the mix when set; nothing is written.
+ * @return true if every mix was written.
+ */
+bool mixToFiles(const QList<MixSettings> &mixes, const QStringList &outputPaths,
+                QString *errorMessage = nullptr,
+                const std::atomic<bool> *cancelled = nullptr);
+
+/**
+ * @brief Returns cached mixes, mixing the missing ones in a single pass.
+ * @param cancelled Optional: aborts the mix when set.
+ * @return One path per mix in order, or an empty list on failure or cancel.
+ */
+QStringList cachedMixes(const QList<MixSettings> &mixes, const QString &cacheDir,
+                        const std::atomic<bool> *cancelled = nullptr);
+
+/**
+ * @brief Returns a cached mix for @p settings, mixing it first if needed.
+ *
+ * The cache key covers every input (content fingerprint, gain, start) and
+ * option, so any change produces a new mix and a copied take reuses one.
+ *
+ * @param settings Mix description.
+ * @param cacheDir Directory holding the cached mixes.
+ * @return Path of the mixed WAV, or an empty string on failure.
+ */
+QString cachedMix(const MixSettings &settings, const QString &cacheDir);
+
+/** @brief Receives one mixed block of interleaved floats; false aborts the mix. */
+using MixSink = std::function<bool(const float *samples, qint64 frames)>;
+
+/**
+ * @brief Reads the audio of a media file as interleaved stereo float at SAMPLE_RATE.
+ *
+ * Same reader as the mixes: takes are read directly, anything else is
+ * decoded through FFmpeg. For analysis (waveforms...) rather than mixing.
+ *
+ * @param path Media file.
+ * @param sink Receives consecutive blocks, in order; false aborts.
+ * @param cancelled Optional: aborts the read when set.
+ * @param errorMessage Optional output for the failure reason.
+ * @return true if the whole audio went to @p sink.
+ */
+bool decode(const QString &path, const MixSink &sink,
+            const std::atomic<bool> *cancelled = nullptr,
+            QString *errorMessage = nullptr);
+
+/**
+ * @brief Same as decode(), for at most @p maxFrames frames from @p startMs.
+ *
+ * Lets several workers decode the chunks of one file in parallel.
+ *
+ * @param maxFrames Frames to read, -1 for everything up to the end.
+ * @return true if at least one frame was read and all of them went to @p sink.
+ */
+bool decodeRange(const QString &path, qint64 startMs, qint64 maxFrames, const MixSink &sink,
+                 const std::atomic<bool> *cancelled = nullptr,
+                 QString *errorMessage = nullptr);
+
+/**
+ * @brief Mixes while growing inputs are still being recorded.
+ *
+ * Growing inputs must be WAV files at SAMPLE_RATE. A block is mixed as soon
+ * as every growing input holds it, so the output trails the recording by a
+ * fraction of a second. Once @p finalDurationMs is set (>= 0) the mix is
+ * completed up to that length, padding with silence, and the call returns.
+ *
+ * @param settings Inputs and limiter option (durationMs and dither are ignored).
+ * @param sink Consumer of the mixed blocks, called in order.
+ * @param finalDurationMs Output length, -1 while the recording goes on.
+ * @param cancelled Aborts the mix when set.
+ * @param errorMessage Optional output for the failure reason.
+ * @return true if the whole mix went to @p sink.
+ */
+bool mixLive(const MixSettings &settings, const MixSink &sink,
+             const std::atomic<qint64> &finalDurationMs,
+             const std::atomic<bool> &cancelled,
+             QString *errorMessage = nullptr);
+
+} // namespace AudioMixer
+
+#endif // AUDIOMIXER_H
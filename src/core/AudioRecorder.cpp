@@ -5,6 +5,8 @@
 
 #include "AudioRecorder.h"
 
+#include <QMediaFormat>
+
 AudioRecorder::AudioRecorder(QObject *parent)
     : QObject(parent)
     , m_audioInput(new QAudioInput(this))
@@ -14,6 +16,12 @@ AudioRecorder::AudioRecorder(QObject *parent)
     m_captureSession.setAudioInput(m_audioInput);
     m_captureSession.setRecorder(m_recorder);
 
+    // Plain 48 kHz WAV: the mixer reads it directly, even while it grows
+    QMediaFormat format(QMediaFormat::Wave);
+    format.setAudioCodec(QMediaFormat::AudioCodec::Wave);
+    m_recorder->setMediaFormat(format);
+    m_recorder->setAudioSampleRate(48000);
+
     // Forward recorder signals
     connect(m_recorder, &QMediaRecorder::durationChanged,
             this, &AudioRecorder::durationChanged);
@@ -0,0 +1,411 @@
+/**
+ * @file AutosaveManager.cpp
+ * @brief Implementation of the AutosaveManager class.
+ */
+
+#include "AutosaveManager.h"
+#include "Checksum.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+
+const QString JOURNAL_FILE = QStringLiteral("journal.log");
+const QString CLEAN_FILE = QStringLiteral("clean");
+
+QString snapshotName(qint64 sequence)
+{
+    return QString("snapshot-%1.dbi").arg(sequence);
+}
+
+/** Snapshots in the directory, newest first, with their sequence number. */
+QList<QPair<qint64, QString>> listSnapshots(const QString &directory)
+{
+    static const QRegularExpression pattern(QStringLiteral("^snapshot-(\\d+)\\.dbi$"));
+    QList<QPair<qint64, QString>> snapshots;
+    const QStringList names = QDir(directory).entryList({ "snapshot-*.dbi" }, QDir::Files);
+    for (const QString &name : names) {
+        QRegularExpressionMatch match = pattern.match(name);
+        if (match.hasMatch()) {
+            snapshots.append({ match.captured(1).toLongLong(), name });
+        }
+    }
+    std::sort(snapshots.begin(), snapshots.end(),
+              [](const auto &a, const auto &b) { return a.first > b.first; });
+    return snapshots;
+}
+
+/** Journal line: CRC-32 of the JSON in hex, a space, the compact JSON. */
+QByteArray encodeRecord(const QJsonObject &record)
+{
+    QByteArray json = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    quint32 crc = Checksum::crc32(0, json.constData(), json.size());
+    return QByteArray::number(crc, 16).rightJustified(8, '0') + ' ' + json + '\n';
+}
+
+bool decodeRecord(const QByteArray &line, QJsonObject &record)
+{
+    if (line.size() < 10 || line.at(8) != ' ') {
+        return false;
+    }
+    bool ok = false;
+    quint32 crc = line.left(8).toUInt(&ok, 16);
+    QByteArray json = line.mid(9);
+    if (!ok || Checksum::crc32(0, json.constData(), json.size()) != crc) {
+        return false;
+    }
+    QJsonDocument doc = QJsonDocument::fromJson(json);
+    if (!doc.isObject()) {
+        return false;
+    }
+    record = doc.object();
+    return true;
+}
+
+bool applySetting(SaveData &data, const QString &key, const QJsonValue &value)
+{
+    if (key == "video_url") {
+        data.videoUrl = value.toString();
+    } else if (key == "video_volume") {
+        data.videoVolume = static_cast<float>(value.toDouble(1.0));
+    } else if (key == "audio_input_1") {
+        data.audioInput1 = value.toString();
+    } else if (key == "audio_gain_1") {
+        data.audioGain1 = static_cast<float>(value.toDouble(1.0));
+    } else if (key == "audio_input_2") {
+        data.audioInput2 = value.toString();
+    } else if (key == "audio_gain_2") {
+        data.audioGain2 = static_cast<float>(value.toDouble(1.0));
+    } else if (key == "enable_track_2") {
+        data.enableTrack2 = value.toBool();
+    } else if (key == "scroll_speed") {
+        data.scrollSpeed = value.toInt(100);
+    } else if (key == "is_text_white") {
+        data.isTextWhite = value.toBool(true);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/** Applies one journal record; false if it does not fit the session. */
+bool applyRecord(SaveData &data, const QJsonObject &record)
+{
+    const QString type = record.value("t").toString();
+    if (type == "set") {
+        return applySetting(data, record.value("n").toString(), record.value("v"));
+    }
+
+    const int track = record.value("k").toInt(-1);
+    if (track < 0 || track > 64) {
+        return false;
+    }
+    while (data.tracks.size() <= track) {
+        data.tracks.append(TrackSaveData());
+    }
+
+    if (type == "style") {
+        data.tracks[track].style = SaveManager::decodeStyle(record.value("v").toObject());
+        return true;
+    }
+    if (type == "text") {
+        QString &text = data.tracks[track].text;
+        const int position = record.value("p").toInt(-1);
+        const int removed = record.value("d").toInt(-1);
+        if (position < 0 || removed < 0 || position + removed > text.size()) {
+            return false;
+        }
+        text.replace(position, removed, record.value("i").toString());
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+AutosaveManager::AutosaveManager(QObject *parent, const QString &directory)
+    : QObject(parent)
+    , m_directory(directory)
+    , m_flushTimer(new QTimer(this))
+    , m_compactTimer(new QTimer(this))
+    , m_sequence(0)
+    , m_recordsSinceSnapshot(0)
+    , m_started(false)
+{
+    if (m_directory.isEmpty()) {
+        m_directory = QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation))
+                          .filePath("autosave");
+    }
+    QDir().mkpath(m_directory);
+
+    m_writer.setMaxThreadCount(1);
+
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_DELAY_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &AutosaveManager::flush);
+
+    m_compactTimer->setSingleShot(true);
+    m_compactTimer->setInterval(COMPACT_INTERVAL_MS);
+    connect(m_compactTimer, &QTimer::timeout, this, [this]() { compact(-1); });
+}
+
+AutosaveManager::~AutosaveManager()
+{
+    flush();
+    m_writer.waitForDone();
+}
+
+void AutosaveManager::setSnapshotProvider(const std::function<SaveData()> &provider)
+{
+    m_provider = provider;
+}
+
+// =============================================================================
+// Recovery
+// =============================================================================
+
+bool AutosaveManager::recover(SaveData &data)
+{
+    m_writer.waitForDone();
+    QDir dir(m_directory);
+
+    // Newest snapshot that still loads
+    SaveManager loader;
+    qint64 snapshotSequence = -1;
+    for (const auto &snapshot : listSnapshots(m_directory)) {
+        if (loader.load(dir.filePath(snapshot.second), data)) {
+            snapshotSequence = snapshot.first;
+            break;
+        }
+        qWarning() << "[Autosave] Unreadable snapshot" << snapshot.second;
+    }
+    if (snapshotSequence < 0) {
+        return false;
+    }
+
+    // Then every record written after it; a torn last line (crash while
+    // appending) ends the replay
+    qint64 lastSequence = snapshotSequence;
+    int replayed = 0;
+    QFile journal(dir.filePath(JOURNAL_FILE));
+    if (journal.open(QIODevice::ReadOnly)) {
+        while (!journal.atEnd()) {
+            QByteArray line = journal.readLine();
+            if (!line.endsWith('\n')) {
+                break;
+            }
+            line.chop(1);
+            QJsonObject record;
+            if (!decodeRecord(line, record)) {
+                qWarning() << "[Autosave] Corrupt journal record, replay stopped";
+                break;
+            }
+            const qint64 sequence = static_cast<qint64>(record.value("s").toDouble(-1));
+            if (sequence <= lastSequence) {
+                continue;   // Already in the snapshot
+            }
+            if (!applyRecord(data, record)) {
+                qWarning() << "[Autosave] Inconsistent journal record, replay stopped";
+                break;
+            }
+            lastSequence = sequence;
+            ++replayed;
+        }
+    }
+    m_sequence = qMax(m_sequence, lastSequence);
+
+    QFile clean(dir.filePath(CLEAN_FILE));
+    qint64 cleanSequence = -1;
+    if (clean.open(QIODevice::ReadOnly)) {
+        cleanSequence = clean.readAll().trimmed().toLongLong();
+    }
+
+    qDebug() << "[Autosave] Snapshot" << snapshotSequence << "+" << replayed
+             << "records, last saved at" << cleanSequence;
+    return lastSequence > cleanSequence;
+}
+
+void AutosaveManager::start(bool clean)
+{
+    m_started = true;
+    compact(clean ? m_sequence : -1);
+}
+
+qint64 AutosaveManager::sequence() const
+{
+    return m_sequence;
+}
+
+void AutosaveManager::markClean(qint64 savedSequence)
+{
+    if (m_started) {
+        compact(qMin(savedSequence, m_sequence));
+    }
+}
+
+// =============================================================================
+// Edits
+// =============================================================================
+
+void AutosaveManager::recordText(int trackIndex, const QString &text)
+{
+    if (!m_started || trackIndex < 0) {
+        return;
+    }
+    while (m_texts.size() <= trackIndex) {
+        m_texts.append(QString());
+    }
+    const QString &previous = m_texts.at(trackIndex);
+
+    // Only the span between the common prefix and suffix is stored
+    const int shortest = qMin(previous.size(), text.size());
+    int prefix = 0;
+    while (prefix < shortest && previous.at(prefix) == text.at(prefix)) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < shortest - prefix
+           && previous.at(previous.size() - 1 - suffix) == text.at(text.size() - 1 - suffix)) {
+        ++suffix;
+    }
+    // Never split a surrogate pair: a lone half does not survive JSON
+    if (prefix > 0 && text.at(prefix - 1).isHighSurrogate()) {
+        --prefix;
+    }
+    if (suffix > 0 && text.at(text.size() - suffix).isLowSurrogate()) {
+        --suffix;
+    }
+
+    QJsonObject record;
+    record["t"] = "text";
+    record["k"] = trackIndex;
+    record["p"] = prefix;
+    record["d"] = previous.size() - prefix - suffix;
+    record["i"] = text.mid(prefix, text.size() - prefix - suffix);
+    m_texts[trackIndex] = text;
+    append(record);
+}
+
+void AutosaveManager::recordTrackStyle(int trackIndex, const RythmoTrackStyle &style)
+{
+    if (!m_started || trackIndex < 0) {
+        return;
+    }
+    QJsonObject record;
+    record["t"] = "style";
+    record["k"] = trackIndex;
+    record["v"] = SaveManager::encodeStyle(style);
+    append(record);
+}
+
+void AutosaveManager::recordSetting(const QString &key, const QJsonValue &value)
+{
+    if (!m_started) {
+        return;
+    }
+    QJsonObject record;
+    record["t"] = "set";
+    record["n"] = key;
+    record["v"] = value;
+    append(record);
+}
+
+// =============================================================================
+// Writing
+// =============================================================================
+
+void AutosaveManager::append(QJsonObject record)
+{
+    record["s"] = static_cast<double>(++m_sequence);
+    m_pending += encodeRecord(record);
+    ++m_recordsSinceSnapshot;
+
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+    if (!m_compactTimer->isActive()) {
+        m_compactTimer->start();
+    }
+    if (m_recordsSinceSnapshot >= COMPACT_RECORDS) {
+        compact(-1);
+    }
+}
+
+void AutosaveManager::flush()
+{
+    m_flushTimer->stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    QByteArray bytes = m_pending;
+    m_pending.clear();
+
+    QString path = QDir(m_directory).filePath(JOURNAL_FILE);
+    m_writer.start([path, bytes]() {
+        QFile journal(path);
+        if (!journal.open(QIODevice::WriteOnly | QIODevice::Append)
+            || journal.write(bytes) != bytes.size()) {
+            qWarning() << "[Autosave] Cannot append to the journal:" << journal.errorString();
+        }
+    });
+}
+
+void AutosaveManager::compact(qint64 cleanSequence)
+{
+    // Everything recorded so far is in the provider's state: queue the
+    // pending records first so the worker writes them before the snapshot
+    flush();
+    m_compactTimer->stop();
+    m_recordsSinceSnapshot = 0;
+
+    SaveData data = m_provider ? m_provider() : SaveData();
+    m_texts.clear();
+    for (const TrackSaveData &track : data.tracks) {
+        m_texts.append(track.text);
+    }
+
+    const qint64 sequence = m_sequence;
+    const QString directory = m_directory;
+    m_writer.start([directory, data, sequence, cleanSequence]() {
+        QDir dir(directory);
+        SaveManager saver;
+        if (!saver.save(dir.filePath(snapshotName(sequence)), data)) {
+            // The journal is kept: the previous snapshot plus it still
+            // hold every edit
+            qWarning() << "[Autosave] Cannot write snapshot" << sequence;
+            return;
+        }
+
+        // Records up to this sequence are in the snapshot. Should a crash
+        // hit before the truncation, recovery skips them by sequence.
+        for (const auto &snapshot : listSnapshots(directory)) {
+            if (snapshot.first != sequence) {
+                dir.remove(snapshot.second);
+            }
+        }
+        QFile journal(dir.filePath(JOURNAL_FILE));
+        if (!journal.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << "[Autosave] Cannot reset the journal:" << journal.errorString();
+        }
+        journal.close();
+
+        if (cleanSequence >= 0) {
+            QSaveFile marker(dir.filePath(CLEAN_FILE));
+            if (marker.open(QIODevice::WriteOnly)) {
+                marker.write(QByteArray::number(cleanSequence));
+                marker.commit();
+            }
+        }
+        qDebug() << "[Autosave] Snapshot" << sequence << "- saved up to" << cleanSequence;
+    });
+}
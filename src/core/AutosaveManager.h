@@ -0,0 +1,153 @@
+/**
+ * @file AutosaveManager.h
+ * @brief Background autosave: append-only edit journal plus periodic snapshots.
+ *
+ * Every edit (text typed in a band, style or setting change) becomes a
+ * compact record appended to a journal. Text edits are stored as the
+ * replaced span only, so a keystroke costs a few bytes whatever the length
+ * of the band. Records are batched on the GUI thread and written by a
+ * single worker thread, so typing and playback never wait for the disk.
+ *
+ * Every so often the journal is compacted: the whole session is written
+ * as a regular .dbi snapshot (QSaveFile, atomic) and the journal starts
+ * over. Records and snapshots carry a sequence number, so a crash at any
+ * point recovers the latest snapshot plus the records that follow it.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ */
+
+#ifndef AUTOSAVEMANAGER_H
+#define AUTOSAVEMANAGER_H
+
+#include "SaveManager.h"
+
+#include <QByteArray>
+#include <QJsonValue>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+#include <functional>
+
+class QTimer;
+
+/**
+ * @class AutosaveManager
+ * @brief Journals session edits and recovers them after a crash.
+ *
+ * @example
+ * @code
+ * auto autosave = new AutosaveManager(this);
+ * autosave->setSnapshotProvider([this]() { return currentSaveData(); });
+ * SaveData recovered;
+ * if (autosave->recover(recovered) && askUser()) {
+ *     apply(recovered);
+ * }
+ * autosave->start();
+ * ...
+ * qint64 savedAt = autosave->sequence();
+ * if (saveManager->save(path, currentSaveData())) {
+ *     autosave->markClean(savedAt);
+ * }
+ * connect(rythmoManager, &RythmoManager::textChanged,
+ *         autosave, &AutosaveManager::recordText);
+ * @endcode
+ */
+class AutosaveManager : public QObject {
+    Q_OBJECT
+
+public:
+    /** @brief Snapshot after this many records... */
+    static constexpr int COMPACT_RECORDS = 2000;
+
+    /** @brief ...or this long after the first record since the last one. */
+    static constexpr int COMPACT_INTERVAL_MS = 60 * 1000;
+
+    /** @brief Records are written in batches at most this often. */
+    static constexpr int FLUSH_DELAY_MS = 500;
+
+    /**
+     * @param directory Where the journal and snapshots live; defaults to
+     *        an "autosave" folder in the application data directory.
+     */
+    explicit AutosaveManager(QObject *parent = nullptr, const QString &directory = QString());
+
+    /**
+     * @brief Writes pending records and waits for the worker.
+     */
+    ~AutosaveManager() override;
+
+    /**
+     * @brief Returns the full session state; called on the GUI thread at
+     *        each snapshot.
+     */
+    void setSnapshotProvider(const std::function<SaveData()> &provider);
+
+    /**
+     * @brief Rebuilds the last autosaved session.
+     *
+     * Loads the newest snapshot and replays the journal records that follow
+     * it, up to the first torn or corrupt record.
+     *
+     * @param data Receives the session.
+     * @return True if it holds changes made after the last explicit save.
+     */
+    bool recover(SaveData &data);
+
+    /**
+     * @brief Starts journaling from the current state (discards older files).
+     * @param clean True if the current state needs no recovery (saved, or new).
+     */
+    void start(bool clean = true);
+
+    /**
+     * @brief Sequence number of the last record (the state it describes).
+     */
+    qint64 sequence() const;
+
+    /**
+     * @brief Records that the user saved (or loaded) the session.
+     *
+     * Takes a snapshot. Edits recorded after @p savedSequence, e.g. while
+     * an archive was being written, still count as unsaved.
+     *
+     * @param savedSequence sequence() when the saved state was captured.
+     */
+    void markClean(qint64 savedSequence);
+
+public slots:
+    // =========================================================================
+    // Edits
+    // =========================================================================
+
+    /** @brief Records the new text of a band (stored as the changed span). */
+    void recordText(int trackIndex, const QString &text);
+
+    /** @brief Records the new style of a band. */
+    void recordTrackStyle(int trackIndex, const RythmoTrackStyle &style);
+
+    /**
+     * @brief Records a session setting.
+     * @param key Same key as in the .dbi (e.g. "scroll_speed", "video_url").
+     */
+    void recordSetting(const QString &key, const QJsonValue &value);
+
+private:
+    void append(QJsonObject record);
+    void flush();
+    void compact(qint64 cleanSequence);
+
+    QString m_directory;
+    QThreadPool m_writer;               ///< One thread: tasks run in order
+    std::function<SaveData()> m_provider;
+    QList<QString> m_texts;             ///< Last recorded text of each band
+    QByteArray m_pending;               ///< Encoded records not yet written
+    QTimer *m_flushTimer;
+    QTimer *m_compactTimer;
+    qint64 m_sequence;
+    int m_recordsSinceSnapshot;
+    bool m_started;
+};
+
+#endif // AUTOSAVEMANAGER_H
@@ -0,0 +1,276 @@
+/**
+ * @file DecodedAudio.cpp
+ * @brief Implementation of the DecodedAudio class.
+ */
+
+#include "DecodedAudio.h"
+#include "AudioMixer.h"
+#include "ExportCache.h"
+#include "MediaProbe.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTemporaryFile>
+#include <QVector>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+// File layout (cache only, never leaves the machine: samples in native order)
+//   char[8] magic | u32 sample rate | u32 channels | u64 frame count
+//   u64 reserved | frame count x channels x f32
+// The 32-byte header keeps the samples 16-byte aligned in the mapping
+const char MAGIC[8] = { 'D', 'B', 'I', 'P', 'C', 'M', 'F', '1' };
+constexpr qint64 HEADER_SIZE = 32;
+constexpr qint64 FRAME_BYTES = AudioMixer::CHANNELS * sizeof(float);
+
+const QString CACHE_KIND = QStringLiteral("pcm");
+const QString CACHE_SUFFIX = QStringLiteral("f32");
+
+// Mappings in use, so that concurrent consumers of a source share one, and
+// the lock each source is decoded under, so that it is decoded only once
+QMutex s_registryMutex;
+QHash<QString, std::weak_ptr<const DecodedAudio>> s_opened;     ///< fingerprint -> mapping
+QHash<QString, std::shared_ptr<QMutex>> s_decoding;             ///< fingerprint -> decode lock
+
+template <typename T> void appendLittleEndian(QByteArray &bytes, T value)
+{
+    value = qToLittleEndian(value);
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
+DecodedAudio::DecodedAudio()
+    : m_map(nullptr)
+    , m_samples(nullptr)
+    , m_frameCount(0)
+{
+}
+
+DecodedAudio::~DecodedAudio()
+{
+    if (m_samples) {
+        ExportCache::unpin(m_file.fileName());
+    }
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+}
+
+std::shared_ptr<const DecodedAudio> DecodedAudio::load(const QString &source,
+                                                       const std::atomic<bool> *cancelled)
+{
+    const QString fingerprint = ExportCache::fingerprint(source);
+    if (fingerprint.isEmpty()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<QMutex> decodeLock;
+    {
+        QMutexLocker lock(&s_registryMutex);
+        if (std::shared_ptr<const DecodedAudio> shared = s_opened.value(fingerprint).lock()) {
+            return shared;
+        }
+        std::shared_ptr<QMutex> &entry = s_decoding[fingerprint];
+        if (!entry) {
+            entry = std::make_shared<QMutex>();
+        }
+        decodeLock = entry;
+    }
+
+    // Callers arriving during a decode wait for it, then share its mapping
+    QMutexLocker decodeLocker(decodeLock.get());
+    {
+        QMutexLocker lock(&s_registryMutex);
+        if (std::shared_ptr<const DecodedAudio> shared = s_opened.value(fingerprint).lock()) {
+            return shared;
+        }
+    }
+
+    std::shared_ptr<const DecodedAudio> audio =
+        open(ExportCache::lookup(CACHE_KIND, fingerprint, CACHE_SUFFIX));
+    if (!audio) {
+        audio = open(decode(source, fingerprint, cancelled));
+    }
+
+    QMutexLocker lock(&s_registryMutex);
+    for (auto it = s_opened.begin(); it != s_opened.end();) {
+        it = it.value().expired() ? s_opened.erase(it) : std::next(it);
+    }
+    if (audio) {
+        s_opened.insert(fingerprint, audio);
+    }
+    if (decodeLock.use_count() == 2) {
+        s_decoding.remove(fingerprint);     // Nobody else waiting on it
+    }
+    return audio;
+}
+
+QString DecodedAudio::decode(const QString &source, const QString &fingerprint,
+                             const std::atomic<bool> *cancelled)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // The container duration only plans the chunks: every chunk but the
+    // last has a fixed length (zero-padded if the audio ends early), the
+    // last one reads up to the real end
+    const MediaInfo info = MediaProbe::probe(source);
+    const qint64 chunkCount = (info.hasAudio && info.durationMs > 0)
+                                  ? (info.durationMs + CHUNK_MS - 1) / CHUNK_MS
+                                  : 1;
+    const qint64 chunkFrames = CHUNK_MS * AudioMixer::SAMPLE_RATE / 1000;
+
+    // Written aside, then moved into the cache in one rename
+    QTemporaryFile file(QDir(ExportCache::workDirectory()).filePath("pcm-XXXXXX"));
+    file.setAutoRemove(false);
+    if (!file.open() || !file.resize(HEADER_SIZE + (chunkCount - 1) * chunkFrames * FRAME_BYTES)) {
+        qWarning() << "[DecodedAudio] Cannot create" << file.fileName();
+        QFile::remove(file.fileName());
+        return QString();
+    }
+    const QString tempPath = file.fileName();
+    file.close();
+
+    // One FFmpeg process per chunk, each writing at its own offset through
+    // its own handle
+    std::atomic<bool> stop{ false };
+    std::atomic<qint64> decodedFrames{ 0 };
+    std::atomic<qint64> lastChunkFrames{ 0 };
+    QVector<qint64> chunks(static_cast<int>(chunkCount));
+    std::iota(chunks.begin(), chunks.end(), 0);
+    QtConcurrent::blockingMap(chunks, [&](const qint64 &index) {
+        const bool last = index == chunkCount - 1;
+        QFile out(tempPath);
+        if (stop || !out.open(QIODevice::ReadWrite)
+            || !out.seek(HEADER_SIZE + index * chunkFrames * FRAME_BYTES)) {
+            stop = true;
+            return;
+        }
+
+        qint64 frames = 0;
+        QString error;
+        const bool decoded = AudioMixer::decodeRange(
+            source, index * CHUNK_MS, last ? -1 : chunkFrames,
+            [&](const float *samples, qint64 count) {
+                if (cancelled && *cancelled) {
+                    return false;
+                }
+                const qint64 bytes = count * FRAME_BYTES;
+                frames += count;
+                return out.write(reinterpret_cast<const char *>(samples), bytes) == bytes;
+            },
+            &stop, &error);
+
+        // A chunk past the end of a shorter audio stream stays silent
+        if (!decoded && (frames > 0 || index == 0 || stop || (cancelled && *cancelled))) {
+            if (!stop.exchange(true) && !(cancelled && *cancelled)) {
+                qWarning() << "[DecodedAudio]" << error;
+            }
+            return;
+        }
+        decodedFrames += frames;
+        if (last) {
+            lastChunkFrames = frames;
+        }
+    });
+
+    const qint64 frameCount = (chunkCount - 1) * chunkFrames + lastChunkFrames;
+    bool written = !stop && decodedFrames > 0;
+    if (written) {
+        QByteArray header(MAGIC, sizeof(MAGIC));
+        appendLittleEndian<quint32>(header, AudioMixer::SAMPLE_RATE);
+        appendLittleEndian<quint32>(header, AudioMixer::CHANNELS);
+        appendLittleEndian<quint64>(header, static_cast<quint64>(frameCount));
+        appendLittleEndian<quint64>(header, 0);
+
+        QFile out(tempPath);
+        written = out.open(QIODevice::ReadWrite)
+                  && out.resize(HEADER_SIZE + frameCount * FRAME_BYTES)
+                  && out.write(header) == header.size();
+    }
+    const QString path =
+        written ? ExportCache::insert(CACHE_KIND, fingerprint, CACHE_SUFFIX, tempPath) : QString();
+    if (path.isEmpty()) {
+        QFile::remove(tempPath);
+        if (!(cancelled && *cancelled)) {
+            qWarning() << "[DecodedAudio] Cannot decode the audio of" << source;
+        }
+        return QString();
+    }
+
+    const double seconds = static_cast<double>(frameCount) / AudioMixer::SAMPLE_RATE;
+    qDebug() << "[DecodedAudio] Decoded" << seconds << "s of" << source << "in" << chunkCount
+             << "chunks," << timer.elapsed() << "ms";
+
+    // Decoded outside any export: keep the PCM budget now rather than at
+    // the next export (the new file is within its grace period)
+    ExportCache::evict();
+    return path;
+}
+
+std::shared_ptr<const DecodedAudio> DecodedAudio::open(const QString &path)
+{
+    if (path.isEmpty()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<DecodedAudio> audio(new DecodedAudio());
+    audio->m_file.setFileName(path);
+    if (!audio->m_file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    const qint64 size = audio->m_file.size();
+    if (size < HEADER_SIZE) {
+        return nullptr;
+    }
+    audio->m_map = audio->m_file.map(0, size);
+    const uchar *map = audio->m_map;
+    if (!map || std::memcmp(map, MAGIC, sizeof(MAGIC)) != 0
+        || qFromLittleEndian<quint32>(map + 8) != quint32(AudioMixer::SAMPLE_RATE)
+        || qFromLittleEndian<quint32>(map + 12) != quint32(AudioMixer::CHANNELS)) {
+        return nullptr;
+    }
+    const quint64 frames = qFromLittleEndian<quint64>(map + 16);
+    if (frames == 0 || frames > quint64(size - HEADER_SIZE) / FRAME_BYTES) {
+        return nullptr;
+    }
+    audio->m_samples = reinterpret_cast<const float *>(map + HEADER_SIZE);
+    audio->m_frameCount = static_cast<qint64>(frames);
+
+    // Mapped for as long as a consumer holds it (see s_opened)
+    ExportCache::pin(path);
+    return audio;
+}
+
+qint64 DecodedAudio::durationMs() const
+{
+    return m_frameCount * 1000 / AudioMixer::SAMPLE_RATE;
+}
+
+qint64 DecodedAudio::read(qint64 firstFrame, float *dst, qint64 frames) const
+{
+    if (frames <= 0) {
+        return 0;
+    }
+    std::fill(dst, dst + frames * AudioMixer::CHANNELS, 0.0f);
+
+    const qint64 from = qMax<qint64>(firstFrame, 0);
+    const qint64 to = qMin(firstFrame + frames, m_frameCount);
+    if (from >= to) {
+        return 0;
+    }
+    std::memcpy(dst + (from - firstFrame) * AudioMixer::CHANNELS,
+                m_samples + from * AudioMixer::CHANNELS, (to - from) * FRAME_BYTES);
+    return to - from;
+}
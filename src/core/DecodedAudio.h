@@ -0,0 +1,105 @@
+/**
+ * @file DecodedAudio.h
+ * @brief Decoded audio of a media file, cached on disk and memory-mapped.
+ *
+ * Analyses of the original dialogue (waveforms, voice detection, sync
+ * checks, loudness...) all need PCM. Rather than each of them running its
+ * own FFmpeg decode, a source is decoded once to interleaved stereo float
+ * at AudioMixer::SAMPLE_RATE, filed in the export cache under its content
+ * fingerprint, and memory-mapped. Every consumer then reads any window of
+ * it at memory speed; the pages stay shared in the OS cache.
+ *
+ * The first decode is split into CHUNK_MS chunks decoded in parallel (one
+ * FFmpeg process each), written straight at their offset in the file.
+ * Concurrent load() calls for the same source share one decode and one
+ * mapping.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note load() is blocking: run it off the GUI thread. An opened instance
+ *       is read-only and may be read from any thread.
+ */
+
+#ifndef DECODEDAUDIO_H
+#define DECODEDAUDIO_H
+
+#include <QFile>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class DecodedAudio
+ * @brief Memory-mapped float PCM of one audio source.
+ *
+ * @example
+ * @code
+ * // Worker thread
+ * std::shared_ptr<const DecodedAudio> audio = DecodedAudio::load(videoPath);
+ *
+ * // One second from 1:30, zero-padded past the end
+ * std::vector<float> window(AudioMixer::SAMPLE_RATE * AudioMixer::CHANNELS);
+ * audio->read(90 * AudioMixer::SAMPLE_RATE, window.data(), AudioMixer::SAMPLE_RATE);
+ * @endcode
+ */
+class DecodedAudio {
+public:
+    /** @brief Length of the chunks decoded in parallel on first use. */
+    static constexpr qint64 CHUNK_MS = 60000;
+
+    ~DecodedAudio();
+
+    DecodedAudio(const DecodedAudio &) = delete;
+    DecodedAudio &operator=(const DecodedAudio &) = delete;
+
+    /**
+     * @brief Returns the decoded audio of @p source, decoding it on first use.
+     * @param source Media file (video, take...) or archived source.
+     * @param cancelled Optional: aborts the decode when set.
+     * @return nullptr if the audio cannot be decoded (or on cancel).
+     */
+    static std::shared_ptr<const DecodedAudio> load(const QString &source,
+                                                    const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * @brief Maps an existing decoded audio file.
+     * @return nullptr if missing or invalid.
+     */
+    static std::shared_ptr<const DecodedAudio> open(const QString &path);
+
+    /** @brief Number of frames (AudioMixer::CHANNELS samples each). */
+    qint64 frameCount() const { return m_frameCount; }
+
+    /** @brief Audio length in milliseconds. */
+    qint64 durationMs() const;
+
+    /**
+     * @brief All the frames, interleaved; frameCount() frames long.
+     *
+     * Points into the mapping: valid as long as this object lives.
+     */
+    const float *samples() const { return m_samples; }
+
+    /**
+     * @brief Copies @p frames frames from @p firstFrame into @p dst.
+     *
+     * Frames outside the audio (before 0, past the end) are silent, so
+     * windows may overhang either end.
+     *
+     * @return Number of frames that came from the audio.
+     */
+    qint64 read(qint64 firstFrame, float *dst, qint64 frames) const;
+
+private:
+    DecodedAudio();
+
+    static QString decode(const QString &source, const QString &fingerprint,
+                          const std::atomic<bool> *cancelled);
+
+    QFile m_file;
+    uchar *m_map;
+    const float *m_samples;
+    qint64 m_frameCount;
+};
+
+#endif // DECODEDAUDIO_H
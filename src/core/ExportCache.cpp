@@ -0,0 +1,320 @@
+/**
+ * @file ExportCache.cpp
+ * @brief Implementation of the ExportCache helpers.
+ */
+
+#include "ExportCache.h"
+#include "MediaSource.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Files up to this size are hashed whole; larger ones are sampled in
+// SAMPLE_COUNT blocks spread evenly over the file (4 MiB read in total)
+constexpr qint64 FULL_HASH_LIMIT = 64 * 1024 * 1024;
+constexpr qint64 SAMPLE_BYTES = 64 * 1024;
+constexpr int SAMPLE_COUNT = 64;
+
+// Artifacts used more recently than this survive eviction
+constexpr qint64 EVICTION_GRACE_MS = 10 * 60 * 1000;
+
+// Work directories of interrupted exports untouched for this long are
+// given up on: nobody is going to resume them
+constexpr qint64 STALE_WORK_MS = 7LL * 24 * 60 * 60 * 1000;
+
+std::atomic<qint64> s_maxBytes{ ExportCache::DEFAULT_MAX_BYTES };
+
+QMutex s_fingerprintMutex;
+QHash<QString, QString> s_fingerprints;     ///< "path|size|mtime" -> fingerprint
+
+// Also guards insert() against a concurrent evict()
+QMutex s_storeMutex;
+
+QMutex s_pinMutex;
+QHash<QString, int> s_pinned;       ///< Clean path -> pin count
+
+// Kinds with a budget of their own, trimmed before the whole cache
+QMutex s_budgetMutex;
+QHash<QString, qint64> s_kindMaxBytes = {
+    { QStringLiteral("pcm"), ExportCache::DEFAULT_PCM_MAX_BYTES },
+    { QStringLiteral("proxies"), ExportCache::DEFAULT_PROXY_MAX_BYTES }
+};
+
+// Scratch space of running exports, never counted nor trimmed by size
+const QString WORK_KIND = QStringLiteral("work");
+
+bool isPinned(const QString &path)
+{
+    QMutexLocker lock(&s_pinMutex);
+    return s_pinned.contains(QDir::cleanPath(path));
+}
+
+QString rootPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+}
+
+} // namespace
+
+namespace ExportCache {
+
+QString directory(const QString &kind)
+{
+    QDir dir(rootPath());
+    dir.mkpath(kind);
+    return dir.filePath(kind);
+}
+
+QString workDirectory()
+{
+    return directory(WORK_KIND);
+}
+
+QString fingerprint(const QString &path)
+{
+    // A video inside a project archive is hashed over its range only: it
+    // fingerprints like the same file extracted
+    MediaSource::ArchiveRange range;
+    const bool archived = MediaSource::parse(path, range);
+    QFileInfo info(archived ? range.archivePath : path);
+    if (!info.isFile()) {
+        return QString();
+    }
+
+    QString memoKey = (archived ? path : info.absoluteFilePath()) + '|'
+                      + QString::number(info.size()) + '|'
+                      + QString::number(info.lastModified().toMSecsSinceEpoch());
+    {
+        QMutexLocker lock(&s_fingerprintMutex);
+        auto it = s_fingerprints.constFind(memoKey);
+        if (it != s_fingerprints.constEnd()) {
+            return it.value();
+        }
+    }
+
+    std::unique_ptr<QIODevice> file(archived ? MediaSource::openDevice(path) : new QFile(path));
+    if (!file || (!file->isOpen() && !file->open(QIODevice::ReadOnly))) {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint64 size = file->size();
+    hash.addData(QByteArray::number(size));
+    if (size <= FULL_HASH_LIMIT) {
+        hash.addData(file.get());
+    } else {
+        for (int i = 0; i < SAMPLE_COUNT; ++i) {
+            file->seek((size - SAMPLE_BYTES) * i / (SAMPLE_COUNT - 1));
+            hash.addData(file->read(SAMPLE_BYTES));
+        }
+    }
+    QString result = QString::fromLatin1(hash.result().toHex());
+
+    QMutexLocker lock(&s_fingerprintMutex);
+    s_fingerprints.insert(memoKey, result);
+    return result;
+}
+
+QString key(const QStringList &parts)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const QString &part : parts) {
+        hash.addData(part.toUtf8());
+        hash.addData(QByteArray(1, '\0'));     // "ab","c" differs from "a","bc"
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString lookup(const QString &kind, const QString &key, const QString &suffix)
+{
+    QString path = QDir(directory(kind)).filePath(key + '.' + suffix);
+    if (!QFile::exists(path)) {
+        return QString();
+    }
+    touch(path);
+    qDebug() << "[ExportCache] Hit" << kind << path;
+    return path;
+}
+
+void touch(const QString &path)
+{
+    QFile file(path);
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+}
+
+QString insert(const QString &kind, const QString &key, const QString &suffix,
+               const QString &filePath)
+{
+    QMutexLocker lock(&s_storeMutex);
+
+    QString path = QDir(directory(kind)).filePath(key + '.' + suffix);
+    QString partial = path + ".part";
+    QFile::remove(partial);
+
+    // Same volume: a rename. Otherwise a copy, published atomically so a
+    // reader never sees half an artifact.
+    if (!QFile::rename(filePath, partial) && !QFile::copy(filePath, partial)) {
+        return QString();
+    }
+    QFile::remove(path);
+    if (!QFile::rename(partial, path)) {
+        QFile::remove(partial);
+        return QString();
+    }
+    touch(path);
+    return path;
+}
+
+void pin(const QString &path)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+    QMutexLocker lock(&s_pinMutex);
+    ++s_pinned[QDir::cleanPath(path)];
+}
+
+void unpin(const QString &path)
+{
+    QMutexLocker lock(&s_pinMutex);
+    auto it = s_pinned.find(QDir::cleanPath(path));
+    if (it != s_pinned.end() && --it.value() <= 0) {
+        s_pinned.erase(it);
+    }
+}
+
+void setMaxBytes(qint64 bytes)
+{
+    s_maxBytes = qMax<qint64>(0, bytes);
+}
+
+qint64 maxBytes()
+{
+    return s_maxBytes;
+}
+
+void setKindMaxBytes(const QString &kind, qint64 bytes)
+{
+    QMutexLocker lock(&s_budgetMutex);
+    if (bytes < 0) {
+        s_kindMaxBytes.remove(kind);
+    } else {
+        s_kindMaxBytes.insert(kind, bytes);
+    }
+}
+
+qint64 kindMaxBytes(const QString &kind)
+{
+    QMutexLocker lock(&s_budgetMutex);
+    return s_kindMaxBytes.value(kind, -1);
+}
+
+void evict()
+{
+    QMutexLocker lock(&s_storeMutex);
+
+    struct Entry {
+        QString kind;
+        QString path;
+        qint64 size;
+        qint64 usedMs;
+    };
+    std::vector<Entry> entries;
+    QHash<QString, qint64> kindTotals;
+    qint64 total = 0;
+
+    // Every kind shares the cap. Files at the root (tool probe) and the
+    // intermediates of running exports (work/) are not scanned
+    const QStringList kinds =
+        QDir(rootPath()).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &kind : kinds) {
+        if (kind == WORK_KIND) {
+            continue;
+        }
+        QDirIterator it(QDir(rootPath()).filePath(kind), QDir::Files,
+                        QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            entries.push_back(Entry{ kind, info.filePath(), info.size(),
+                                     info.lastModified().toMSecsSinceEpoch() });
+            kindTotals[kind] += info.size();
+            total += info.size();
+        }
+    }
+
+    QDir work(QDir(rootPath()).filePath(WORK_KIND));
+    const QFileInfoList workDirs = work.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    const qint64 staleBefore = QDateTime::currentMSecsSinceEpoch() - STALE_WORK_MS;
+    for (const QFileInfo &info : workDirs) {
+        if (info.lastModified().toMSecsSinceEpoch() < staleBefore) {
+            QDir(info.filePath()).removeRecursively();
+        }
+    }
+
+    // Kinds over their own budget first, then the whole cache over the cap
+    QHash<QString, qint64> over;
+    {
+        QMutexLocker budgetLock(&s_budgetMutex);
+        for (auto it = s_kindMaxBytes.constBegin(); it != s_kindMaxBytes.constEnd(); ++it) {
+            if (kindTotals.value(it.key()) > it.value()) {
+                over.insert(it.key(), kindTotals.value(it.key()) - it.value());
+            }
+        }
+    }
+    const qint64 cap = s_maxBytes;
+    if (total <= cap && over.isEmpty()) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.usedMs < b.usedMs; });
+
+    const qint64 graceStart = QDateTime::currentMSecsSinceEpoch() - EVICTION_GRACE_MS;
+    qint64 freed = 0;
+    auto trim = [&](const QString &kind, qint64 excess) {
+        for (Entry &entry : entries) {
+            if (excess <= 0 || entry.usedMs >= graceStart) {
+                break;
+            }
+            // Already gone, another kind, or in use for longer than the
+            // grace period (mapped, playing)
+            if (entry.path.isEmpty() || (!kind.isEmpty() && entry.kind != kind)
+                || isPinned(entry.path)) {
+                continue;
+            }
+            if (QFile::remove(entry.path)) {
+                excess -= entry.size;
+                freed += entry.size;
+            }
+            entry.path.clear();
+        }
+    };
+    for (auto it = over.constBegin(); it != over.constEnd(); ++it) {
+        trim(it.key(), it.value());
+    }
+    trim(QString(), total - freed - cap);
+
+    qDebug() << "[ExportCache] Evicted" << freed / (1024 * 1024) << "MiB, cache now"
+             << (total - freed) / (1024 * 1024) << "MiB";
+}
+
+} // namespace ExportCache
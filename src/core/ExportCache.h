@@ -0,0 +1,156 @@
+/**
+ * @file ExportCache.h
+ * @brief Content-addressed store for intermediate export artifacts.
+ *
+ * Trimmed/encoded video segments, premixed soundtracks and encoded audio
+ * are filed under a key derived from everything they depend on: the
+ * content fingerprint of the sources, the range, gains and encoder
+ * settings. A repeat export (same take to another path, trivial change
+ * elsewhere) finds the unchanged artifacts and skips their work.
+ *
+ * The store lives in the application cache directory, one sub-directory
+ * per kind of artifact, and is capped in size with least-recently-used
+ * eviction (a hit refreshes the file's modification time). The other
+ * caches filed there (peaks, decoded PCM, thumbnails, keyframe indexes,
+ * proxies) share the cap; files they keep open are pinned.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note Thread-safe: called from the export planning threads.
+ */
+
+#ifndef EXPORTCACHE_H
+#define EXPORTCACHE_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @namespace ExportCache
+ * @brief Keys, lookup, insertion and LRU eviction of cached artifacts.
+ */
+namespace ExportCache {
+
+/** @brief Default size cap of the export artifacts (20 GiB). */
+constexpr qint64 DEFAULT_MAX_BYTES = 20LL * 1024 * 1024 * 1024;
+
+/**
+ * @brief Default budget of decoded PCM (6 GiB).
+ *
+ * Float stereo takes about 1.3 GB per feature film: a handful of sources,
+ * rather than most of the cap.
+ */
+constexpr qint64 DEFAULT_PCM_MAX_BYTES = 6LL * 1024 * 1024 * 1024;
+
+/**
+ * @brief Default budget of edit proxies (8 GiB).
+ *
+ * An all-intra proxy weighs several GB per source: the recent ones stay,
+ * older ones are generated again if reopened.
+ */
+constexpr qint64 DEFAULT_PROXY_MAX_BYTES = 8LL * 1024 * 1024 * 1024;
+
+/**
+ * @brief Returns the directory holding artifacts of @p kind, creating it.
+ * @param kind Sub-directory name ("premix", "audio", "segments"...).
+ */
+QString directory(const QString &kind);
+
+/**
+ * @brief Returns scratch space on the cache volume for running exports.
+ *
+ * Not subject to the size cap: an interrupted export keeps its segments
+ * there to resume from, until they are a week old. Intermediate files
+ * written there reach the cache by a rename rather than a copy.
+ */
+QString workDirectory();
+
+/**
+ * @brief Returns a content fingerprint of a file.
+ *
+ * Small files are hashed whole. Larger ones hash their size and blocks
+ * sampled evenly from start to end, so multi-gigabyte videos fingerprint
+ * in milliseconds. The path is not part of it: a copy of a file has the
+ * same fingerprint, and so does a video played from a project archive
+ * (see MediaSource). Results are memoised per path, size and
+ * modification time.
+ *
+ * @return Hex digest, or an empty string if the file cannot be read.
+ */
+QString fingerprint(const QString &path);
+
+/**
+ * @brief Hashes the parts an artifact depends on into a cache key.
+ */
+QString key(const QStringList &parts);
+
+/**
+ * @brief Returns the cached artifact for @p key, or an empty string.
+ *
+ * A hit counts as a use for the LRU order.
+ */
+QString lookup(const QString &kind, const QString &key, const QString &suffix);
+
+/**
+ * @brief Marks a cached file as just used.
+ */
+void touch(const QString &path);
+
+/**
+ * @brief Moves @p filePath into the cache under @p key.
+ * @return Path of the cached artifact, or an empty string on failure.
+ */
+QString insert(const QString &kind, const QString &key, const QString &suffix,
+               const QString &filePath);
+
+/**
+ * @brief Keeps @p path from eviction until the matching unpin().
+ *
+ * For files used longer than a hit's grace period: a mapped PCM file,
+ * the proxy being played. Counted: pinned twice, unpinned twice.
+ */
+void pin(const QString &path);
+
+/**
+ * @brief Releases a pin() of @p path.
+ */
+void unpin(const QString &path);
+
+/**
+ * @brief Sets the size cap enforced by evict().
+ */
+void setMaxBytes(qint64 bytes);
+
+/**
+ * @brief Returns the current size cap.
+ */
+qint64 maxBytes();
+
+/**
+ * @brief Gives @p kind a budget of its own, within the global cap.
+ *
+ * evict() trims a kind over its budget first, least recently used files
+ * first, whatever the total. A negative @p bytes removes the budget.
+ * "pcm" has DEFAULT_PCM_MAX_BYTES and "proxies" DEFAULT_PROXY_MAX_BYTES
+ * by default.
+ */
+void setKindMaxBytes(const QString &kind, qint64 bytes);
+
+/**
+ * @brief Returns the budget of @p kind, -1 if it only has the global cap.
+ */
+qint64 kindMaxBytes(const QString &kind);
+
+/**
+ * @brief Deletes least recently used artifacts until the cache fits its cap.
+ *
+ * Every kind counts and may be deleted; kinds with a budget of their own
+ * (setKindMaxBytes) are trimmed to it first. Pinned files, and files used in
+ * the last few minutes, are kept whatever the size, so a running export
+ * never loses its inputs nor a player its mapping. Work directories
+ * (not counted) of exports abandoned for a week are removed as well.
+ */
+void evict();
+
+} // namespace ExportCache
+
+#endif // EXPORTCACHE_H
@@ -0,0 +1,601 @@
+/**
+ * @file ExportQueue.cpp
+ * @brief Implementation of the ExportQueue class.
+ */
+
+#include "ExportQueue.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QUuid>
+
+#include <algorithm>
+
+namespace {
+
+// =============================================================================
+// ExportConfig <-> JSON (only what the user sets; the rest is derived)
+// =============================================================================
+
+QJsonObject styleToJson(const RythmoTrackStyle &style)
+{
+    QJsonObject object;
+    object["font"] = style.font.toString();
+    object["text_color"] = style.textColor.name(QColor::HexArgb);
+    object["bg_color"] = style.backgroundColor.name(QColor::HexArgb);
+    object["size"] = style.globalSize;
+    return object;
+}
+
+RythmoTrackStyle styleFromJson(const QJsonObject &object)
+{
+    RythmoTrackStyle style;
+    style.font.fromString(object.value("font").toString());
+    style.textColor = QColor(object.value("text_color").toString(style.textColor.name(QColor::HexArgb)));
+    style.backgroundColor =
+        QColor(object.value("bg_color").toString(style.backgroundColor.name(QColor::HexArgb)));
+    style.globalSize = object.value("size").toInt(style.globalSize);
+    return style;
+}
+
+QJsonObject configToJson(const ExportConfig &config)
+{
+    QJsonObject object;
+    object["video"] = config.videoPath;
+    object["audio"] = config.audioPath;
+    object["audio2"] = config.secondAudioPath;
+    object["output"] = config.outputPath;
+    object["duration_ms"] = config.durationMs;
+    object["start_ms"] = config.startTimeMs;
+    object["original_volume"] = config.originalVolume;
+    object["audio_gain"] = config.audioGain;
+    object["audio2_gain"] = config.secondAudioGain;
+    object["limiter"] = config.audioLimiter;
+    object["dither"] = config.audioDither;
+    object["video_mode"] = static_cast<int>(config.videoMode);
+    object["workers"] = config.encodeWorkers;
+    object["rythmo_speed"] = config.rythmoSpeed;
+    object["encoded_audio"] = config.encodedAudioPath;
+
+    QJsonArray bands;
+    for (const RythmoBandTrack &track : config.burnInTracks) {
+        QJsonObject band;
+        band["text"] = track.text;
+        band["style"] = styleToJson(track.style);
+        bands.append(band);
+    }
+    object["burn_in"] = bands;
+
+    QJsonArray outputs;
+    for (const ExportOutput &output : config.additionalOutputs) {
+        QJsonObject out;
+        out["path"] = output.outputPath;
+        out["original_volume"] = output.originalVolume;
+        out["audio_gain"] = output.audioGain;
+        out["audio2_gain"] = output.secondAudioGain;
+        outputs.append(out);
+    }
+    object["outputs"] = outputs;
+
+    QJsonArray tracks;
+    for (const ExportAudioTrack &track : config.audioTracks) {
+        QJsonObject t;
+        t["path"] = track.audioPath;
+        t["start_ms"] = track.startMs;
+        t["gain"] = track.gain;
+        t["language"] = track.language;
+        t["title"] = track.title;
+        tracks.append(t);
+    }
+    object["audio_tracks"] = tracks;
+    return object;
+}
+
+ExportConfig configFromJson(const QJsonObject &object)
+{
+    ExportConfig config;
+    config.videoPath = object.value("video").toString();
+    config.audioPath = object.value("audio").toString();
+    config.secondAudioPath = object.value("audio2").toString();
+    config.outputPath = object.value("output").toString();
+    config.durationMs = object.value("duration_ms").toInteger(-1);
+    config.startTimeMs = object.value("start_ms").toInteger(0);
+    config.originalVolume = static_cast<float>(object.value("original_volume").toDouble(1.0));
+    config.audioGain = static_cast<float>(object.value("audio_gain").toDouble(1.0));
+    config.secondAudioGain = static_cast<float>(object.value("audio2_gain").toDouble(1.0));
+    config.audioLimiter = object.value("limiter").toBool(true);
+    config.audioDither = object.value("dither").toBool(false);
+    config.videoMode = static_cast<ExportConfig::VideoMode>(
+        object.value("video_mode").toInt(ExportConfig::ReEncode));
+    config.encodeWorkers = object.value("workers").toInt(0);
+    config.rythmoSpeed = object.value("rythmo_speed").toInt(100);
+    config.encodedAudioPath = object.value("encoded_audio").toString();
+
+    for (const QJsonValue &value : object.value("burn_in").toArray()) {
+        QJsonObject band = value.toObject();
+        config.burnInTracks.append(RythmoBandTrack{
+            band.value("text").toString(), styleFromJson(band.value("style").toObject()) });
+    }
+    for (const QJsonValue &value : object.value("outputs").toArray()) {
+        QJsonObject out = value.toObject();
+        ExportOutput output;
+        output.outputPath = out.value("path").toString();
+        output.originalVolume = static_cast<float>(out.value("original_volume").toDouble(1.0));
+        output.audioGain = static_cast<float>(out.value("audio_gain").toDouble(1.0));
+        output.secondAudioGain = static_cast<float>(out.value("audio2_gain").toDouble(1.0));
+        config.additionalOutputs.append(output);
+    }
+    for (const QJsonValue &value : object.value("audio_tracks").toArray()) {
+        QJsonObject t = value.toObject();
+        ExportAudioTrack track;
+        track.audioPath = t.value("path").toString();
+        track.startMs = t.value("start_ms").toInteger(0);
+        track.gain = static_cast<float>(t.value("gain").toDouble(1.0));
+        track.language = t.value("language").toString();
+        track.title = t.value("title").toString();
+        config.audioTracks.append(track);
+    }
+    return config;
+}
+
+bool isFinished(ExportJob::State state)
+{
+    return state == ExportJob::Succeeded || state == ExportJob::Failed
+           || state == ExportJob::Cancelled;
+}
+
+} // namespace
+
+ExportQueue::ExportQueue(QObject *parent)
+    : QObject(parent)
+    , m_maxConcurrentJobs(defaultConcurrentJobs())
+    , m_paused(false)
+{
+    load();
+    // Let the owner connect its signals before resumed jobs report
+    QMetaObject::invokeMethod(this, &ExportQueue::schedule, Qt::QueuedConnection);
+}
+
+ExportQueue::~ExportQueue()
+{
+    // Running jobs are saved as such and start again next time
+    save();
+}
+
+// =============================================================================
+// Jobs
+// =============================================================================
+
+QString ExportQueue::enqueue(const ExportConfig &config, int priority, bool held)
+{
+    ExportJob job;
+    job.id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    job.config = config;
+    job.priority = priority;
+    job.createdMs = QDateTime::currentMSecsSinceEpoch();
+    job.state = held ? ExportJob::Held : ExportJob::Queued;
+
+    // The next recording reuses the same take files: keep this job's own
+    QString directory = QDir(storageRoot()).filePath(job.id);
+    if (!adoptTakes(job.config, directory)) {
+        qWarning() << "[ExportQueue] Cannot store the takes of" << config.outputPath;
+        QDir(directory).removeRecursively();
+        return QString();
+    }
+
+    if (!isBusy()) {
+        m_batch.clear();    // A new batch starts
+    }
+    m_batch.append(job.id);
+    m_jobs.append(job);
+    save();
+
+    qDebug() << "[ExportQueue] Queued" << job.id << "->" << config.outputPath
+             << "priority" << priority;
+    emit jobChanged(job.id);
+    updateOverallProgress();
+    schedule();
+    return job.id;
+}
+
+void ExportQueue::attachEncodedAudio(const QString &id, const QString &encodedAudioPath)
+{
+    ExportJob *job = findJob(id);
+    if (!job || (job->state != ExportJob::Queued && job->state != ExportJob::Held)) {
+        return;
+    }
+
+    if (!encodedAudioPath.isEmpty()) {
+        QString target = QDir(QDir(storageRoot()).filePath(id))
+                             .filePath(QFileInfo(encodedAudioPath).fileName());
+        if (QFile::rename(encodedAudioPath, target) || QFile::copy(encodedAudioPath, target)) {
+            job->config.encodedAudioPath = target;
+        } else {
+            qWarning() << "[ExportQueue] Cannot store the soundtrack of" << id;
+        }
+    }
+
+    job->state = ExportJob::Queued;
+    save();
+    emit jobChanged(id);
+    updateOverallProgress();
+    schedule();
+}
+
+void ExportQueue::setJobHeld(const QString &id, bool held)
+{
+    ExportJob *job = findJob(id);
+    if (!job || (job->state != ExportJob::Queued && job->state != ExportJob::Held)) {
+        return;
+    }
+    job->state = held ? ExportJob::Held : ExportJob::Queued;
+    save();
+    emit jobChanged(id);
+    schedule();
+}
+
+void ExportQueue::setJobPriority(const QString &id, int priority)
+{
+    ExportJob *job = findJob(id);
+    if (!job || (job->state != ExportJob::Queued && job->state != ExportJob::Held)) {
+        return;
+    }
+    job->priority = priority;
+    save();
+    emit jobChanged(id);
+}
+
+void ExportQueue::cancelJob(const QString &id)
+{
+    ExportJob *job = findJob(id);
+    if (!job || isFinished(job->state)) {
+        return;
+    }
+
+    bool running = (job->state == ExportJob::Running);
+    job->state = ExportJob::Cancelled;
+    job->message = "Export annulé par l'utilisateur.";
+    if (running) {
+        // Reported back through onJobFinished, which keeps the Cancelled state
+        ExportService *service = m_serviceJobs.key(id);
+        if (service) {
+            service->cancelExport();
+        }
+    } else {
+        save();
+        emit jobChanged(id);
+        emit jobFinished(id, false, job->message);
+        updateOverallProgress();
+    }
+}
+
+void ExportQueue::clearFinished()
+{
+    QStringList removed;
+    for (auto it = m_jobs.begin(); it != m_jobs.end();) {
+        if (isFinished(it->state)) {
+            QDir(QDir(storageRoot()).filePath(it->id)).removeRecursively();
+            m_batch.removeAll(it->id);
+            removed << it->id;
+            it = m_jobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    save();
+    for (const QString &id : removed) {
+        emit jobRemoved(id);
+    }
+    updateOverallProgress();
+}
+
+QList<ExportJob> ExportQueue::jobs() const
+{
+    QList<ExportJob> ordered = m_jobs;
+    std::stable_sort(ordered.begin(), ordered.end(), [](const ExportJob &a, const ExportJob &b) {
+        if (a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        return a.createdMs < b.createdMs;
+    });
+    return ordered;
+}
+
+ExportJob ExportQueue::job(const QString &id) const
+{
+    for (const ExportJob &job : m_jobs) {
+        if (job.id == id) {
+            return job;
+        }
+    }
+    return ExportJob();
+}
+
+// =============================================================================
+// Scheduler
+// =============================================================================
+
+void ExportQueue::setPaused(bool paused)
+{
+    m_paused = paused;
+    if (!paused) {
+        schedule();
+    }
+}
+
+bool ExportQueue::isPaused() const
+{
+    return m_paused;
+}
+
+void ExportQueue::setMaxConcurrentJobs(int count)
+{
+    m_maxConcurrentJobs = qMax(1, count);
+    schedule();
+}
+
+int ExportQueue::maxConcurrentJobs() const
+{
+    return m_maxConcurrentJobs;
+}
+
+int ExportQueue::defaultConcurrentJobs()
+{
+    // Each job already runs ~4-thread encoders in parallel (see
+    // ExportService): two jobs per 16 cores keeps the machine busy without
+    // starving the recording
+    return qBound(1, QThread::idealThreadCount() / 8, 4);
+}
+
+bool ExportQueue::isBusy() const
+{
+    for (const ExportJob &job : m_jobs) {
+        if (job.state == ExportJob::Queued || job.state == ExportJob::Running) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ExportQueue::schedule()
+{
+    while (!m_paused && m_serviceJobs.size() < m_maxConcurrentJobs) {
+        // Highest priority first, then oldest
+        ExportJob *next = nullptr;
+        for (ExportJob &job : m_jobs) {
+            if (job.state != ExportJob::Queued) {
+                continue;
+            }
+            if (!next || job.priority > next->priority
+                || (job.priority == next->priority && job.createdMs < next->createdMs)) {
+                next = &job;
+            }
+        }
+        if (!next) {
+            return;
+        }
+
+        ExportService *service = idleService();
+        if (!service) {
+            return;
+        }
+
+        ExportConfig config = next->config;
+        if (config.encodeWorkers <= 0) {
+            // Share the encoder pool between the jobs running side by side
+            int perJob = qBound(1, QThread::idealThreadCount() / 4, 8) / m_maxConcurrentJobs;
+            config.encodeWorkers = qMax(1, perJob);
+        }
+
+        // Mapped before starting: a config error is reported synchronously
+        next->state = ExportJob::Running;
+        next->progress = 0;
+        QString id = next->id;
+        m_serviceJobs.insert(service, id);
+        save();
+        emit jobChanged(id);
+
+        qDebug() << "[ExportQueue] Starting" << id << "(" << m_serviceJobs.size() << "/"
+                 << m_maxConcurrentJobs << "slots )";
+        service->startExport(config);
+    }
+}
+
+ExportService *ExportQueue::idleService()
+{
+    for (ExportService *service : m_services) {
+        if (!m_serviceJobs.contains(service)) {
+            return service;
+        }
+    }
+    if (m_services.size() >= m_maxConcurrentJobs) {
+        return nullptr;
+    }
+
+    auto *service = new ExportService(this);
+    connect(service, &ExportService::progressChanged, this,
+            [this, service](int percentage) { onJobProgress(service, percentage); });
+    connect(service, &ExportService::exportFinished, this,
+            [this, service](bool success, const QString &message) {
+                onJobFinished(service, success, message);
+            });
+    m_services.append(service);
+    return service;
+}
+
+void ExportQueue::onJobProgress(ExportService *service, int percentage)
+{
+    ExportJob *job = findJob(m_serviceJobs.value(service));
+    if (!job || job->progress == percentage) {
+        return;
+    }
+    job->progress = percentage;
+    emit jobChanged(job->id);
+    updateOverallProgress();
+}
+
+void ExportQueue::onJobFinished(ExportService *service, bool success, const QString &message)
+{
+    QString id = m_serviceJobs.take(service);
+    ExportJob *job = findJob(id);
+    if (!job) {
+        return;
+    }
+
+    if (job->state != ExportJob::Cancelled) {
+        job->state = success ? ExportJob::Succeeded : ExportJob::Failed;
+        job->message = message;
+    }
+    job->progress = success ? 100 : job->progress;
+    save();
+
+    qDebug() << "[ExportQueue] Job" << id << (success ? "succeeded" : "failed") << message;
+    emit jobChanged(id);
+    emit jobFinished(id, success, job->message);
+    updateOverallProgress();
+
+    // Not from inside the service's signal: it may still be unwinding
+    QMetaObject::invokeMethod(this, &ExportQueue::schedule, Qt::QueuedConnection);
+}
+
+ExportJob *ExportQueue::findJob(const QString &id)
+{
+    for (ExportJob &job : m_jobs) {
+        if (job.id == id) {
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+void ExportQueue::updateOverallProgress()
+{
+    if (m_batch.isEmpty()) {
+        return;
+    }
+
+    int total = 0;
+    int counted = 0;
+    for (const QString &id : m_batch) {
+        ExportJob *job = findJob(id);
+        if (!job || job->state == ExportJob::Cancelled) {
+            continue;
+        }
+        total += isFinished(job->state) ? 100 : job->progress;
+        ++counted;
+    }
+    emit overallProgressChanged(counted > 0 ? total / counted : 100);
+}
+
+// =============================================================================
+// Persistence
+// =============================================================================
+
+QString ExportQueue::storageRoot()
+{
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+    dir.mkpath("export-queue");
+    return dir.filePath("export-queue");
+}
+
+void ExportQueue::save() const
+{
+    QJsonArray jobs;
+    for (const ExportJob &job : m_jobs) {
+        QJsonObject object;
+        object["id"] = job.id;
+        object["priority"] = job.priority;
+        object["created_ms"] = job.createdMs;
+        object["state"] = static_cast<int>(job.state);
+        object["message"] = job.message;
+        object["config"] = configToJson(job.config);
+        jobs.append(object);
+    }
+
+    QJsonObject root;
+    root["version"] = 1;
+    root["jobs"] = jobs;
+
+    QSaveFile file(QDir(storageRoot()).filePath("queue.json"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[ExportQueue] Cannot save the queue:" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void ExportQueue::load()
+{
+    QFile file(QDir(storageRoot()).filePath("queue.json"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QJsonArray jobs = QJsonDocument::fromJson(file.readAll()).object().value("jobs").toArray();
+    for (const QJsonValue &value : jobs) {
+        QJsonObject object = value.toObject();
+        ExportJob job;
+        job.id = object.value("id").toString();
+        job.priority = object.value("priority").toInt();
+        job.createdMs = object.value("created_ms").toInteger();
+        job.state = static_cast<ExportJob::State>(object.value("state").toInt());
+        job.message = object.value("message").toString();
+        job.config = configFromJson(object.value("config").toObject());
+        if (job.id.isEmpty()) {
+            continue;
+        }
+        if (job.state == ExportJob::Running) {
+            job.state = ExportJob::Queued;      // Interrupted: start over
+        }
+        if (!isFinished(job.state)) {
+            m_batch.append(job.id);
+        }
+        job.progress = isFinished(job.state) ? 100 : 0;
+        m_jobs.append(job);
+    }
+    qDebug() << "[ExportQueue] Restored" << m_jobs.size() << "jobs";
+}
+
+bool ExportQueue::adoptTakes(ExportConfig &config, const QString &directory)
+{
+    QDir dir(directory);
+    if (!dir.mkpath(".")) {
+        return false;
+    }
+
+    // Same file referenced twice (take + its language track) moves once
+    QHash<QString, QString> moved;
+    auto adopt = [&](QString &path) {
+        if (path.isEmpty() || path == config.videoPath) {
+            return true;
+        }
+        if (moved.contains(path)) {
+            path = moved.value(path);
+            return true;
+        }
+        QString target = dir.filePath(QString("%1_%2").arg(moved.size()).arg(QFileInfo(path).fileName()));
+        if (!QFile::rename(path, target) && !QFile::copy(path, target)) {
+            return false;
+        }
+        moved.insert(path, target);
+        path = target;
+        return true;
+    };
+
+    bool ok = adopt(config.audioPath) && adopt(config.secondAudioPath)
+              && adopt(config.encodedAudioPath);
+    for (ExportAudioTrack &track : config.audioTracks) {
+        ok = ok && adopt(track.audioPath);
+    }
+    return ok;
+}
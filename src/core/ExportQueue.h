@@ -0,0 +1,211 @@
+/**
+ * @file ExportQueue.h
+ * @brief Persistent batch export queue with priorities and concurrent jobs.
+ *
+ * Exports are queued instead of refused while another one runs. A small
+ * scheduler starts the highest-priority jobs first, several at a time on
+ * their own ExportService, and keeps going while the user records the
+ * next loop. The takes of each job are moved into the queue's storage, so
+ * the next recording cannot overwrite them, and the queue is saved on
+ * every change so it survives a restart.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ */
+
+#ifndef EXPORTQUEUE_H
+#define EXPORTQUEUE_H
+
+#include "ExportService.h"
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+/**
+ * @struct ExportJob
+ * @brief One queued export and its state.
+ */
+struct ExportJob {
+    /**
+     * @enum State
+     * @brief Lifecycle of a job.
+     */
+    enum State {
+        Queued,     ///< Waiting for a free slot
+        Held,       ///< Paused by the user: not started until resumed
+        Running,
+        Succeeded,
+        Failed,
+        Cancelled
+    };
+
+    QString id;             ///< Stable identifier (UUID)
+    ExportConfig config;    ///< Paths point at the queue's copy of the takes
+    int priority = 0;       ///< Higher starts first; FIFO within a priority
+    qint64 createdMs = 0;   ///< Enqueue time (ms since epoch)
+    State state = Queued;
+    int progress = 0;       ///< 0 to 100
+    QString message;        ///< Result or error of a finished job
+};
+
+/**
+ * @class ExportQueue
+ * @brief Schedules queued exports on a bounded pool of ExportService.
+ *
+ * @example
+ * @code
+ * auto queue = new ExportQueue(this);
+ * connect(queue, &ExportQueue::overallProgressChanged,
+ *         progressBar, &QProgressBar::setValue);
+ * queue->enqueue(config);          // returns at once
+ * queue->enqueue(urgentConfig, 1); // starts before the first one if it waits
+ * @endcode
+ */
+class ExportQueue : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Loads the saved queue; unfinished jobs are queued again.
+     */
+    explicit ExportQueue(QObject *parent = nullptr);
+    ~ExportQueue() override;
+
+    // =========================================================================
+    // Jobs
+    // =========================================================================
+
+    /**
+     * @brief Queues an export and starts it as soon as a slot is free.
+     *
+     * The takes (audioPath, secondAudioPath, audio tracks other than the
+     * video) are moved into the queue's storage first.
+     *
+     * @param config Export configuration.
+     * @param priority Higher runs first.
+     * @param held Queued on hold, e.g. until attachEncodedAudio() releases it.
+     * @return Job identifier, or an empty string if the takes could not be stored.
+     */
+    QString enqueue(const ExportConfig &config, int priority = 0, bool held = false);
+
+    /**
+     * @brief Gives a job that has not started its encoded soundtrack, and releases it.
+     *
+     * The file is moved into the job's storage. An empty @p encodedAudioPath
+     * only releases the job, which then mixes as usual.
+     */
+    void attachEncodedAudio(const QString &id, const QString &encodedAudioPath);
+
+    /**
+     * @brief Holds a queued job, or releases a held one.
+     *
+     * Running jobs are not interrupted.
+     */
+    void setJobHeld(const QString &id, bool held);
+
+    /**
+     * @brief Changes the priority of a job that has not started yet.
+     */
+    void setJobPriority(const QString &id, int priority);
+
+    /**
+     * @brief Cancels a queued or running job.
+     */
+    void cancelJob(const QString &id);
+
+    /**
+     * @brief Forgets finished jobs and deletes their stored takes.
+     */
+    void clearFinished();
+
+    /**
+     * @brief Returns every job in scheduling order.
+     */
+    QList<ExportJob> jobs() const;
+
+    /**
+     * @brief Returns the job @p id (an empty id if there is none).
+     */
+    ExportJob job(const QString &id) const;
+
+    // =========================================================================
+    // Scheduler
+    // =========================================================================
+
+    /**
+     * @brief Pauses the queue: running jobs finish, no new job starts.
+     */
+    void setPaused(bool paused);
+    bool isPaused() const;
+
+    /**
+     * @brief Sets how many exports run at once (each may use several encoders).
+     */
+    void setMaxConcurrentJobs(int count);
+    int maxConcurrentJobs() const;
+
+    /**
+     * @brief Default concurrency: the cores split between jobs' encoder pools.
+     */
+    static int defaultConcurrentJobs();
+
+    /**
+     * @brief Returns true while a job is queued or running.
+     */
+    bool isBusy() const;
+
+signals:
+    /** @brief A job was added, started, progressed or changed state. */
+    void jobChanged(const QString &id);
+
+    /** @brief A job ended. */
+    void jobFinished(const QString &id, bool success, const QString &message);
+
+    /** @brief A finished job was cleared from the queue. */
+    void jobRemoved(const QString &id);
+
+    /**
+     * @brief Progress of the current batch (jobs since the queue was last idle).
+     * @param percentage Progress from 0 to 100.
+     */
+    void overallProgressChanged(int percentage);
+
+private:
+    /**
+     * @brief Starts the best queued jobs while slots are free.
+     */
+    void schedule();
+
+    /**
+     * @brief Returns an idle ExportService, creating one if the pool allows.
+     */
+    ExportService *idleService();
+
+    void onJobProgress(ExportService *service, int percentage);
+    void onJobFinished(ExportService *service, bool success, const QString &message);
+
+    ExportJob *findJob(const QString &id);
+    void updateOverallProgress();
+
+    /**
+     * @brief Writes the queue to disk (atomic).
+     */
+    void save() const;
+    void load();
+
+    /**
+     * @brief Moves the takes of @p config into @p directory and rewrites its paths.
+     */
+    static bool adoptTakes(ExportConfig &config, const QString &directory);
+    static QString storageRoot();
+
+    QList<ExportJob> m_jobs;
+    QList<ExportService *> m_services;
+    QHash<ExportService *, QString> m_serviceJobs;  ///< Busy service -> job id
+    QList<QString> m_batch;                         ///< Jobs counted by the overall progress
+    int m_maxConcurrentJobs;
+    bool m_paused;
+};
+
+#endif // EXPORTQUEUE_H
@@ -4,22 +4,157 @@
  */
 
 #include "ExportService.h"
+#include "AudioMixer.h"
+#include "ExportCache.h"
+#include "FrameStreamer.h"
+#include "MediaProbe.h"
+#include "MediaSource.h"
+#include "ToolCapabilities.h"
 
 #include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
 #include <QRegularExpression>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <cmath>
+#include <filesystem>
+#include <system_error>
+
+namespace {
+
+// Half a millisecond: keeps cut points on the right side of a keyframe
+// despite the rounding of timestamps printed by ffprobe.
+constexpr double CUT_EPSILON_S = 0.0005;
+
+// Cut points closer than this to a keyframe are considered aligned.
+constexpr double KEYFRAME_TOLERANCE_S = 0.001;
+
+// Shorter segments cost more in encoder start-up than they save.
+constexpr qint64 MIN_PARALLEL_SEGMENT_MS = 10000;
+
+const QString CANCELLED_MESSAGE = QStringLiteral("Export annulé par l'utilisateur.");
+
+// Re-encodes longer than two of these are segmented even on one worker:
+// an interrupted export then loses at most one segment of work.
+constexpr qint64 RESUME_SEGMENT_MS = 60000;
+
+const QString MANIFEST_NAME = QStringLiteral("manifest.txt");
+
+QString seconds(double value)
+{
+    return QString::number(value, 'f', 6);
+}
+
+QStringList segmentEncoderArgs()
+{
+    return QStringList()
+        << "-c:v" << "libx264"
+        << "-preset" << "superfast"
+        << "-crf" << "18"
+        << "-pix_fmt" << "yuv420p";
+}
+
+/**
+ * libx264 profile producing the same stream parameters as @p info, or an
+ * empty string. Only 8-bit 4:2:0 profiles: High 10, 4:2:2 and 4:4:4 cannot
+ * be re-encoded to match.
+ */
+QString matchingX264Profile(const MediaInfo &info)
+{
+    static const QHash<QString, QString> profiles = {
+        { "Constrained Baseline", "baseline" },
+        { "Baseline", "baseline" },
+        { "Main", "main" },
+        { "High", "high" },
+    };
+    return profiles.value(info.profile);
+}
+
+/**
+ * Head and tail encoder settings for a smart render: those of every
+ * segment, pinned to the source's profile and level so the joined stream
+ * has a single set of parameters.
+ */
+QStringList smartRenderEncoderArgs(const MediaInfo &info)
+{
+    return segmentEncoderArgs()
+        << "-profile:v" << matchingX264Profile(info)
+        << "-level:v" << QString::number(info.level / 10.0, 'f', 1);
+}
+
+/**
+ * Moves @p from over @p to in one step (replacing it), unlike QFile::rename
+ * which refuses an existing target.
+ */
+bool replaceFile(const QString &from, const QString &to)
+{
+    std::error_code error;
+    std::filesystem::rename(std::filesystem::u8path(from.toStdString()),
+                            std::filesystem::u8path(to.toStdString()), error);
+    if (error) {
+        qWarning() << "[ExportService] Cannot rename" << from << "to" << to
+                   << QString::fromStdString(error.message());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Moves a finished delivery into place: a file in one rename, a partial
+ * directory (image sequence) one image at a time, then the directory goes.
+ */
+bool publishDelivery(const QString &partial, const QString &target)
+{
+    if (!QFileInfo(partial).isDir()) {
+        return replaceFile(partial, target);
+    }
+    QDir dir(partial);
+    for (const QString &name : dir.entryList(QDir::Files, QDir::Name)) {
+        if (!replaceFile(dir.filePath(name), QDir(target).filePath(name))) {
+            return false;
+        }
+    }
+    return dir.removeRecursively();
+}
+
+/**
+ * Deletes a delivery that won't be completed (file or partial directory).
+ */
+void discardDelivery(const QString &partial)
+{
+    if (QFileInfo(partial).isDir()) {
+        QDir(partial).removeRecursively();
+    } else {
+        QFile::remove(partial);
+    }
+}
+
+
+} // namespace
 
 ExportService::ExportService(QObject *parent)
     : QObject(parent)
-    , m_process(new QProcess(this))
+    , m_planWatcher(new QFutureWatcher<ExportPlan>(this))
+    , m_nextStep(0)
+    , m_maxWorkers(1)
+    , m_completedMs(0)
     , m_totalDurationMs(0)
+    , m_overlayFrameRate(0.0)
+    , m_planning(false)
 {
-    connect(m_process, &QProcess::finished,
-            this, &ExportService::handleProcessFinished);
-    connect(m_process, &QProcess::errorOccurred,
-            this, &ExportService::handleProcessError);
-    connect(m_process, &QProcess::readyReadStandardError,
-            this, &ExportService::parseProgressOutput);
+    connect(m_planWatcher, &QFutureWatcher<ExportPlan>::finished, this, [this]() {
+        if (!m_planning) {
+            return; // Cancelled while probing
+        }
+        m_planning = false;
+        runPlan(m_planWatcher->result());
+    });
 }
 
 // =============================================================================
@@ -28,15 +163,18 @@ ExportService::ExportService(QObject *parent)
 
 bool ExportService::isFFmpegAvailable() const
 {
-    QProcess check;
-    check.start("ffmpeg", QStringList() << "-version");
-    check.waitForFinished(3000);
-    return (check.exitCode() == 0);
+    return ToolCapabilities::ffmpeg().available;
+}
+
+bool ExportService::isLanguageCode(const QString &code)
+{
+    static const QRegularExpression pattern("^[a-z]{3}$");
+    return pattern.match(code).hasMatch();
 }
 
 bool ExportService::isExporting() const
 {
-    return m_process->state() != QProcess::NotRunning;
+    return m_planning || !m_steps.isEmpty();
 }
 
 void ExportService::startExport(const ExportConfig &config)
@@ -46,72 +184,151 @@ void ExportService::startExport(const ExportConfig &config)
         emit exportFinished(false, "Un export est déjà en cours.");
         return;
     }
-    
+
     // Validate configuration
     QString errorMessage;
     if (!validateConfig(config, errorMessage)) {
         emit exportFinished(false, errorMessage);
         return;
     }
-    
-    m_totalDurationMs = config.durationMs;
+
+    emit progressChanged(0);
+
+    // On the cache volume: finished intermediates are filed by a rename.
+    // The same export (output, inputs, settings) always gets the same
+    // directory, so what an interrupted run completed there is picked up
+    // again.
+    m_workDir = workDirFor(config);
+    if (!QDir().mkpath(m_workDir)) {
+        m_workDir.clear();
+        emit exportFinished(false, "Erreur: Impossible de créer le dossier temporaire.");
+        return;
+    }
+
+    // Mixing and keyframe probing block on I/O and ffprobe: keep them
+    // off the GUI thread
+    m_planning = true;
+    m_planCancel = std::make_shared<std::atomic<bool>>(false);
+    QString workDir = m_workDir;
+    std::shared_ptr<std::atomic<bool>> cancel = m_planCancel;
+    m_planWatcher->setFuture(QtConcurrent::run([config, workDir, cancel]() {
+        return planExport(config, workDir, cancel.get());
+    }));
+}
+
+void ExportService::startRythmoExport(const RythmoExportConfig &config)
+{
+    if (isExporting()) {
+        emit exportFinished(false, "Un export est déjà en cours.");
+        return;
+    }
+
+    if (!MediaSource::exists(config.videoPath)) {
+        emit exportFinished(false, "Erreur: Le fichier vidéo source est introuvable.");
+        return;
+    }
+    if (config.tracks.isEmpty()) {
+        emit exportFinished(false, "Erreur: Aucune piste rythmo à exporter.");
+        return;
+    }
+    if (config.outputPath.isEmpty()) {
+        emit exportFinished(false, "Erreur: Chemin de sortie non spécifié.");
+        return;
+    }
+
     emit progressChanged(0);
-    
-    QStringList args = buildFFmpegArgs(config);
-    
-    qDebug() << "[ExportService] Starting FFmpeg with args:" << args;
-    m_process->start("ffmpeg", args);
+
+    // Frame rate and geometry come from ffprobe: keep it off the GUI thread
+    m_planning = true;
+    m_planCancel = std::make_shared<std::atomic<bool>>(false);
+    std::shared_ptr<std::atomic<bool>> cancel = m_planCancel;
+    m_planWatcher->setFuture(QtConcurrent::run([config, cancel]() {
+        return planRythmoExport(config, cancel.get());
+    }));
 }
 
 void ExportService::cancelExport()
 {
     if (isExporting()) {
-        m_process->kill();
-        emit exportFinished(false, "Export annulé par l'utilisateur.");
+        if (m_planning) {
+            *m_planCancel = true;   // The planner stops writing to the work dir
+        }
+        m_planning = false;
+        killRunningProcesses();
+        finishExport(false, CANCELLED_MESSAGE);
     }
 }
 
 // =============================================================================
-// Private Slots
+// Process Handling
 // =============================================================================
 
-void ExportService::handleProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+void ExportService::handleProcessFinished(QProcess *process, int exitCode,
+                                          QProcess::ExitStatus exitStatus)
 {
+    if (!m_running.contains(process)) {
+        return; // Cancelled or already reported
+    }
+
+    int stepIndex = m_running.take(process);
+    m_runningMs.remove(process);
+    process->deleteLater();
+
     if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+        recordCompletedStep(m_steps[stepIndex]);
+        m_completedMs += qMax<qint64>(0, m_steps[stepIndex].spanMs);
+        if (m_nextStep < m_steps.size() || !m_running.isEmpty()) {
+            launchPendingSteps();
+            return;
+        }
         emit progressChanged(100);
-        emit exportFinished(true, "Export réussi !");
+        finishExport(true, "Export réussi !");
     } else {
-        QString error = m_process->readAllStandardError();
-        emit exportFinished(false, "Échec de l'export: " + error);
+        QString error = process->readAllStandardError();
+        killRunningProcesses();
+        finishExport(false, "Échec de l'export: " + error);
     }
 }
 
-void ExportService::handleProcessError(QProcess::ProcessError error)
+void ExportService::handleProcessError(QProcess *process, QProcess::ProcessError error)
 {
+    if (!m_running.contains(process)) {
+        return; // Cancelled or already reported
+    }
+
     if (error == QProcess::FailedToStart) {
-        emit exportFinished(false, "FFmpeg n'a pas pu démarrer. Est-il installé ?");
-    } else {
-        emit exportFinished(false, "Erreur lors de l'exécution de FFmpeg.");
+        m_running.remove(process);
+        process->deleteLater();
+        killRunningProcesses();
+        finishExport(false, "FFmpeg n'a pas pu démarrer. Est-il installé ?");
+    } else if (error != QProcess::Crashed && error != QProcess::WriteError) {
+        // Crashes are reported through handleProcessFinished. FFmpeg stops
+        // reading the overlay pipe once it reached -t, so write errors are
+        // expected too: its exit code tells whether the step succeeded.
+        m_running.remove(process);
+        process->deleteLater();
+        killRunningProcesses();
+        finishExport(false, "Erreur lors de l'exécution de FFmpeg.");
     }
 }
 
-void ExportService::parseProgressOutput()
+void ExportService::parseProgressOutput(QProcess *process)
 {
     if (m_totalDurationMs <= 0) {
         return;
     }
-    
-    QString output = m_process->readAllStandardError();
+
+    QString output = process->readAllStandardError();
     qDebug() << "[FFmpeg]" << output;
-    
+
     // Parse time from FFmpeg output
     // Formats: time=00:00:00.00 or time=123.45
     static QRegularExpression reHMS("time=(\\d+):(\\d+):(\\d+)\\.(\\d+)");
     static QRegularExpression reSec("time=(\\d+)\\.(\\d+)");
-    
+
     QRegularExpressionMatch match = reHMS.match(output);
     qint64 currentTimeMs = 0;
-    
+
     if (match.hasMatch()) {
         int hours = match.captured(1).toInt();
         int mins = match.captured(2).toInt();
@@ -125,9 +342,15 @@ void ExportService::parseProgressOutput()
                            match.captured(2).toInt() * 10;
         }
     }
-    
+
     if (currentTimeMs > 0) {
-        int percentage = static_cast<int>((currentTimeMs * 100) / m_totalDurationMs);
+        // Aggregate finished steps and every running worker
+        m_runningMs[process] = currentTimeMs;
+        qint64 doneMs = m_completedMs;
+        for (qint64 runningMs : m_runningMs) {
+            doneMs += runningMs;
+        }
+        int percentage = static_cast<int>((doneMs * 100) / m_totalDurationMs);
         percentage = qBound(0, percentage, 100);
         emit progressChanged(percentage);
     }
@@ -137,96 +360,1086 @@ void ExportService::parseProgressOutput()
 // Private Methods
 // =============================================================================
 
+void ExportService::runPlan(const ExportPlan &plan)
+{
+    m_steps = plan.steps;
+    m_maxWorkers = qMax(1, plan.workers);
+    m_overlay = plan.overlay;
+    m_overlayFrameRate = plan.frameRate;
+    m_deliveries = plan.deliveries;
+    m_nextStep = 0;
+    m_completedMs = 0;
+    m_totalDurationMs = 0;
+    for (const ExportStep &step : m_steps) {
+        if (step.spanMs <= 0) {
+            m_totalDurationMs = 0; // Unknown length: no progress reporting
+            break;
+        }
+        m_totalDurationMs += step.spanMs;
+        if (step.done) {
+            m_completedMs += step.spanMs;   // Resumed: counts as progress already
+        }
+    }
+
+    if (m_steps.isEmpty()) {
+        finishExport(false, plan.error.isEmpty() ? QString("Échec de l'export: rien à exporter.")
+                                                 : plan.error);
+        return;
+    }
+
+    launchPendingSteps();
+}
+
+void ExportService::launchPendingSteps()
+{
+    while (m_nextStep < m_steps.size() && m_running.size() < m_maxWorkers) {
+        const ExportStep &step = m_steps[m_nextStep];
+        if (step.done) {
+            ++m_nextStep;
+            continue;
+        }
+
+        // A stage only starts once every step of the previous one succeeded
+        bool sameStage = true;
+        for (int runningIndex : m_running) {
+            if (m_steps[runningIndex].stage != step.stage) {
+                sameStage = false;
+                break;
+            }
+        }
+        if (!sameStage) {
+            return;
+        }
+
+        QProcess *process = new QProcess(this);
+        connect(process, &QProcess::finished, this,
+                [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+                    handleProcessFinished(process, exitCode, exitStatus);
+                });
+        connect(process, &QProcess::errorOccurred, this,
+                [this, process](QProcess::ProcessError error) {
+                    handleProcessError(process, error);
+                });
+        connect(process, &QProcess::readyReadStandardError, this,
+                [this, process]() { parseProgressOutput(process); });
+
+        if (step.overlayFrames > 0 && m_overlay) {
+            // Burn-in: render the bands of this step's frames into stdin
+            std::shared_ptr<const RythmoFrameRenderer> overlay = m_overlay;
+            double frameRate = m_overlayFrameRate;
+            qint64 firstFrame = step.overlayFirstFrame;
+            auto *streamer = new FrameStreamer(process, step.overlayFrames,
+                [overlay, frameRate, firstFrame](int index) {
+                    return overlay->renderFrame(
+                        qRound64((firstFrame + index) * 1000.0 / frameRate));
+                });
+            streamer->start();
+        }
+
+        m_running.insert(process, m_nextStep);
+        qDebug() << "[ExportService] Starting FFmpeg step" << (m_nextStep + 1)
+                 << "/" << m_steps.size() << "with args:" << step.args;
+        ++m_nextStep;
+        process->start("ffmpeg", step.args);
+    }
+}
+
+void ExportService::killRunningProcesses()
+{
+    const QList<QProcess *> processes = m_running.keys();
+    m_running.clear();
+    m_runningMs.clear();
+    for (QProcess *process : processes) {
+        process->kill();
+        process->deleteLater();
+    }
+}
+
+void ExportService::finishExport(bool success, const QString &message)
+{
+    QString result = message;
+    if (success) {
+        // Each delivery appears in one rename: never as a truncated file
+        for (auto it = m_deliveries.constBegin(); it != m_deliveries.constEnd(); ++it) {
+            if (!publishDelivery(it.key(), it.value())) {
+                success = false;
+                result = "Échec de l'export: impossible d'écrire " + it.value();
+                break;
+            }
+        }
+    }
+
+    if (success) {
+        // File the intermediates for later exports before the work dir goes
+        for (const ExportStep &step : m_steps) {
+            if (!step.cacheKind.isEmpty() && QFile::exists(step.outputFile)) {
+                ExportCache::insert(step.cacheKind, step.cacheKey,
+                                    QFileInfo(step.outputFile).suffix(), step.outputFile);
+            }
+        }
+        if (!m_workDir.isEmpty()) {
+            QDir(m_workDir).removeRecursively();
+        }
+    } else {
+        // The completed segments stay for a resume; half-written deliveries go
+        for (auto it = m_deliveries.constBegin(); it != m_deliveries.constEnd(); ++it) {
+            discardDelivery(it.key());
+        }
+    }
+    QThreadPool::globalInstance()->start([]() { ExportCache::evict(); });
+
+    m_steps.clear();
+    m_nextStep = 0;
+    m_overlay.reset();
+    m_workDir.clear();
+    m_deliveries.clear();
+    emit exportFinished(success, result);
+}
+
 bool ExportService::validateConfig(const ExportConfig &config, QString &errorMessage) const
 {
-    if (!QFile::exists(config.videoPath)) {
+    if (!MediaSource::exists(config.videoPath)) {
         errorMessage = "Erreur: Le fichier vidéo source est introuvable.";
         return false;
     }
-    
+
     if (!QFile::exists(config.audioPath)) {
         errorMessage = "Erreur: L'enregistrement de la Piste 1 est introuvable.";
         return false;
     }
-    
+
     if (!config.secondAudioPath.isEmpty() && !QFile::exists(config.secondAudioPath)) {
         errorMessage = "Erreur: L'enregistrement de la Piste 2 est introuvable.";
         return false;
     }
-    
+
     if (config.outputPath.isEmpty()) {
         errorMessage = "Erreur: Chemin de sortie non spécifié.";
         return false;
     }
-    
+
+    if (!config.audioTracks.isEmpty() && !config.additionalOutputs.isEmpty()) {
+        errorMessage = "Erreur: L'export multipiste ne produit qu'un seul fichier.";
+        return false;
+    }
+
+    for (const ExportAudioTrack &track : config.audioTracks) {
+        if (!QFile::exists(track.audioPath)) {
+            errorMessage = "Erreur: Une piste audio à exporter est introuvable.";
+            return false;
+        }
+        if (!isLanguageCode(track.language)) {
+            errorMessage = QString("Erreur: Code langue invalide : \"%1\" "
+                                   "(ISO 639-2 attendu, ex. fra).").arg(track.language);
+            return false;
+        }
+    }
+
+    for (const ExportOutput &output : config.additionalOutputs) {
+        if (output.outputPath.isEmpty() || output.outputPath == config.outputPath) {
+            errorMessage = "Erreur: Chaque sortie doit avoir son propre fichier.";
+            return false;
+        }
+    }
+
     return true;
 }
 
-QStringList ExportService::buildFFmpegArgs(const ExportConfig &config) const
+QString ExportService::buildAudioFilter(const ExportConfig &config,
+                                        int originalInput, int firstTakeInput)
 {
-    QStringList args;
-    
-    // Overwrite output, use all threads
-    args << "-y";
-    args << "-threads" << "0";
-    
-    // Input seeking (fast seek)
-    if (config.startTimeMs > 0) {
-        args << "-ss" << QString::number(config.startTimeMs / 1000.0, 'f', 3);
-    }
-    
-    // Input files
-    args << "-i" << config.videoPath;   // [0]
-    args << "-i" << config.audioPath;   // [1]
-    
-    bool hasSecondTrack = !config.secondAudioPath.isEmpty();
-    if (hasSecondTrack) {
-        args << "-i" << config.secondAudioPath;  // [2]
-    }
-    
-    // Video encoding: High quality H.264
-    args << "-c:v" << "libx264";
-    args << "-preset" << "superfast";
-    args << "-crf" << "18";
-    args << "-pix_fmt" << "yuv420p";
-    
-    // Build audio filter complex
     QString filterComplex;
     bool includeOriginal = (config.originalVolume >= 0.01f);
-    
+    bool hasSecondTrack = !config.secondAudioPath.isEmpty();
+
     if (includeOriginal) {
-        filterComplex += QString("[0:a]volume=%1[a0];").arg(config.originalVolume);
+        filterComplex += QString("[%1:a]volume=%2[a0];")
+                             .arg(originalInput).arg(config.originalVolume);
     }
-    
-    filterComplex += "[1:a]volume=1.0[a1];";
-    
+
+    filterComplex += QString("[%1:a]volume=%2[a1];")
+                         .arg(firstTakeInput).arg(config.audioGain);
+
     if (hasSecondTrack) {
-        filterComplex += "[2:a]volume=1.0[a2];";
+        filterComplex += QString("[%1:a]volume=%2[a2];")
+                             .arg(firstTakeInput + 1).arg(config.secondAudioGain);
     }
-    
+
     // AMIX: combine all audio streams
     QString inputsStr;
     if (includeOriginal) inputsStr += "[a0]";
     inputsStr += "[a1]";
     if (hasSecondTrack) inputsStr += "[a2]";
-    
+
     int amixInputs = (includeOriginal ? 1 : 0) + 1 + (hasSecondTrack ? 1 : 0);
     filterComplex += inputsStr + QString("amix=inputs=%1:duration=longest[aout]").arg(amixInputs);
-    
-    args << "-filter_complex" << filterComplex;
+
+    return filterComplex;
+}
+
+void ExportService::appendOutputArgs(const ExportConfig &config, QStringList &args,
+                                     int originalInput, int firstAudioInput,
+                                     const QStringList &outputOptions)
+{
+    if (!config.audioTracks.isEmpty()) {
+        // One output, one tagged audio stream per language track; the first
+        // one plays by default
+        for (const QString &track : config.premixedAudioPaths) {
+            args << "-i" << track;
+        }
+        args << "-map" << "0:v:0";
+        for (int i = 0; i < config.audioTracks.size(); ++i) {
+            const ExportAudioTrack &track = config.audioTracks[i];
+            args << "-map" << QString("%1:a:0").arg(firstAudioInput + i);
+            if (!track.language.isEmpty()) {
+                args << QString("-metadata:s:a:%1").arg(i) << "language=" + track.language;
+            }
+            if (!track.title.isEmpty()) {
+                args << QString("-metadata:s:a:%1").arg(i) << "title=" + track.title;
+            }
+            args << QString("-disposition:a:%1").arg(i) << (i == 0 ? "default" : "0");
+        }
+        if (config.premixedAudioEncoded) {
+            args << "-c:a" << "copy";
+        } else {
+            args << "-c:a" << "aac";
+            args << "-b:a" << "192k";
+        }
+        args << outputOptions;
+        args << config.outputPath;
+        return;
+    }
+
+    if (!config.premixedAudioPaths.isEmpty()) {
+        // Already mixed: FFmpeg only encodes each mix and fans the shared
+        // video out to every output
+        QStringList outputPaths;
+        outputPaths << config.outputPath;
+        for (const ExportOutput &output : config.additionalOutputs) {
+            outputPaths << output.outputPath;
+        }
+        for (const QString &mix : config.premixedAudioPaths) {
+            args << "-i" << mix;
+        }
+        for (int i = 0; i < outputPaths.size(); ++i) {
+            args << "-map" << "0:v:0";
+            args << "-map" << QString("%1:a:0").arg(firstAudioInput + i);
+            if (config.premixedAudioEncoded) {
+                args << "-c:a" << "copy";
+            } else {
+                args << "-c:a" << "aac";
+                args << "-b:a" << "192k";
+            }
+            args << outputOptions;
+            args << outputPaths[i];
+        }
+        return;
+    }
+
+    args << "-i" << config.audioPath;
+    if (!config.secondAudioPath.isEmpty()) {
+        args << "-i" << config.secondAudioPath;
+    }
+    args << "-filter_complex" << buildAudioFilter(config, originalInput, firstAudioInput);
     args << "-map" << "0:v:0";
     args << "-map" << "[aout]";
     args << "-c:a" << "aac";
     args << "-b:a" << "192k";
-    
+    args << outputOptions;
+    args << config.outputPath;
+}
+
+QStringList ExportService::buildFFmpegArgs(const ExportConfig &config)
+{
+    QStringList args;
+
+    // Overwrite output, use all threads
+    args << "-y";
+    args << "-threads" << "0";
+
+    // Input seeking (fast seek)
+    if (config.startTimeMs > 0) {
+        args << "-ss" << QString::number(config.startTimeMs / 1000.0, 'f', 3);
+    }
+
+    // Input files: video [0], then the mix or the takes [1..]
+    args << "-i" << config.videoPath;
+
+    // Video encoding: High quality H.264
+    QStringList outputOptions = segmentEncoderArgs();
+
     // Duration limit
     if (config.durationMs > 0) {
-        args << "-t" << QString::number(config.durationMs / 1000.0, 'f', 3);
+        outputOptions << "-t" << QString::number(config.durationMs / 1000.0, 'f', 3);
     } else {
-        args << "-shortest";
+        outputOptions << "-shortest";
     }
-    
-    args << config.outputPath;
-    
+
+    appendOutputArgs(config, args, 0, 1, outputOptions);
+
     return args;
 }
+
+int ExportService::resolveWorkerCount(const ExportConfig &config)
+{
+    if (config.videoMode == ExportConfig::ReEncode) {
+        return 1;
+    }
+    if (config.encodeWorkers > 0) {
+        return config.encodeWorkers;
+    }
+    // libx264 scales well up to ~4 threads per instance: size the pool so
+    // each worker gets about that many cores.
+    return qBound(1, QThread::idealThreadCount() / 4, 8);
+}
+
+ExportService::ExportStep ExportService::buildConcatStep(const ExportConfig &config,
+                                                         const QString &workDir,
+                                                         const QStringList &segments,
+                                                         qint64 durationMs)
+{
+    QDir dir(workDir);
+    QFile list(dir.filePath("segments.txt"));
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return ExportStep{ QStringList(), 0, 1 };
+    }
+    QTextStream out(&list);
+    for (const QString &segment : segments) {
+        out << "file '" << segment << "'\n";
+    }
+    list.close();
+
+    // Join the video segments losslessly and mux the new mix
+    QStringList args;
+    args << "-y";
+    args << "-f" << "concat" << "-safe" << "0";
+    args << "-i" << list.fileName();            // [0] joined video
+
+    QStringList outputOptions;
+    outputOptions << "-c:v" << "copy";
+    outputOptions << "-t" << QString::number(durationMs / 1000.0, 'f', 3);
+
+    if (config.premixedAudioPaths.isEmpty()) {
+        args << "-ss" << seconds(config.startTimeMs / 1000.0);
+        args << "-i" << config.videoPath;       // [1] original audio
+        appendOutputArgs(config, args, 1, 2, outputOptions);
+    } else {
+        appendOutputArgs(config, args, -1, 1, outputOptions);
+    }
+
+    return ExportStep{ args, durationMs, 1 };
+}
+
+ExportService::ExportPlan ExportService::planExport(const ExportConfig &config,
+                                                    const QString &workDir,
+                                                    const std::atomic<bool> *cancelled)
+{
+    ExportConfig mixed = config;
+    ExportPlan audio;
+
+    // Deliveries are written under a temporary name and renamed once complete
+    QHash<QString, QString> deliveries;
+    mixed.outputPath = partialPath(config.outputPath);
+    deliveries.insert(mixed.outputPath, config.outputPath);
+    for (ExportOutput &output : mixed.additionalOutputs) {
+        QString partial = partialPath(output.outputPath);
+        deliveries.insert(partial, output.outputPath);
+        output.outputPath = partial;
+    }
+
+    if (!config.encodedAudioPath.isEmpty() && config.additionalOutputs.isEmpty()
+        && config.audioTracks.isEmpty()) {
+        // Mixed and encoded while recording: only the mux is left
+        mixed.premixedAudioPaths = QStringList() << config.encodedAudioPath;
+        mixed.premixedAudioEncoded = true;
+    } else {
+        mixed.encodedAudioPath.clear();
+        mixed.premixedAudioPaths = premixAudio(config, cancelled);
+        if (cancelled && *cancelled) {
+            ExportPlan stopped;
+            stopped.error = CANCELLED_MESSAGE;
+            return stopped;
+        }
+        if (mixed.premixedAudioPaths.isEmpty()
+            && (!config.additionalOutputs.isEmpty() || !config.audioTracks.isEmpty())) {
+            // The amix fallback can only feed one mixed-down output
+            ExportPlan failed;
+            failed.error = "Échec de l'export: le mixage audio a échoué.";
+            return failed;
+        }
+        if (!mixed.premixedAudioPaths.isEmpty()) {
+            planAudioEncode(mixed, audio, workDir);
+        }
+    }
+
+    // Burned-in bands change every frame, so they always re-encode
+    ExportPlan plan = (mixed.videoMode == ExportConfig::SmartRender && mixed.burnInTracks.isEmpty())
+                          ? planSmartRender(mixed, workDir)
+                          : planParallelReEncode(mixed, workDir);
+    if (cancelled && *cancelled) {
+        ExportPlan stopped;
+        stopped.error = CANCELLED_MESSAGE;
+        return stopped;
+    }
+    if (plan.steps.isEmpty()) {
+        return plan;
+    }
+
+    if (!audio.steps.isEmpty()) {
+        // The audio encodes must be done before the final mux: they share the
+        // stage of the video segments, or get one of their own before it
+        if (plan.steps.last().stage == 0) {
+            for (ExportStep &step : plan.steps) {
+                ++step.stage;
+            }
+        } else {
+            plan.workers += audio.steps.size();
+        }
+        plan.steps = audio.steps + plan.steps;
+    }
+
+    plan.deliveries = deliveries;
+    applyManifest(plan, workDir, config);
+    return plan;
+}
+
+QString ExportService::workDirFor(const ExportConfig &config)
+{
+    // Everything the plan is built from: another take, range or setting
+    // for the same output is another export, with its own directory
+    QStringList parts;
+    parts << QFileInfo(config.outputPath).absoluteFilePath()
+          << config.videoPath << config.audioPath << config.secondAudioPath
+          << config.encodedAudioPath
+          << QString::number(config.startTimeMs) << QString::number(config.durationMs)
+          << QString::number(config.originalVolume, 'g', 9)
+          << QString::number(config.audioGain, 'g', 9)
+          << QString::number(config.secondAudioGain, 'g', 9)
+          << QString::number(config.audioLimiter) << QString::number(config.audioDither)
+          << QString::number(config.videoMode) << QString::number(config.encodeWorkers)
+          << QString::number(config.rythmoSpeed);
+    for (const RythmoBandTrack &track : config.burnInTracks) {
+        parts << track.text << track.style.font.toString()
+              << track.style.textColor.name(QColor::HexArgb)
+              << track.style.backgroundColor.name(QColor::HexArgb)
+              << QString::number(track.style.globalSize);
+    }
+    for (const ExportOutput &output : config.additionalOutputs) {
+        parts << QFileInfo(output.outputPath).absoluteFilePath()
+              << QString::number(output.originalVolume, 'g', 9)
+              << QString::number(output.audioGain, 'g', 9)
+              << QString::number(output.secondAudioGain, 'g', 9);
+    }
+    for (const ExportAudioTrack &track : config.audioTracks) {
+        parts << track.audioPath << QString::number(track.startMs)
+              << QString::number(track.gain, 'g', 9) << track.language << track.title;
+    }
+    return QDir(ExportCache::workDirectory()).filePath("export-" + ExportCache::key(parts));
+}
+
+QString ExportService::partialPath(const QString &outputPath)
+{
+    // Same directory, so the final rename stays on one volume; same
+    // extension, which FFmpeg picks the container from
+    QFileInfo info(outputPath);
+    QString name = info.completeBaseName() + ".partial";
+    if (!info.suffix().isEmpty()) {
+        name += '.' + info.suffix();
+    }
+    return info.dir().filePath(name);
+}
+
+void ExportService::applyManifest(ExportPlan &plan, const QString &workDir,
+                                  const ExportConfig &config)
+{
+    // Commands name the source by path: its content is part of the identity
+    const QString videoId = ExportCache::fingerprint(config.videoPath);
+    if (videoId.isEmpty()) {
+        return;
+    }
+
+    // The whole plan: every command, the content of its inputs, and what
+    // command lines do not show (cache keys carry the burned-in text)
+    QStringList planParts;
+    planParts << videoId;
+    for (const QString &take : { config.audioPath, config.secondAudioPath }) {
+        if (!take.isEmpty()) {
+            planParts << ExportCache::fingerprint(take);
+        }
+    }
+    for (const ExportStep &step : plan.steps) {
+        planParts << step.cacheKey << step.args;
+    }
+    const QString planHash = ExportCache::key(planParts);
+
+    // "plan <hash>", then one "<key> <size>" line per completed step; a
+    // line torn by a crash does not parse or does not match, and that step
+    // runs again
+    QString manifestPlan;
+    QHash<QString, qint64> completed;
+    QFile manifest(QDir(workDir).filePath(MANIFEST_NAME));
+    if (manifest.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!manifest.atEnd()) {
+            QStringList fields = QString::fromUtf8(manifest.readLine()).trimmed().split(' ');
+            if (fields.size() == 2 && fields[0] == "plan") {
+                manifestPlan = fields[1];
+                continue;
+            }
+            bool ok = false;
+            qint64 size = (fields.size() == 2) ? fields[1].toLongLong(&ok) : -1;
+            if (ok) {
+                completed.insert(fields[0], size);
+            }
+        }
+        manifest.close();
+    }
+
+    // Written for another plan (or before plans were recorded): nothing
+    // in it is trusted, the manifest starts over
+    if (manifestPlan != planHash) {
+        if (!completed.isEmpty()) {
+            qDebug() << "[ExportService] Plan changed in" << workDir << "- not resuming";
+        }
+        completed.clear();
+        if (manifest.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            manifest.write(QString("plan %1\n").arg(planHash).toUtf8());
+        }
+    }
+
+    int skipped = 0;
+    for (ExportStep &step : plan.steps) {
+        if (step.outputFile.isEmpty()) {
+            continue;   // Final pass: writes the deliveries
+        }
+        // The cache key carries what the command line does not, such as
+        // the text of burned-in bands piped to stdin
+        step.resumeKey = ExportCache::key(QStringList() << videoId << step.cacheKey << step.args);
+        QFileInfo output(step.outputFile);
+        auto it = completed.constFind(step.resumeKey);
+        if (it != completed.constEnd() && output.isFile() && output.size() == it.value()) {
+            step.done = true;
+            ++skipped;
+        }
+    }
+    if (skipped > 0) {
+        qDebug() << "[ExportService] Resuming" << workDir << "-" << skipped << "of"
+                 << plan.steps.size() << "steps already complete";
+    }
+}
+
+void ExportService::recordCompletedStep(const ExportStep &step)
+{
+    if (step.resumeKey.isEmpty() || m_workDir.isEmpty()) {
+        return;
+    }
+    QFile manifest(QDir(m_workDir).filePath(MANIFEST_NAME));
+    if (manifest.open(QIODevice::Append | QIODevice::Text)) {
+        manifest.write(QString("%1 %2\n").arg(step.resumeKey)
+                           .arg(QFileInfo(step.outputFile).size()).toUtf8());
+    }
+}
+
+QString ExportService::reuseOrProduce(ExportPlan &plan, ExportStep step, const QString &kind,
+                                      const QString &key, const QString &outputFile)
+{
+    if (!key.isEmpty()) {
+        QString cached = ExportCache::lookup(kind, key, QFileInfo(outputFile).suffix());
+        if (!cached.isEmpty()) {
+            return cached;
+        }
+        step.cacheKind = kind;
+        step.cacheKey = key;
+    }
+    step.outputFile = outputFile;
+    plan.steps.append(step);
+    return outputFile;
+}
+
+void ExportService::planAudioEncode(ExportConfig &config, ExportPlan &plan,
+                                    const QString &workDir)
+{
+    qint64 durationMs = config.durationMs;
+    if (durationMs <= 0) {
+        durationMs = MediaProbe::probe(config.videoPath).durationMs - config.startTimeMs;
+    }
+
+    QDir dir(workDir);
+    QStringList encoded;
+    for (int i = 0; i < config.premixedAudioPaths.size(); ++i) {
+        const QString &mix = config.premixedAudioPaths[i];
+        QString output = dir.filePath(QString("audio_%1.m4a").arg(i));
+
+        ExportStep step;
+        step.spanMs = durationMs;
+        step.args << "-y";
+        step.args << "-i" << mix;
+        step.args << "-map" << "0:a:0";
+        step.args << "-c:a" << "aac";
+        step.args << "-b:a" << "192k";
+        step.args << output;
+
+        // A premix is named after the hash of everything it contains
+        QString key = ExportCache::key(QStringList() << "aac" << "192k"
+                                                     << QFileInfo(mix).completeBaseName());
+        encoded << reuseOrProduce(plan, step, "audio", key, output);
+    }
+
+    config.premixedAudioPaths = encoded;
+    config.premixedAudioEncoded = true;
+}
+
+QStringList ExportService::premixAudio(const ExportConfig &config,
+                                       const std::atomic<bool> *cancelled)
+{
+    qint64 durationMs = config.durationMs;
+    if (durationMs <= 0) {
+        durationMs = MediaProbe::probe(config.videoPath).durationMs - config.startTimeMs;
+    }
+    if (durationMs <= 0) {
+        return QStringList();
+    }
+
+    const QString cacheDir = ExportCache::directory("premix");
+
+    if (!config.audioTracks.isEmpty()) {
+        // Language tracks are kept apart: each is cut and gained on its own
+        QList<MixSettings> tracks;
+        for (const ExportAudioTrack &track : config.audioTracks) {
+            MixSettings mix;
+            mix.inputs.append(MixInput{ track.audioPath, track.gain, track.startMs });
+            mix.durationMs = durationMs;
+            mix.limiter = config.audioLimiter;
+            mix.dither = config.audioDither;
+            tracks << mix;
+        }
+        return AudioMixer::cachedMixes(tracks, cacheDir, cancelled);
+    }
+
+    QList<ExportOutput> outputs;
+    outputs << ExportOutput{ config.outputPath, config.originalVolume,
+                             config.audioGain, config.secondAudioGain };
+    outputs << config.additionalOutputs;
+
+    // Takes start with the recording; the original audio at the start point.
+    // Every mix reads the same sources, so they are decoded once for all.
+    QList<MixSettings> mixes;
+    for (const ExportOutput &output : outputs) {
+        MixSettings mix;
+        if (output.originalVolume >= 0.01f) {
+            mix.inputs.append(MixInput{ config.videoPath, output.originalVolume, config.startTimeMs });
+        }
+        if (output.audioGain > 0.0f) {
+            mix.inputs.append(MixInput{ config.audioPath, output.audioGain, 0 });
+        }
+        if (!config.secondAudioPath.isEmpty() && output.secondAudioGain > 0.0f) {
+            mix.inputs.append(MixInput{ config.secondAudioPath, output.secondAudioGain, 0 });
+        }
+        if (mix.inputs.isEmpty()) {
+            // Silent delivery: still needs a soundtrack of the right length
+            mix.inputs.append(MixInput{ config.audioPath, 0.0f, 0 });
+        }
+        mix.durationMs = durationMs;
+        mix.limiter = config.audioLimiter;
+        mix.dither = config.audioDither;
+        mixes << mix;
+    }
+
+    return AudioMixer::cachedMixes(mixes, cacheDir, cancelled);
+}
+
+ExportService::ExportPlan ExportService::planSmartRender(const ExportConfig &config,
+                                                         const QString &workDir)
+{
+    // Segments are joined with the concat demuxer: the re-encoded head/tail
+    // must match the copied GOPs in codec, profile, level, pixel format and
+    // resolution: 8-bit 4:2:0 (limited range, as libx264 writes it) H.264
+    // of even size. The head and tail are not scaled.
+    MediaInfo info = MediaProbe::probe(config.videoPath);
+    if (!info.valid || info.videoCodec != "h264"
+        || info.pixelFormat != "yuv420p"
+        || matchingX264Profile(info).isEmpty() || info.level <= 0
+        || info.width <= 0 || info.height <= 0 || ((info.width | info.height) & 1)) {
+        qDebug() << "[ExportService] Smart render unavailable for" << info.videoCodec
+                 << info.profile << info.level << info.pixelFormat << info.width << "x"
+                 << info.height << "- re-encoding";
+        return planParallelReEncode(config, workDir);
+    }
+
+    qint64 endMs = (config.durationMs > 0) ? config.startTimeMs + config.durationMs
+                                           : info.durationMs;
+    if (endMs <= config.startTimeMs) {
+        return planParallelReEncode(config, workDir);
+    }
+
+    const double start = config.startTimeMs / 1000.0;
+    const double end = endMs / 1000.0;
+    const qint64 durationMs = endMs - config.startTimeMs;
+
+    // First keyframe at/after the start, last keyframe at/before the end
+    QList<double> keyframes = MediaProbe::keyframesNear(config.videoPath,
+                                                        config.startTimeMs, endMs);
+    double copyFrom = -1.0;
+    double copyTo = -1.0;
+    for (double kf : keyframes) {
+        if (kf >= start - KEYFRAME_TOLERANCE_S) {
+            copyFrom = kf;
+            break;
+        }
+    }
+    for (auto it = keyframes.crbegin(); it != keyframes.crend(); ++it) {
+        if (*it <= end + KEYFRAME_TOLERANCE_S) {
+            copyTo = qMin(*it, end);
+            break;
+        }
+    }
+
+    if (copyFrom < 0.0 || copyTo <= copyFrom) {
+        // No whole GOP inside the range: nothing to copy
+        return planParallelReEncode(config, workDir);
+    }
+
+    bool needHead = (copyFrom - start) > KEYFRAME_TOLERANCE_S;
+    bool needTail = (end - copyTo) > KEYFRAME_TOLERANCE_S;
+
+    // The copy must start on an IDR: after an open-GOP recovery point the
+    // leading frames reference the GOP before the cut. Same for the tail
+    // joined after the copied body.
+    if (!MediaProbe::isIdrKeyframe(config.videoPath, copyFrom)
+        || (needTail && !MediaProbe::isIdrKeyframe(config.videoPath, copyTo))) {
+        qDebug() << "[ExportService] Cut keyframes are not IDR (open GOP) - re-encoding";
+        return planParallelReEncode(config, workDir);
+    }
+
+    ExportPlan plan;
+
+    if (!needHead && !needTail) {
+        // Cut points sit on keyframes: a single stream-copy pass
+        QStringList args;
+        args << "-y";
+        args << "-ss" << seconds(copyFrom + CUT_EPSILON_S);
+        args << "-i" << config.videoPath;       // [0] video + original audio
+        QStringList outputOptions;
+        outputOptions << "-c:v" << "copy";
+        outputOptions << "-t" << QString::number(durationMs / 1000.0, 'f', 3);
+        appendOutputArgs(config, args, 0, 1, outputOptions);
+        plan.steps.append(ExportStep{ args, durationMs });
+        return plan;
+    }
+
+    // Head, body and tail are independent: produce them concurrently.
+    // Each is cached under the source content and its exact cut, so a
+    // re-export of the same range only joins them again.
+    QDir dir(workDir);
+    QStringList segments;
+    plan.workers = 3;
+    const QString videoId = ExportCache::fingerprint(config.videoPath);
+    auto segmentKey = [&videoId](const QStringList &parts) {
+        return videoId.isEmpty() ? QString() : ExportCache::key(QStringList() << videoId << parts);
+    };
+
+    if (needHead) {
+        QString output = dir.filePath("head.ts");
+        QStringList args;
+        args << "-y";
+        args << "-ss" << seconds(start);
+        args << "-i" << config.videoPath;
+        args << "-t" << seconds(copyFrom - start - CUT_EPSILON_S);
+        args << "-map" << "0:v:0" << "-an";
+        args << smartRenderEncoderArgs(info);
+        args << "-f" << "mpegts" << output;
+        QString key = segmentKey(QStringList() << "head" << seconds(start)
+                                               << seconds(copyFrom) << smartRenderEncoderArgs(info));
+        segments << reuseOrProduce(plan, ExportStep{ args, static_cast<qint64>((copyFrom - start) * 1000.0) },
+                                   "segments", key, output);
+    }
+
+    {
+        QString output = dir.filePath("body.ts");
+        QStringList args;
+        args << "-y";
+        args << "-ss" << seconds(copyFrom + CUT_EPSILON_S);
+        args << "-i" << config.videoPath;
+        args << "-t" << seconds(copyTo - copyFrom - 2 * CUT_EPSILON_S);
+        args << "-map" << "0:v:0" << "-an";
+        args << "-c:v" << "copy";
+        args << "-bsf:v" << "h264_mp4toannexb";
+        args << "-f" << "mpegts" << output;
+        QString key = segmentKey(QStringList() << "body" << seconds(copyFrom) << seconds(copyTo));
+        segments << reuseOrProduce(plan, ExportStep{ args, static_cast<qint64>((copyTo - copyFrom) * 1000.0) },
+                                   "segments", key, output);
+    }
+
+    if (needTail) {
+        QString output = dir.filePath("tail.ts");
+        QStringList args;
+        args << "-y";
+        args << "-ss" << seconds(copyTo - CUT_EPSILON_S);
+        args << "-i" << config.videoPath;
+        args << "-t" << seconds(end - copyTo + CUT_EPSILON_S);
+        args << "-map" << "0:v:0" << "-an";
+        args << smartRenderEncoderArgs(info);
+        args << "-f" << "mpegts" << output;
+        QString key = segmentKey(QStringList() << "tail" << seconds(copyTo)
+                                               << seconds(end) << smartRenderEncoderArgs(info));
+        segments << reuseOrProduce(plan, ExportStep{ args, static_cast<qint64>((end - copyTo) * 1000.0) },
+                                   "segments", key, output);
+    }
+
+    ExportStep concat = buildConcatStep(config, workDir, segments, durationMs);
+    if (concat.args.isEmpty()) {
+        return planParallelReEncode(config, workDir);
+    }
+    plan.steps.append(concat);
+    return plan;
+}
+
+ExportService::ExportPlan ExportService::planParallelReEncode(const ExportConfig &config,
+                                                              const QString &workDir)
+{
+    ExportPlan single;
+    single.steps.append(ExportStep{ buildFFmpegArgs(config), config.durationMs });
+
+    // Burn-in needs the segment path even with one worker: the overlay
+    // frames are piped into each segment encoder. So do several outputs:
+    // the picture is encoded once, then copied into each of them.
+    const bool burnIn = !config.burnInTracks.isEmpty();
+    const bool segmented = burnIn || !config.additionalOutputs.isEmpty();
+    int workers = resolveWorkerCount(config);
+    if (workers <= 1 && !segmented && config.durationMs > 0
+        && config.durationMs < 2 * RESUME_SEGMENT_MS) {
+        return single;  // Short: nothing worth resuming
+    }
+
+    MediaInfo info;
+    qint64 endMs = config.startTimeMs + config.durationMs;
+    if (burnIn || config.durationMs <= 0) {
+        info = MediaProbe::probe(config.videoPath);
+        if (config.durationMs <= 0) {
+            endMs = info.durationMs;
+        }
+    }
+    const qint64 durationMs = endMs - config.startTimeMs;
+    if (durationMs <= 0) {
+        return segmented ? ExportPlan() : single;
+    }
+    const bool resumable = durationMs >= 2 * RESUME_SEGMENT_MS;
+    if (workers <= 1 && !segmented && !resumable) {
+        return single;
+    }
+
+    std::shared_ptr<const RythmoFrameRenderer> overlay;
+    if (burnIn) {
+        if (!info.valid || info.frameRate <= 0) {
+            qWarning() << "[ExportService] Cannot burn the rythmo band into" << config.videoPath;
+            ExportPlan failed;
+            failed.error = "Échec de l'export: impossible de lire la cadence de la vidéo.";
+            return failed;
+        }
+        overlay = std::make_shared<const RythmoFrameRenderer>(
+            config.burnInTracks, config.rythmoSpeed, info.width, info.height);
+    }
+
+    const double start = config.startTimeMs / 1000.0;
+    const double end = endMs / 1000.0;
+    QList<double> boundaries;
+    boundaries << start;
+
+    if ((workers > 1 || resumable) && durationMs >= MIN_PARALLEL_SEGMENT_MS * 2) {
+        // Twice as many segments as workers smooths out uneven encode speeds,
+        // and none longer than RESUME_SEGMENT_MS bounds what a resume redoes.
+        // Boundaries snap to the nearest keyframe so no worker decodes frames
+        // it then throws away.
+        QList<double> keyframes = MediaProbe::keyframesInRange(config.videoPath,
+                                                               config.startTimeMs, endMs);
+        const double minLength = MIN_PARALLEL_SEGMENT_MS / 1000.0;
+        int wanted = qMax(workers * 2, static_cast<int>(durationMs / RESUME_SEGMENT_MS));
+        int segmentCount = qMax(1, qMin(wanted, static_cast<int>((end - start) / minLength)));
+        double targetLength = (end - start) / segmentCount;
+
+        for (int i = 1; i < segmentCount; ++i) {
+            double target = start + i * targetLength;
+            double boundary = target;
+            double bestDistance = targetLength / 2;
+            for (double kf : keyframes) {
+                if (qAbs(kf - target) < bestDistance) {
+                    bestDistance = qAbs(kf - target);
+                    boundary = kf;
+                }
+            }
+            if (boundary - boundaries.last() >= minLength && end - boundary >= minLength) {
+                boundaries << boundary;
+            }
+        }
+    }
+
+    if (boundaries.size() < 2 && !segmented) {
+        return single;
+    }
+
+    QDir dir(workDir);
+    QStringList segments;
+    ExportPlan plan;
+    plan.workers = workers;
+    plan.overlay = overlay;
+    plan.frameRate = info.frameRate;
+    int threadsPerWorker = qMax(1, QThread::idealThreadCount() / workers);
+
+    // Segments are cached under the source content, their range, the
+    // encoder settings and everything the burned-in bands are drawn from
+    const QString videoId = ExportCache::fingerprint(config.videoPath);
+    QStringList cacheParts;
+    cacheParts << videoId << segmentEncoderArgs();
+    if (overlay) {
+        cacheParts << QString::number(config.rythmoSpeed) << QString::number(info.width)
+                   << QString::number(info.height) << info.frameRateText;
+        for (const RythmoBandTrack &track : config.burnInTracks) {
+            cacheParts << track.text << track.style.font.toString()
+                       << track.style.textColor.name(QColor::HexArgb)
+                       << track.style.backgroundColor.name(QColor::HexArgb)
+                       << QString::number(track.style.globalSize);
+        }
+    }
+
+    for (int i = 0; i < boundaries.size(); ++i) {
+        // Each segment holds the frames in [boundary i, boundary i+1)
+        double from = (i == 0) ? start : boundaries[i] - CUT_EPSILON_S;
+        double to = (i + 1 < boundaries.size()) ? boundaries[i + 1] - CUT_EPSILON_S : end;
+        QString name = QString("segment_%1.ts").arg(i, 4, 10, QChar('0'));
+
+        ExportStep step;
+        step.spanMs = static_cast<qint64>((to - from) * 1000.0);
+
+        QStringList args;
+        args << "-y";
+        args << "-ss" << seconds(from);
+        args << "-i" << config.videoPath;       // [0]
+        if (overlay) {
+            // Frame k of the source shows at k / fps: the segment starts at
+            // the first frame after the cut, plus one spare frame at the end
+            step.overlayFirstFrame = static_cast<qint64>(std::ceil(from * info.frameRate - 1e-3));
+            qint64 lastFrame = static_cast<qint64>(std::ceil(to * info.frameRate - 1e-3));
+            step.overlayFrames = static_cast<int>(lastFrame - step.overlayFirstFrame + 1);
+
+            QSize size = overlay->frameSize();
+            args << "-f" << "rawvideo" << "-pix_fmt" << "rgba";
+            args << "-s" << QString("%1x%2").arg(size.width()).arg(size.height());
+            args << "-framerate" << info.frameRateText;
+            args << "-i" << "pipe:0";           // [1] rendered bands
+        }
+        args << "-t" << seconds(to - from);
+        if (overlay) {
+            args << "-filter_complex" << "[0:v][1:v]overlay=0:main_h-overlay_h[vout]";
+            args << "-map" << "[vout]" << "-an";
+        } else {
+            args << "-map" << "0:v:0" << "-an";
+        }
+        args << segmentEncoderArgs();
+        args << "-threads" << QString::number(threadsPerWorker);
+        args << "-f" << "mpegts" << dir.filePath(name);
+        step.args = args;
+
+        QString key = videoId.isEmpty()
+                          ? QString()
+                          : ExportCache::key(QStringList(cacheParts) << "segment"
+                                                                     << seconds(from) << seconds(to));
+        segments << reuseOrProduce(plan, step, "segments", key, dir.filePath(name));
+    }
+
+    ExportStep concat = buildConcatStep(config, workDir, segments, durationMs);
+    if (concat.args.isEmpty()) {
+        return segmented ? ExportPlan() : single;
+    }
+    plan.steps.append(concat);
+    return plan;
+}
+
+ExportService::ExportPlan ExportService::planRythmoExport(const RythmoExportConfig &config,
+                                                          const std::atomic<bool> *cancelled)
+{
+    MediaInfo info = MediaProbe::probe(config.videoPath);
+    if (cancelled && *cancelled) {
+        ExportPlan stopped;
+        stopped.error = CANCELLED_MESSAGE;
+        return stopped;
+    }
+    if (!info.valid || info.frameRate <= 0) {
+        qWarning() << "[ExportService] Cannot read frame rate of" << config.videoPath;
+        return ExportPlan();
+    }
+
+    qint64 endMs = (config.durationMs > 0) ? config.startTimeMs + config.durationMs
+                                           : info.durationMs;
+    if (endMs <= config.startTimeMs) {
+        return ExportPlan();
+    }
+
+    auto overlay = std::make_shared<const RythmoFrameRenderer>(
+        config.tracks, config.speed, info.width, info.height);
+
+    ExportPlan plan;
+    plan.overlay = overlay;
+    plan.frameRate = info.frameRate;
+
+    ExportStep step;
+    step.spanMs = endMs - config.startTimeMs;
+    step.overlayFirstFrame = static_cast<qint64>(
+        std::ceil(config.startTimeMs / 1000.0 * info.frameRate - 1e-3));
+    qint64 endFrame = static_cast<qint64>(std::ceil(endMs / 1000.0 * info.frameRate - 1e-3));
+    step.overlayFrames = static_cast<int>(qMax<qint64>(1, endFrame - step.overlayFirstFrame));
+
+    // Only the band strip is rendered and piped; FFmpeg pads it to the
+    // full picture. The transparent area never changes, so intra codecs
+    // compress it to almost nothing and VP9 skips it entirely.
+    QSize size = overlay->frameSize();
+    QString pad = QString("pad=%1:%2:0:oh-ih:color=black@0.0")
+                      .arg(info.width).arg(info.height);
+
+    QStringList args;
+    args << "-y";
+    args << "-f" << "rawvideo" << "-pix_fmt" << "rgba";
+    args << "-s" << QString("%1x%2").arg(size.width()).arg(size.height());
+    args << "-framerate" << info.frameRateText;
+    args << "-i" << "pipe:0";
+    args << "-vf" << pad;
+
+    switch (config.format) {
+    case RythmoExportConfig::ProRes4444:
+        args << "-c:v" << "prores_ks" << "-profile:v" << "4444";
+        args << "-pix_fmt" << "yuva444p10le";
+        break;
+    case RythmoExportConfig::VP9Alpha:
+        args << "-c:v" << "libvpx-vp9" << "-pix_fmt" << "yuva420p";
+        args << "-b:v" << "0" << "-crf" << "30" << "-row-mt" << "1";
+        break;
+    case RythmoExportConfig::PngSequence:
+        args << "-c:v" << "png" << "-pix_fmt" << "rgba";
+        args << "-f" << "image2";
+        break;
+    }
+
+    // Written aside and moved into place once complete, so a crash or a
+    // cancel never leaves a truncated movie or half a sequence behind
+    if (config.format == RythmoExportConfig::PngSequence) {
+        // The images go into a directory of their own; its name drops the
+        // frame number pattern, which image2 would expand anywhere in the path
+        QFileInfo output(config.outputPath);
+        QString name = output.completeBaseName();
+        name.remove(QRegularExpression("_?%\\d*d"));
+        QDir partialDir(output.dir().filePath(name + ".partial"));
+        partialDir.removeRecursively();     // Left by a crash
+        if (!QDir().mkpath(partialDir.path())) {
+            plan.error = "Erreur: Impossible de créer le dossier temporaire.";
+            return plan;
+        }
+        plan.deliveries.insert(partialDir.path(), output.absolutePath());
+        args << partialDir.filePath(output.fileName());
+    } else {
+        QString partial = partialPath(config.outputPath);
+        plan.deliveries.insert(partial, config.outputPath);
+        args << partial;
+    }
+
+    step.args = args;
+    plan.steps.append(step);
+    return plan;
+}
@@ -13,10 +13,44 @@
 #ifndef EXPORTSERVICE_H
 #define EXPORTSERVICE_H
 
+#include "RythmoRenderer.h"
+
+#include <QFutureWatcher>
+#include <QHash>
 #include <QObject>
 #include <QProcess>
 #include <QString>
 
+#include <atomic>
+#include <memory>
+
+/**
+ * @struct ExportOutput
+ * @brief An additional delivery produced by the same export pass.
+ *
+ * Shares the picture of the main output, with its own audio routing:
+ * a gain of 0 leaves a source out (e.g. originalVolume 0 for the takes
+ * alone, take gains 0 for the original audio alone).
+ */
+struct ExportOutput {
+    QString outputPath;             ///< Absolute path of this delivery
+    float originalVolume = 1.0f;    ///< Gain of the original video audio
+    float audioGain = 1.0f;         ///< Gain of the primary take
+    float secondAudioGain = 1.0f;   ///< Gain of the second take
+};
+
+/**
+ * @struct ExportAudioTrack
+ * @brief One language track of a multi-track export, muxed as its own stream.
+ */
+struct ExportAudioTrack {
+    QString audioPath;      ///< Take, language mix, or the source video for the original audio
+    qint64 startMs = 0;     ///< Position in audioPath matching the start of the export
+    float gain = 1.0f;      ///< Linear gain
+    QString language;       ///< ISO 639-2 code written to the stream (e.g. "fra")
+    QString title;          ///< Stream title shown by players
+};
+
 /**
  * @struct ExportConfig
  * @brief Configuration structure for export operations.
@@ -24,6 +58,16 @@
  * Contains all parameters needed to perform a video/audio merge.
  */
 struct ExportConfig {
+    /**
+     * @enum VideoMode
+     * @brief How the video stream of the output is produced.
+     */
+    enum VideoMode {
+        ReEncode,           ///< Re-encode the whole range (H.264, CRF 18)
+        SmartRender,        ///< Stream-copy whole GOPs, re-encode only the partial GOPs at the cut points
+        ParallelReEncode    ///< Re-encode keyframe-aligned segments concurrently, then join them
+    };
+
     QString videoPath;          ///< Absolute path to source video
     QString audioPath;          ///< Absolute path to primary recorded audio
     QString secondAudioPath;    ///< Optional: path to second audio track
@@ -31,11 +75,66 @@ struct ExportConfig {
     qint64 durationMs;          ///< Recording duration in milliseconds (-1 for full)
     qint64 startTimeMs;         ///< Start time offset in milliseconds
     float originalVolume;       ///< Volume of original video audio (0.0 to 1.0)
+    float audioGain;            ///< Linear gain of the primary take in the mix
+    float secondAudioGain;      ///< Linear gain of the second take in the mix
+    bool audioLimiter;          ///< Limit mix peaks below full scale
+    bool audioDither;           ///< Dither the mix to 16-bit (float otherwise)
+    VideoMode videoMode;        ///< Re-encode everything or smart-render
+    int encodeWorkers;          ///< Concurrent encoders for ParallelReEncode (0 = auto)
+    QList<RythmoBandTrack> burnInTracks;  ///< Rythmo bands burned into the picture (empty = none)
+    int rythmoSpeed;            ///< Scrolling speed of the burned-in bands (pixels/second)
+    QList<ExportOutput> additionalOutputs;  ///< Other deliveries from the same pass
+    QList<ExportAudioTrack> audioTracks;    ///< Non-empty: one tagged stream per track instead of a mix
+    QString encodedAudioPath;       ///< AAC soundtrack already encoded (e.g. while recording): muxed as is
+    QStringList premixedAudioPaths; ///< Set by ExportService: mix of each output (or audio track)
+    bool premixedAudioEncoded;      ///< Set by ExportService: the premixes are already AAC
     
     ExportConfig()
         : durationMs(-1)
         , startTimeMs(0)
         , originalVolume(1.0f)
+        , audioGain(1.0f)
+        , secondAudioGain(1.0f)
+        , audioLimiter(true)
+        , audioDither(false)
+        , videoMode(ReEncode)
+        , encodeWorkers(0)
+        , rythmoSpeed(100)
+        , premixedAudioEncoded(false)
+    {}
+};
+
+/**
+ * @struct RythmoExportConfig
+ * @brief Configuration of a rythmo-only export with alpha channel.
+ *
+ * The bands are rendered alone on a transparent background at the frame
+ * rate and resolution of the source video, for compositing in an editor.
+ */
+struct RythmoExportConfig {
+    /**
+     * @enum Format
+     * @brief Output container/codec.
+     */
+    enum Format {
+        ProRes4444,         ///< QuickTime .mov, ProRes 4444 with alpha
+        VP9Alpha,           ///< WebM, VP9 with yuva420p
+        PngSequence         ///< Numbered RGBA PNG files
+    };
+
+    QString videoPath;          ///< Source video (frame rate and resolution)
+    QString outputPath;         ///< Output file, or printf-style pattern for PngSequence
+    qint64 startTimeMs;         ///< First media position rendered
+    qint64 durationMs;          ///< Length in milliseconds (-1 for the rest of the video)
+    QList<RythmoBandTrack> tracks;  ///< Bands to render, top to bottom
+    int speed;                  ///< Scrolling speed (pixels/second)
+    Format format;
+
+    RythmoExportConfig()
+        : startTimeMs(0)
+        , durationMs(-1)
+        , speed(100)
+        , format(ProRes4444)
     {}
 };
 
@@ -45,9 +144,25 @@ struct ExportConfig {
  * 
  * Features:
  * - Merges video with one or two audio tracks
- * - Supports audio mixing with volume control
+ * - Native audio mix with exact per-track gains, limiter and dither
+ *   (AudioMixer), cached between exports; FFmpeg only encodes it
  * - Reports progress via signals
  * - High-quality H.264 encoding (CRF 18)
+ * - Smart render: stream-copies the video and only re-encodes the GOPs
+ *   cut by the start/end points, so exports run at disk speed
+ * - Segment-parallel encoding: keyframe-aligned segments are encoded by
+ *   several FFmpeg processes at once, with aggregated progress/cancel
+ * - Rythmo burn-in: the bands are rendered offscreen, frame by frame, and
+ *   piped to FFmpeg which overlays them at the bottom of the picture
+ * - Rythmo-only export with alpha (ProRes 4444, VP9, PNG sequence)
+ * - Multi-output: several deliveries (full mix, stems...) from one pass that
+ *   reads the sources and encodes the picture once
+ * - Multi-language: N audio streams tagged with their language in one MP4
+ * - Export cache: segments, premixes and encoded audio are filed by content
+ *   (ExportCache) and reused by later exports that need them
+ * - Resumable: long exports go through segments recorded in a manifest, so
+ *   a cancelled or crashed export restarts after the last complete one; the
+ *   deliveries are written under a temporary name and renamed at the end
  * 
  * @example
  * @code
@@ -85,17 +200,36 @@ public:
      * Emits progressChanged during processing and exportFinished on completion.
      */
     void startExport(const ExportConfig &config);
+
+    /**
+     * @brief Exports the rythmo bands alone, on a transparent background.
+     * @param config Rythmo export configuration.
+     *
+     * Reports through the same progressChanged/exportFinished signals.
+     */
+    void startRythmoExport(const RythmoExportConfig &config);
     
     /**
      * @brief Cancels a running export operation.
+     *
+     * The segments already complete are kept: exporting the same output
+     * again resumes after them. Partial deliveries are removed.
      */
     void cancelExport();
     
     /**
      * @brief Checks if FFmpeg is available on the system.
      * @return true if FFmpeg is installed and accessible.
+     *
+     * Answered from ToolCapabilities: instant once the startup probe ran.
      */
     bool isFFmpegAvailable() const;
+
+    /**
+     * @brief Returns true if @p code has the form of an ISO 639-2 language
+     *        code: three lowercase ASCII letters (e.g. "fra", "eng", "und").
+     */
+    static bool isLanguageCode(const QString &code);
     
     /**
      * @brief Returns whether an export is currently in progress.
@@ -116,18 +250,203 @@ signals:
      */
     void exportFinished(bool success, const QString &message);
 
-private slots:
-    void handleProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
-    void handleProcessError(QProcess::ProcessError error);
-    void parseProgressOutput();
-
 private:
+    /**
+     * @struct ExportStep
+     * @brief One FFmpeg invocation of an export pipeline.
+     */
+    struct ExportStep {
+        QStringList args;   ///< FFmpeg command-line arguments
+        qint64 spanMs;      ///< Media duration processed, used to weight progress
+        int stage = 0;      ///< Steps of the same stage may run concurrently
+        qint64 overlayFirstFrame = 0;   ///< Source frame index of the first overlay frame
+        int overlayFrames = 0;          ///< Overlay frames piped to stdin (0 = no overlay)
+        QString cacheKind;              ///< Non-empty: outputFile goes to ExportCache on success
+        QString cacheKey;
+        QString outputFile;             ///< Intermediate written (empty for the final pass)
+        QString resumeKey;              ///< Identity in the resume manifest (empty = not resumable)
+        bool done = false;              ///< Completed by an interrupted run: skipped
+    };
+
+    /**
+     * @struct ExportPlan
+     * @brief Ordered steps plus the number of FFmpeg processes allowed at once.
+     */
+    struct ExportPlan {
+        QList<ExportStep> steps;
+        int workers = 1;
+        std::shared_ptr<const RythmoFrameRenderer> overlay;    ///< Burn-in renderer, if any
+        double frameRate = 0.0;                                 ///< Overlay frame rate
+        QString error;      ///< Why the plan has no steps, if it failed
+        QHash<QString, QString> deliveries;     ///< Partial file (or directory) -> final path
+    };
+
+    /**
+     * @brief Mixes the audio natively, then plans the video (call off the GUI thread).
+     * @param cancelled Checked between the steps: once set, nothing more is
+     *        written to @p workDir and an empty plan is returned.
+     */
+    static ExportPlan planExport(const ExportConfig &config, const QString &workDir,
+                                 const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * @brief Work directory of an export, named after a hash of its output
+     *        path, inputs and settings: the same export gets the same one.
+     */
+    static QString workDirFor(const ExportConfig &config);
+
+    /**
+     * @brief Temporary name a delivery is written under, next to it.
+     */
+    static QString partialPath(const QString &outputPath);
+
+    /**
+     * @brief Marks the steps an interrupted run already completed.
+     *
+     * The manifest of @p workDir starts with a hash of the whole plan
+     * (commands and input contents); if it differs, nothing is resumed and
+     * the manifest is rewritten. Otherwise a step is skipped if the manifest
+     * lists the same command on the same source, and its output still has
+     * the recorded size.
+     */
+    static void applyManifest(ExportPlan &plan, const QString &workDir,
+                              const ExportConfig &config);
+
+    /**
+     * @brief Appends a completed step to the manifest of the work directory.
+     */
+    void recordCompletedStep(const ExportStep &step);
+
+    /**
+     * @brief Produces (or reuses) the premixed soundtrack of every output.
+     * @return One mix per output (main first), or an empty list to fall back
+     *         to FFmpeg's amix (or when @p cancelled was set).
+     */
+    static QStringList premixAudio(const ExportConfig &config,
+                                   const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * @brief Reuses the cached artifact for @p key, or queues @p step to produce it.
+     * @param step Step writing @p outputFile; the file is cached once the export succeeded.
+     * @param key Cache key (empty: always produce, never cache).
+     * @return Path the following steps read: the cached artifact or @p outputFile.
+     */
+    static QString reuseOrProduce(ExportPlan &plan, ExportStep step, const QString &kind,
+                                  const QString &key, const QString &outputFile);
+
+    /**
+     * @brief Queues the AAC encode of every premix (or reuses cached ones).
+     *
+     * The encodes run alongside the video steps; the final mux then copies
+     * the audio. Updates @p config to point at the encoded files.
+     */
+    static void planAudioEncode(ExportConfig &config, ExportPlan &plan,
+                                const QString &workDir);
+
+    /**
+     * @brief Plans a smart-render export (runs ffprobe, call off the GUI thread).
+     * @param config Export configuration.
+     * @param workDir Directory for intermediate segments.
+     * @return Plan to run. Falls back to a parallel re-encode when the
+     *         source cannot be stream-copied.
+     */
+    static ExportPlan planSmartRender(const ExportConfig &config,
+                                      const QString &workDir);
+
+    /**
+     * @brief Plans a segment-parallel re-encode (runs ffprobe, call off the GUI thread).
+     * @param config Export configuration.
+     * @param workDir Directory for intermediate segments.
+     */
+    static ExportPlan planParallelReEncode(const ExportConfig &config,
+                                           const QString &workDir);
+
+    /**
+     * @brief Plans a rythmo-only export (runs ffprobe, call off the GUI thread).
+     *
+     * Like the other exports it writes a partial delivery: a movie under
+     * partialPath(), a PNG sequence into a partial directory whose images
+     * are moved next to the output once all are written.
+     *
+     * @return Single-step plan, or an empty plan if the source can't be
+     *         probed or @p cancelled was set.
+     */
+    static ExportPlan planRythmoExport(const RythmoExportConfig &config,
+                                       const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * @brief Resolves ExportConfig::encodeWorkers (0 = sized to the cores).
+     */
+    static int resolveWorkerCount(const ExportConfig &config);
+
+    /**
+     * @brief Builds the final pass joining segments and muxing the audio mix.
+     * @param segments Segment files, in order (in @p workDir or the cache).
+     * @return The concat + mux step, or an empty argument list on I/O error.
+     */
+    static ExportStep buildConcatStep(const ExportConfig &config, const QString &workDir,
+                                      const QStringList &segments, qint64 durationMs);
+
+    /**
+     * @brief Starts running the given plan.
+     */
+    void runPlan(const ExportPlan &plan);
+
+    /**
+     * @brief Launches pending steps while workers are free and the stage allows it.
+     */
+    void launchPendingSteps();
+
+    void handleProcessFinished(QProcess *process, int exitCode,
+                               QProcess::ExitStatus exitStatus);
+    void handleProcessError(QProcess *process, QProcess::ProcessError error);
+    void parseProgressOutput(QProcess *process);
+
+    /**
+     * @brief Kills every running FFmpeg process.
+     */
+    void killRunningProcesses();
+
+    /**
+     * @brief Resets pipeline state once the export ended.
+     *
+     * On success the deliveries are renamed into place and the work
+     * directory is removed; otherwise the partial deliveries are deleted and
+     * the completed segments kept for a resume.
+     */
+    void finishExport(bool success, const QString &message);
+
+    /**
+     * @brief Builds the audio mix filter graph ending in [aout].
+     * @param config Export configuration.
+     * @param originalInput FFmpeg input index carrying the original audio.
+     * @param firstTakeInput FFmpeg input index of the first recorded take.
+     */
+    static QString buildAudioFilter(const ExportConfig &config,
+                                    int originalInput, int firstTakeInput);
+
+    /**
+     * @brief Appends the audio inputs and one output block per delivery.
+     *
+     * With premixed soundtracks every output maps the video of input 0 and
+     * its own mix, so the picture is decoded/encoded once for all of them.
+     * Without, the amix graph feeds the main output only.
+     *
+     * @param args Arguments with the video inputs already added.
+     * @param originalInput FFmpeg input index carrying the original audio.
+     * @param firstAudioInput FFmpeg index the first appended input gets.
+     * @param outputOptions Options repeated for each output (video codec, -t).
+     */
+    static void appendOutputArgs(const ExportConfig &config, QStringList &args,
+                                 int originalInput, int firstAudioInput,
+                                 const QStringList &outputOptions);
+
     /**
      * @brief Builds the FFmpeg command arguments.
      * @param config Export configuration.
      * @return List of command-line arguments.
      */
-    QStringList buildFFmpegArgs(const ExportConfig &config) const;
+    static QStringList buildFFmpegArgs(const ExportConfig &config);
     
     /**
      * @brief Validates the export configuration.
@@ -137,8 +456,20 @@ private:
      */
     bool validateConfig(const ExportConfig &config, QString &errorMessage) const;
 
-    QProcess *m_process;
-    qint64 m_totalDurationMs;
+    QFutureWatcher<ExportPlan> *m_planWatcher;
+    QString m_workDir;                          ///< Intermediate segments and manifest
+    QHash<QString, QString> m_deliveries;       ///< Partial file -> final output path
+    QList<ExportStep> m_steps;                  ///< Empty when idle
+    int m_nextStep;                             ///< Next step to launch
+    int m_maxWorkers;                           ///< Concurrent FFmpeg processes allowed
+    QHash<QProcess *, int> m_running;           ///< Running process -> step index
+    QHash<QProcess *, qint64> m_runningMs;      ///< Progress of each running step
+    qint64 m_completedMs;                       ///< Span of finished steps
+    qint64 m_totalDurationMs;                   ///< Sum of all step spans
+    std::shared_ptr<const RythmoFrameRenderer> m_overlay;   ///< Burn-in renderer of the plan
+    double m_overlayFrameRate;
+    bool m_planning;
+    std::shared_ptr<std::atomic<bool>> m_planCancel;   ///< Stops the running planner
 };
 
 #endif // EXPORTSERVICE_H
@@ -0,0 +1,223 @@
+/**
+ * @file FrameCache.cpp
+ * @brief Implementation of the FrameCache class.
+ */
+
+#include "FrameCache.h"
+#include "KeyframeIndex.h"
+#include "MediaProbe.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QProcess>
+
+#include <cstring>
+
+namespace {
+
+/** Frames of @p size that fit in the memory cap. */
+int capacity(const QSize &size)
+{
+    const qint64 frameBytes = qint64(size.width()) * size.height() * 4;
+    return static_cast<int>(qBound<qint64>(3, FrameCache::MEMORY_BYTES / frameBytes, 10000));
+}
+
+/** Frames kept before the position; the rest (minus the position) after. */
+int framesBehind(int capacity)
+{
+    return capacity * 2 / 3;
+}
+
+} // namespace
+
+FrameCache::FrameCache(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+    , m_bytes(0)
+{
+    m_worker.setMaxThreadCount(1);
+}
+
+FrameCache::~FrameCache()
+{
+    ++m_generation;
+    m_worker.waitForDone();
+}
+
+void FrameCache::setSource(const QString &source, std::shared_ptr<const KeyframeIndex> index)
+{
+    ++m_generation;
+    QMutexLocker lock(&m_mutex);
+    if (source != m_source) {
+        m_source = source;
+        m_frameSize = QSize();
+    }
+    m_index = std::move(index);
+    m_frames.clear();
+    m_bytes = 0;
+}
+
+void FrameCache::fill(qint64 positionMs)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!m_index || m_source.isEmpty()) {
+            return;
+        }
+
+        // Still well inside the cached window: nothing to decode
+        if (m_frameSize.isValid()) {
+            const int frames = capacity(m_frameSize);
+            const int behind = framesBehind(frames);
+            const int ahead = frames - behind - 1;
+            if (m_frames.contains(m_index->frameAt(positionMs))
+                && m_frames.contains(m_index->stepFrames(positionMs, -behind / 2))
+                && m_frames.contains(m_index->stepFrames(positionMs, ahead / 2))) {
+                return;
+            }
+        }
+    }
+
+    const quint64 generation = ++m_generation;
+    m_worker.start([this, generation, positionMs]() { decode(generation, positionMs); });
+}
+
+void FrameCache::cancel()
+{
+    ++m_generation;
+}
+
+QImage FrameCache::frame(qint64 positionMs) const
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_index) {
+        return QImage();
+    }
+    return m_frames.value(m_index->frameAt(positionMs));
+}
+
+void FrameCache::decode(quint64 generation, qint64 positionMs)
+{
+    QString source;
+    std::shared_ptr<const KeyframeIndex> index;
+    QSize size;
+    {
+        QMutexLocker lock(&m_mutex);
+        source = m_source;
+        index = m_index;
+        size = m_frameSize;
+    }
+    if (generation != m_generation || !index || source.isEmpty()) {
+        return;
+    }
+
+    if (!size.isValid()) {
+        const MediaInfo info = MediaProbe::probe(source);
+        if (!info.valid || info.width <= 0 || info.height <= 0) {
+            return;
+        }
+        const int height = qMin(info.height, MAX_HEIGHT) & ~1;
+        const int width = qMax(2, qRound(double(info.width) * height / info.height) & ~1);
+        size = QSize(width, height);
+
+        QMutexLocker lock(&m_mutex);
+        if (m_source == source) {
+            m_frameSize = size;
+        }
+    }
+
+    // Window around the position; decoding has to start at the keyframe
+    // before it, the frames in between are decoded and dropped
+    const int frames = capacity(size);
+    const int behind = framesBehind(frames);
+    const qint64 firstMs = index->stepFrames(positionMs, -behind);
+    const qint64 lastMs = index->stepFrames(positionMs, frames - behind - 1);
+    const qint64 decodeFromMs = index->keyframeBefore(firstMs);
+    const QVector<qint64> times = index->frameTimes(decodeFromMs, lastMs);
+    if (times.isEmpty()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Input seek onto the keyframe, no accurate seek: the n-th frame out is
+    // the n-th indexed frame from it. Passthrough: no frame duplicated or
+    // dropped to fit a frame rate
+    QProcess ffmpeg;
+    ffmpeg.start("ffmpeg", QStringList()
+        << "-v" << "error" << "-nostdin"
+        << "-noaccurate_seek"
+        << "-ss" << QString::number(decodeFromMs / 1000.0, 'f', 3)
+        << "-i" << source
+        << "-an" << "-sn"
+        << "-frames:v" << QString::number(times.size())
+        << "-vf" << QString("scale=%1:%2").arg(size.width()).arg(size.height())
+        << "-vsync" << "passthrough"
+        << "-pix_fmt" << "bgra"
+        << "-f" << "rawvideo"
+        << "pipe:1");
+    if (!ffmpeg.waitForStarted()) {
+        qWarning() << "[FrameCache] Cannot start FFmpeg";
+        return;
+    }
+
+    const qint64 frameBytes = qint64(size.width()) * size.height() * 4;
+    QByteArray pending;
+    int decoded = 0;
+    int kept = 0;
+    while (decoded < times.size() && generation == m_generation) {
+        if (ffmpeg.bytesAvailable() == 0 && !ffmpeg.waitForReadyRead(100)) {
+            if (ffmpeg.state() == QProcess::NotRunning && ffmpeg.bytesAvailable() == 0) {
+                break;
+            }
+            continue;
+        }
+        pending += ffmpeg.read(frameBytes - pending.size());
+        if (pending.size() < frameBytes) {
+            continue;
+        }
+
+        if (times.at(decoded) >= firstMs) {
+            // BGRA in memory is what QImage calls (A)RGB32 on little-endian
+            QImage image(size, QImage::Format_RGB32);
+            std::memcpy(image.bits(), pending.constData(), static_cast<size_t>(frameBytes));
+            insert(generation, times.at(decoded), image);
+            ++kept;
+        }
+        pending.clear();
+        ++decoded;
+    }
+    if (ffmpeg.state() != QProcess::NotRunning) {
+        ffmpeg.kill();
+        ffmpeg.waitForFinished(1000);
+    }
+
+    qDebug() << "[FrameCache] Decoded" << decoded << "frames, kept" << kept << "around"
+             << positionMs << "ms in" << timer.elapsed() << "ms";
+}
+
+void FrameCache::insert(quint64 generation, qint64 timeMs, const QImage &image)
+{
+    QMutexLocker lock(&m_mutex);
+    if (generation != m_generation) {
+        return;     // Another fill, source or playback since
+    }
+
+    // Evict from the end farthest from the new frame: frames of an older
+    // window go first
+    const qint64 bytes = image.sizeInBytes();
+    while (m_bytes + bytes > MEMORY_BYTES && !m_frames.isEmpty()) {
+        const bool dropFirst = timeMs - m_frames.firstKey() > m_frames.lastKey() - timeMs;
+        auto it = dropFirst ? m_frames.begin() : std::prev(m_frames.end());
+        m_bytes -= it.value().sizeInBytes();
+        m_frames.erase(it);
+    }
+    auto previous = m_frames.constFind(timeMs);
+    if (previous != m_frames.constEnd()) {
+        m_bytes -= previous.value().sizeInBytes();
+    }
+    m_frames.insert(timeMs, image);
+    m_bytes += bytes;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file FrameCache.h
+ * @brief Decoded video frames around the playhead, for instant frame steps.
+ *
+ * A QMediaPlayer seek decodes from the previous keyframe every time: on a
+ * long-GOP source, stepping backwards one frame at a time decodes the GOP
+ * over and over. While paused, this cache decodes the frames before and
+ * after the playhead once, with its own FFmpeg process on a worker thread
+ * (the player is not involved), and keeps them in memory. Frame steps and
+ * short scrubs inside that window are then served from RAM.
+ *
+ * Frames are identified through the KeyframeIndex of the video: decoding
+ * starts at a keyframe, so the n-th decoded frame is the n-th indexed
+ * frame from it. Without an index nothing is cached.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note frame() never blocks on a decode.
+ */
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
+
+class KeyframeIndex;
+
+/**
+ * @class FrameCache
+ * @brief Bounded cache of decoded frames around a position.
+ *
+ * @example
+ * @code
+ * frameCache->setSource(videoPath, engine->keyframeIndex());
+ * frameCache->fill(engine->position());     // When paused
+ * ...
+ * QImage image = frameCache->frame(index->stepFrames(position, -1));
+ * if (!image.isNull()) {
+ *     videoWidget->showImage(image);         // No seek needed
+ * }
+ * @endcode
+ */
+class FrameCache : public QObject {
+    Q_OBJECT
+
+public:
+    /** @brief Memory held by decoded frames (256 MiB: ~32 frames of 1080p). */
+    static constexpr qint64 MEMORY_BYTES = 256LL * 1024 * 1024;
+
+    /** @brief Frames are decoded at most this high (4K sources are scaled down). */
+    static constexpr int MAX_HEIGHT = 1080;
+
+    explicit FrameCache(QObject *parent = nullptr);
+
+    /**
+     * @brief Stops the running decode and waits for it.
+     */
+    ~FrameCache() override;
+
+    /**
+     * @brief Switches to another video (or index); cached frames are dropped.
+     * @param index Frame times of @p source; nullptr disables the cache.
+     */
+    void setSource(const QString &source, std::shared_ptr<const KeyframeIndex> index);
+
+    /**
+     * @brief Decodes the frames around @p positionMs in the background.
+     *
+     * Two thirds of the window lie before the position: stepping backwards
+     * is what a player does worst. Does nothing if the neighbourhood of the
+     * position is already cached; replaces a fill still running.
+     */
+    void fill(qint64 positionMs);
+
+    /** @brief Stops the running fill (playback resumed). Cached frames stay. */
+    void cancel();
+
+    /**
+     * @brief Returns the frame shown at @p positionMs if cached, else a null image.
+     */
+    QImage frame(qint64 positionMs) const;
+
+private:
+    void decode(quint64 generation, qint64 positionMs);
+    void insert(quint64 generation, qint64 timeMs, const QImage &image);
+
+    QThreadPool m_worker;               ///< One thread: a new fill waits for the old one to stop
+    std::atomic<quint64> m_generation;  ///< Bumped by each fill, setSource() and cancel()
+    mutable QMutex m_mutex;             ///< Guards everything below
+    QString m_source;
+    std::shared_ptr<const KeyframeIndex> m_index;
+    QSize m_frameSize;                  ///< Decoded size, probed once per source
+    QMap<qint64, QImage> m_frames;      ///< Frame time (ms) -> image
+    qint64 m_bytes;
+};
+
+#endif // FRAMECACHE_H
@@ -0,0 +1,80 @@
+/**
+ * @file FrameStreamer.cpp
+ * @brief Implementation of the FrameStreamer class.
+ */
+
+#include "FrameStreamer.h"
+
+#include <QDebug>
+#include <QThread>
+#include <QtConcurrent>
+
+namespace {
+
+// Bytes allowed to sit in the stdin write buffer before rendering pauses.
+// A few 1080p band frames; FFmpeg drains the pipe faster than that.
+constexpr qint64 MAX_BUFFERED_BYTES = 16 * 1024 * 1024;
+
+} // namespace
+
+FrameStreamer::FrameStreamer(QProcess *process, int frameCount, RenderFunction render)
+    : QObject(process)
+    , m_process(process)
+    , m_render(std::move(render))
+    , m_frameCount(frameCount)
+    , m_nextFrame(0)
+    , m_writtenFrames(0)
+    , m_closed(false)
+    , m_maxInFlight(qMax(2, QThread::idealThreadCount() * 2))
+{
+}
+
+void FrameStreamer::start()
+{
+    connect(m_process, &QIODevice::bytesWritten, this, &FrameStreamer::pump);
+
+    if (m_process->state() == QProcess::Running) {
+        pump();
+    } else {
+        connect(m_process, &QProcess::started, this, &FrameStreamer::pump);
+    }
+}
+
+void FrameStreamer::pump()
+{
+    if (m_closed || m_process->state() != QProcess::Running) {
+        return;
+    }
+
+    // Write finished frames in order while FFmpeg keeps up
+    while (!m_pending.isEmpty() && m_pending.first()->isFinished()
+           && m_process->bytesToWrite() < MAX_BUFFERED_BYTES) {
+        QFutureWatcher<QByteArray> *watcher = m_pending.takeFirst();
+        m_process->write(watcher->result());
+        watcher->deleteLater();
+        ++m_writtenFrames;
+    }
+
+    if (m_writtenFrames == m_frameCount) {
+        // Signals EOF on the pipe; FFmpeg finishes the overlay input
+        m_process->closeWriteChannel();
+        m_closed = true;
+        qDebug() << "[FrameStreamer] Sent" << m_frameCount << "frames";
+        return;
+    }
+
+    // Keep the renderers busy, a bounded distance ahead of the writer
+    while (m_nextFrame < m_frameCount && m_pending.size() < m_maxInFlight) {
+        int index = m_nextFrame++;
+        RenderFunction render = m_render;
+
+        auto *watcher = new QFutureWatcher<QByteArray>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, &FrameStreamer::pump);
+        watcher->setFuture(QtConcurrent::run([render, index]() {
+            QImage frame = render(index);
+            return QByteArray(reinterpret_cast<const char *>(frame.constBits()),
+                              static_cast<int>(frame.sizeInBytes()));
+        }));
+        m_pending.append(watcher);
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file FrameStreamer.h
+ * @brief Feeds rendered raw video frames to an FFmpeg process through stdin.
+ *
+ * Frames are rendered on the global thread pool, several at a time, and
+ * written to the pipe strictly in order. Rendering stops getting ahead when
+ * FFmpeg stops reading, so memory stays bounded whatever the export length.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ */
+
+#ifndef FRAMESTREAMER_H
+#define FRAMESTREAMER_H
+
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+
+#include <functional>
+
+/**
+ * @class FrameStreamer
+ * @brief Ordered, backpressured producer of raw frames for an FFmpeg pipe.
+ *
+ * The streamer is a child of the process it feeds and dies with it. The
+ * render function is called from worker threads and must be thread-safe.
+ */
+class FrameStreamer : public QObject {
+    Q_OBJECT
+
+public:
+    /** @brief Renders frame @p frameIndex; called concurrently. */
+    using RenderFunction = std::function<QImage(int frameIndex)>;
+
+    /**
+     * @param process FFmpeg process reading raw frames on stdin (becomes parent).
+     * @param frameCount Number of frames to send before closing stdin.
+     * @param render Frame renderer.
+     */
+    FrameStreamer(QProcess *process, int frameCount, RenderFunction render);
+
+    /**
+     * @brief Starts rendering and writing once the process is running.
+     */
+    void start();
+
+private:
+    /**
+     * @brief Writes finished frames in order and schedules new renders.
+     */
+    void pump();
+
+    QProcess *m_process;
+    RenderFunction m_render;
+    int m_frameCount;
+    int m_nextFrame;        ///< Next frame index to schedule
+    int m_writtenFrames;
+    bool m_closed;          ///< stdin closed, nothing left to do
+    int m_maxInFlight;
+    QList<QFutureWatcher<QByteArray> *> m_pending;  ///< In frame order
+};
+
+#endif // FRAMESTREAMER_H
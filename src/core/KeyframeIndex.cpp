@@ -0,0 +1,266 @@
+/**
+ * @file KeyframeIndex.cpp
+ * @brief Implementation of the KeyframeIndex class.
+ */
+
+#include "KeyframeIndex.h"
+#include "ExportCache.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QTemporaryFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// File layout (cache only, never leaves the machine: times in native order)
+//   char[8] magic | u64 frame count | u64 keyframe count
+//   frame count x i64 us | keyframe count x i64 us
+const char MAGIC[8] = { 'D', 'B', 'I', 'K', 'E', 'Y', 'S', '1' };
+constexpr qint64 HEADER_SIZE = 8 + 8 + 8;
+
+const QString CACHE_KIND = QStringLiteral("keyframes");
+const QString CACHE_SUFFIX = QStringLiteral("idx");
+
+/** First millisecond showing a frame that starts at @p us. */
+qint64 toMs(qint64 us)
+{
+    return us <= 0 ? 0 : (us + 999) / 1000;
+}
+
+/** Parses an ffprobe "pts_time" in seconds to microseconds. */
+bool parseTime(const QByteArray &text, qint64 &us)
+{
+    bool ok = false;
+    const double seconds = text.toDouble(&ok);
+    if (!ok) {
+        return false;   // "N/A"
+    }
+    us = std::llround(seconds * 1000000.0);
+    return true;
+}
+
+template <typename T> void appendLittleEndian(QByteArray &bytes, T value)
+{
+    value = qToLittleEndian(value);
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
+std::shared_ptr<const KeyframeIndex> KeyframeIndex::load(const QString &source,
+                                                         const std::atomic<bool> *cancelled)
+{
+    const QString fingerprint = ExportCache::fingerprint(source);
+    if (fingerprint.isEmpty()) {
+        return nullptr;
+    }
+
+    QString path = ExportCache::lookup(CACHE_KIND, fingerprint, CACHE_SUFFIX);
+    if (std::shared_ptr<const KeyframeIndex> cached = open(path)) {
+        return cached;
+    }
+    path = build(source, fingerprint, cancelled);
+    return path.isEmpty() ? nullptr : open(path);
+}
+
+QString KeyframeIndex::build(const QString &source, const QString &fingerprint,
+                             const std::atomic<bool> *cancelled)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Packet timestamps are absolute, player positions start at 0: same
+    // conversion as MediaProbe's keyframe lookups
+    QProcess ffprobe;
+    ffprobe.start("ffprobe", QStringList()
+        << "-v" << "error"
+        << "-show_entries" << "format=start_time"
+        << "-of" << "csv=p=0"
+        << source);
+    qint64 startUs = 0;
+    if (!ffprobe.waitForFinished(10000) || ffprobe.exitCode() != 0) {
+        qWarning() << "[KeyframeIndex] ffprobe failed:" << ffprobe.readAllStandardError();
+        return QString();
+    }
+    parseTime(ffprobe.readAllStandardOutput().trimmed(), startUs);
+
+    // Headers only (no decoding), streamed line by line: a feature film
+    // has a few hundred thousand packets
+    ffprobe.start("ffprobe", QStringList()
+        << "-v" << "error"
+        << "-select_streams" << "v:0"
+        << "-show_entries" << "packet=pts_time,flags"
+        << "-of" << "csv=p=0"
+        << source);
+    if (!ffprobe.waitForStarted()) {
+        qWarning() << "[KeyframeIndex] Cannot start ffprobe";
+        return QString();
+    }
+
+    std::vector<qint64> frames;
+    std::vector<qint64> keyframes;
+    auto readLines = [&]() {
+        while (ffprobe.canReadLine()) {
+            const QByteArray line = ffprobe.readLine().trimmed();
+            const int comma = line.indexOf(',');
+            qint64 us;
+            if (comma < 0 || !parseTime(line.left(comma), us)) {
+                continue;
+            }
+            us -= startUs;
+            frames.push_back(us);
+            if (line.indexOf('K', comma) > comma) {
+                keyframes.push_back(us);
+            }
+        }
+    };
+    while (ffprobe.state() != QProcess::NotRunning) {
+        if ((cancelled && *cancelled) || timer.elapsed() > PROBE_TIMEOUT_MS) {
+            ffprobe.kill();
+            ffprobe.waitForFinished(1000);
+            return QString();
+        }
+        ffprobe.waitForReadyRead(100);
+        readLines();
+    }
+    readLines();
+    if (ffprobe.exitCode() != 0 || frames.empty() || keyframes.empty()) {
+        qWarning() << "[KeyframeIndex] No video packets in" << source;
+        return QString();
+    }
+
+    // Packets come in decode order: B-frames are out of presentation order
+    std::sort(frames.begin(), frames.end());
+    frames.erase(std::unique(frames.begin(), frames.end()), frames.end());
+    std::sort(keyframes.begin(), keyframes.end());
+    keyframes.erase(std::unique(keyframes.begin(), keyframes.end()), keyframes.end());
+
+    QByteArray header(MAGIC, sizeof(MAGIC));
+    appendLittleEndian<quint64>(header, frames.size());
+    appendLittleEndian<quint64>(header, keyframes.size());
+
+    // Written aside, then moved into the cache in one rename
+    QTemporaryFile file(QDir(ExportCache::workDirectory()).filePath("keyframes-XXXXXX"));
+    file.setAutoRemove(false);
+    const qint64 frameBytes = static_cast<qint64>(frames.size() * sizeof(qint64));
+    const qint64 keyframeBytes = static_cast<qint64>(keyframes.size() * sizeof(qint64));
+    bool written = file.open() && file.write(header) == header.size()
+                   && file.write(reinterpret_cast<const char *>(frames.data()), frameBytes)
+                          == frameBytes
+                   && file.write(reinterpret_cast<const char *>(keyframes.data()), keyframeBytes)
+                          == keyframeBytes;
+    file.close();
+    const QString path = written
+                             ? ExportCache::insert(CACHE_KIND, fingerprint, CACHE_SUFFIX,
+                                                   file.fileName())
+                             : QString();
+    if (path.isEmpty()) {
+        QFile::remove(file.fileName());
+        qWarning() << "[KeyframeIndex] Cannot write the index of" << source;
+        return QString();
+    }
+
+    qDebug() << "[KeyframeIndex] Indexed" << frames.size() << "frames," << keyframes.size()
+             << "keyframes of" << source << "in" << timer.elapsed() << "ms";
+    return path;
+}
+
+std::shared_ptr<const KeyframeIndex> KeyframeIndex::open(const QString &path)
+{
+    if (path.isEmpty()) {
+        return nullptr;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    const QByteArray bytes = file.readAll();
+    if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.constData(), MAGIC, sizeof(MAGIC)) != 0) {
+        return nullptr;
+    }
+    const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+    const quint64 frameCount = qFromLittleEndian<quint64>(data + 8);
+    const quint64 keyframeCount = qFromLittleEndian<quint64>(data + 16);
+    const quint64 available = quint64(bytes.size() - HEADER_SIZE) / sizeof(qint64);
+    if (frameCount == 0 || keyframeCount == 0 || frameCount > available
+        || keyframeCount != available - frameCount) {
+        return nullptr;
+    }
+
+    std::shared_ptr<KeyframeIndex> index(new KeyframeIndex());
+    index->m_frames.resize(static_cast<qsizetype>(frameCount));
+    index->m_keyframes.resize(static_cast<qsizetype>(keyframeCount));
+    std::memcpy(index->m_frames.data(), data + HEADER_SIZE, frameCount * sizeof(qint64));
+    std::memcpy(index->m_keyframes.data(), data + HEADER_SIZE + frameCount * sizeof(qint64),
+                keyframeCount * sizeof(qint64));
+    return index;
+}
+
+qint64 KeyframeIndex::frameIndexAt(qint64 positionMs) const
+{
+    // Last frame starting at or before the position
+    const auto it = std::upper_bound(m_frames.cbegin(), m_frames.cend(), positionMs * 1000);
+    return qMax<qint64>(0, (it - m_frames.cbegin()) - 1);
+}
+
+qint64 KeyframeIndex::frameAt(qint64 positionMs) const
+{
+    return toMs(m_frames.at(frameIndexAt(positionMs)));
+}
+
+qint64 KeyframeIndex::stepFrames(qint64 positionMs, int count) const
+{
+    const qint64 index = qBound<qint64>(0, frameIndexAt(positionMs) + count, m_frames.size() - 1);
+    return toMs(m_frames.at(index));
+}
+
+QVector<qint64> KeyframeIndex::frameTimes(qint64 firstMs, qint64 lastMs) const
+{
+    QVector<qint64> times;
+    auto it = firstMs <= 0 ? m_frames.cbegin()
+                           : std::lower_bound(m_frames.cbegin(), m_frames.cend(),
+                                              (firstMs - 1) * 1000 + 1);
+    for (; it != m_frames.cend() && toMs(*it) <= lastMs; ++it) {
+        times.append(toMs(*it));
+    }
+    return times;
+}
+
+qint64 KeyframeIndex::keyframeBefore(qint64 positionMs) const
+{
+    const auto it = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), positionMs * 1000);
+    return toMs(it == m_keyframes.cbegin() ? m_keyframes.first() : *(it - 1));
+}
+
+qint64 KeyframeIndex::nearestKeyframe(qint64 positionMs) const
+{
+    const qint64 us = positionMs * 1000;
+    const auto it = std::lower_bound(m_keyframes.cbegin(), m_keyframes.cend(), us);
+    if (it == m_keyframes.cbegin()) {
+        return toMs(*it);
+    }
+    if (it == m_keyframes.cend() || us - *(it - 1) <= *it - us) {
+        return toMs(*(it - 1));
+    }
+    return toMs(*it);
+}
+
+qint64 KeyframeIndex::decodeCost(qint64 positionMs) const
+{
+    const qint64 target = frameIndexAt(positionMs);
+    const auto key = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), m_frames.at(target));
+    const qint64 keyframeUs = key == m_keyframes.cbegin() ? m_keyframes.first() : *(key - 1);
+    const qint64 keyframe =
+        std::lower_bound(m_frames.cbegin(), m_frames.cend(), keyframeUs) - m_frames.cbegin();
+    return qMax<qint64>(1, target - keyframe + 1);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file KeyframeIndex.h
+ * @brief Frame and keyframe timestamps of a video, for planning seeks.
+ *
+ * QMediaPlayer seeks blindly: on long-GOP H.264 a seek decodes everything
+ * from the previous keyframe, and a frame step computed from the frame
+ * rate drifts off the real frames. The index lists the presentation time
+ * of every video frame and of every keyframe, read once from the packet
+ * headers by ffprobe (no decoding) and stored in the export cache under
+ * the content fingerprint of the video.
+ *
+ * With it a seek knows its cost (frames to decode from the keyframe), can
+ * show the nearest keyframe at once and the exact frame next, and frame
+ * steps land exactly on the next or previous frame.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note load() is blocking: run it off the GUI thread. A loaded index is
+ *       read-only and may be queried from any thread.
+ */
+
+#ifndef KEYFRAMEINDEX_H
+#define KEYFRAMEINDEX_H
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class KeyframeIndex
+ * @brief Sorted frame and keyframe times of one video.
+ *
+ * Times are in milliseconds from the start of the video, as used by
+ * QMediaPlayer. A frame time is the first millisecond showing that frame.
+ *
+ * @example
+ * @code
+ * // Worker thread
+ * std::shared_ptr<const KeyframeIndex> index = KeyframeIndex::load(videoPath);
+ *
+ * // One frame back, exactly
+ * player->setPosition(index->stepFrames(player->position(), -1));
+ * @endcode
+ */
+class KeyframeIndex {
+public:
+    /** @brief Longest ffprobe may take to read the packets of a video. */
+    static constexpr int PROBE_TIMEOUT_MS = 10 * 60 * 1000;
+
+    /**
+     * @brief Returns the index of @p source, probing it on first use.
+     * @param source Video file or archived source.
+     * @param cancelled Optional: aborts the probe when set.
+     * @return nullptr if the video cannot be probed (or on cancel).
+     */
+    static std::shared_ptr<const KeyframeIndex> load(const QString &source,
+                                                     const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * @brief Reads an existing index file.
+     * @return nullptr if missing or invalid.
+     */
+    static std::shared_ptr<const KeyframeIndex> open(const QString &path);
+
+    /** @brief Number of video frames. */
+    qint64 frameCount() const { return m_frames.size(); }
+
+    /** @brief Number of keyframes. */
+    qint64 keyframeCount() const { return m_keyframes.size(); }
+
+    /** @brief Time of the frame shown at @p positionMs. */
+    qint64 frameAt(qint64 positionMs) const;
+
+    /**
+     * @brief Time of the frame @p count frames away from the one shown at
+     *        @p positionMs (negative: backwards), clamped to the video.
+     */
+    qint64 stepFrames(qint64 positionMs, int count) const;
+
+    /** @brief Times of the frames starting in [@p firstMs, @p lastMs], in order. */
+    QVector<qint64> frameTimes(qint64 firstMs, qint64 lastMs) const;
+
+    /** @brief Time of the keyframe at or before @p positionMs. */
+    qint64 keyframeBefore(qint64 positionMs) const;
+
+    /** @brief Time of the keyframe closest to @p positionMs, either side. */
+    qint64 nearestKeyframe(qint64 positionMs) const;
+
+    /**
+     * @brief Frames a decoder goes through to show @p positionMs: from the
+     *        keyframe before it, both included.
+     */
+    qint64 decodeCost(qint64 positionMs) const;
+
+private:
+    KeyframeIndex() = default;
+
+    static QString build(const QString &source, const QString &fingerprint,
+                         const std::atomic<bool> *cancelled);
+
+    qint64 frameIndexAt(qint64 positionMs) const;
+
+    QVector<qint64> m_frames;       ///< Frame times, microseconds, sorted
+    QVector<qint64> m_keyframes;    ///< Keyframe times, microseconds, sorted
+};
+
+#endif // KEYFRAMEINDEX_H
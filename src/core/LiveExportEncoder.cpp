@@ -0,0 +1,204 @@
+/**
+ * @file LiveExportEncoder.cpp
+ * @brief Implementation of the LiveExportEncoder class.
+ */
+
+#include "LiveExportEncoder.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+namespace {
+
+// Mixed audio allowed to wait in the encoder's stdin buffer (~10 s of float stereo)
+constexpr qint64 MAX_BUFFERED_BYTES = 4 * 1024 * 1024;
+
+// How long the encoder may stall on a write, or take to finish after EOF
+constexpr int ENCODER_TIMEOUT_MS = 30000;
+
+} // namespace
+
+LiveExportEncoder::LiveExportEncoder(QObject *parent)
+    : QObject(parent)
+    , m_durationMs(-1)
+    , m_watcher(new QFutureWatcher<QString>(this))
+{
+    connect(m_watcher, &QFutureWatcherBase::finished, this, [this]() {
+        m_result = m_watcher->result();
+        // Cancelled once the last frame was written: nobody wants it now
+        if (m_state->cancelled && !m_result.isEmpty()) {
+            QFile::remove(m_result);
+            m_result.clear();
+        }
+        emit finished(!m_result.isEmpty());
+    });
+}
+
+LiveExportEncoder::~LiveExportEncoder()
+{
+    cancel();
+    m_watcher->waitForFinished();
+}
+
+// =============================================================================
+// Control
+// =============================================================================
+
+void LiveExportEncoder::start(const ExportConfig &config)
+{
+    cancel();
+
+    m_config = config;
+    m_durationMs = -1;
+    m_result.clear();
+    m_state = std::make_shared<LiveState>();
+
+    // Same mix as ExportService::premixAudio, with the takes followed live
+    MixSettings mix;
+    if (config.originalVolume >= 0.01f) {
+        mix.inputs.append(MixInput{ config.videoPath, config.originalVolume,
+                                    config.startTimeMs, false });
+    }
+    mix.inputs.append(MixInput{ config.audioPath, config.audioGain, 0, true });
+    if (!config.secondAudioPath.isEmpty()) {
+        mix.inputs.append(MixInput{ config.secondAudioPath, config.secondAudioGain, 0, true });
+    }
+    mix.limiter = config.audioLimiter;
+
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    dir.mkpath("live");
+    QString outputPath = dir.filePath(
+        QString("live/soundtrack_%1.m4a").arg(QDateTime::currentMSecsSinceEpoch()));
+
+    std::shared_ptr<LiveState> state = m_state;
+    m_watcher->setFuture(QtConcurrent::run([mix, outputPath, state]() {
+        return encode(mix, outputPath, state);
+    }));
+    qDebug() << "[LiveExportEncoder] Encoding soundtrack while recording:" << outputPath;
+}
+
+void LiveExportEncoder::finish(qint64 durationMs)
+{
+    if (!m_state || !isRunning()) {
+        return;
+    }
+    m_durationMs = durationMs;
+    m_state->finalDurationMs = qMax<qint64>(0, durationMs);
+}
+
+void LiveExportEncoder::cancel()
+{
+    if (m_state) {
+        m_state->cancelled = true;
+    }
+
+    // Every take writes its own soundtrack: one no export took is deleted.
+    // Read from the future too, finished() may still be queued
+    QString result = m_result;
+    if (!isRunning() && m_watcher->future().resultCount() > 0) {
+        result = m_watcher->result();
+    }
+    if (!result.isEmpty()) {
+        QFile::remove(result);
+    }
+    m_result.clear();
+}
+
+bool LiveExportEncoder::isRunning() const
+{
+    return m_watcher->isRunning();
+}
+
+bool LiveExportEncoder::matches(const ExportConfig &config) const
+{
+    // The soundtrack bakes in every mix setting: any change needs a new mix
+    return m_durationMs >= 0
+           && config.videoPath == m_config.videoPath
+           && config.audioPath == m_config.audioPath
+           && config.secondAudioPath == m_config.secondAudioPath
+           && config.startTimeMs == m_config.startTimeMs
+           && config.durationMs == m_durationMs
+           && config.originalVolume == m_config.originalVolume
+           && config.audioGain == m_config.audioGain
+           && config.secondAudioGain == m_config.secondAudioGain
+           && config.audioLimiter == m_config.audioLimiter
+           && !config.audioDither;
+}
+
+QString LiveExportEncoder::encodedAudio() const
+{
+    return isRunning() ? QString() : m_result;
+}
+
+QString LiveExportEncoder::encodedAudioFor(const ExportConfig &config) const
+{
+    return matches(config) ? encodedAudio() : QString();
+}
+
+// =============================================================================
+// Worker
+// =============================================================================
+
+QString LiveExportEncoder::encode(const MixSettings &mix, const QString &outputPath,
+                                  std::shared_ptr<LiveState> state)
+{
+    QProcess encoder;
+    encoder.start("ffmpeg", QStringList()
+        << "-y" << "-v" << "error"
+        << "-f" << "f32le"
+        << "-ar" << QString::number(AudioMixer::SAMPLE_RATE)
+        << "-ac" << QString::number(AudioMixer::CHANNELS)
+        << "-i" << "pipe:0"
+        << "-c:a" << "aac"
+        << "-b:a" << "192k"
+        << outputPath);
+    if (!encoder.waitForStarted()) {
+        qWarning() << "[LiveExportEncoder] Cannot start FFmpeg";
+        return QString();
+    }
+
+    QString error;
+    bool mixed = AudioMixer::mixLive(mix, [&encoder](const float *samples, qint64 frames) {
+        const qint64 bytes = frames * AudioMixer::CHANNELS * static_cast<qint64>(sizeof(float));
+        if (encoder.write(reinterpret_cast<const char *>(samples), bytes) != bytes) {
+            return false;
+        }
+        // Keep the pipe drained so memory stays flat however long the take
+        while (encoder.bytesToWrite() > MAX_BUFFERED_BYTES) {
+            if (!encoder.waitForBytesWritten(ENCODER_TIMEOUT_MS)) {
+                return false;
+            }
+        }
+        return true;
+    }, state->finalDurationMs, state->cancelled, &error);
+
+    if (!mixed) {
+        encoder.kill();
+        encoder.waitForFinished();
+        QFile::remove(outputPath);
+        if (!state->cancelled) {
+            qWarning() << "[LiveExportEncoder]" << error;
+        }
+        return QString();
+    }
+
+    // Flush what is still buffered, then EOF: the encoder writes the tail
+    while (encoder.bytesToWrite() > 0 && encoder.waitForBytesWritten(ENCODER_TIMEOUT_MS)) {
+    }
+    encoder.closeWriteChannel();
+    if (!encoder.waitForFinished(ENCODER_TIMEOUT_MS)
+        || encoder.exitStatus() != QProcess::NormalExit || encoder.exitCode() != 0) {
+        qWarning() << "[LiveExportEncoder] Encoder failed:"
+                   << encoder.readAllStandardError().trimmed();
+        QFile::remove(outputPath);
+        return QString();
+    }
+
+    qDebug() << "[LiveExportEncoder] Soundtrack ready:" << outputPath;
+    return outputPath;
+}
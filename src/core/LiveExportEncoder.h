@@ -0,0 +1,125 @@
+/**
+ * @file LiveExportEncoder.h
+ * @brief Mixes and encodes the export soundtrack while the takes are recorded.
+ *
+ * Started with the recording, it follows the growing take files, mixes them
+ * with the original audio and streams the mix into a single AAC encoder.
+ * At STOP only the last seconds are left to encode, so the soundtrack is
+ * ready almost at once and the export only has to mux it with the video.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note Requires FFmpeg to be installed and available in PATH.
+ */
+
+#ifndef LIVEEXPORTENCODER_H
+#define LIVEEXPORTENCODER_H
+
+#include "AudioMixer.h"
+#include "ExportService.h"
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class LiveExportEncoder
+ * @brief Background soundtrack encoder running alongside a recording.
+ *
+ * @example
+ * @code
+ * encoder->start(config);              // REC: takes are being written
+ * encoder->finish(recordedMs);         // STOP
+ * if (encoder->matches(config)) { ... }  // Worth waiting for
+ * // finished() -> queue->attachEncodedAudio(id, encoder->encodedAudio());
+ * encoder->cancel();                   // Whatever was not taken is deleted
+ * @endcode
+ */
+class LiveExportEncoder : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LiveExportEncoder(QObject *parent = nullptr);
+    ~LiveExportEncoder() override;
+
+    /**
+     * @brief Starts mixing and encoding the recording described by @p config.
+     *
+     * Uses the video, takes, start position and gains of @p config; its
+     * duration is given later by finish(). Cancels any encode in progress
+     * and deletes the previous soundtrack.
+     */
+    void start(const ExportConfig &config);
+
+    /**
+     * @brief The recording stopped: completes the soundtrack to @p durationMs.
+     *
+     * finished() is emitted once the encoder has written the last frames.
+     */
+    void finish(qint64 durationMs);
+
+    /**
+     * @brief Abandons the current encode and deletes its soundtrack.
+     *
+     * Call it once the soundtrack was handed over (or is of no use):
+     * start() does it too, so each take leaves at most one file behind
+     * until then. A soundtrack moved elsewhere is left alone.
+     */
+    void cancel();
+
+    /**
+     * @brief Returns true while an encode is in progress.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Returns true if @p config exports the recording as encoded.
+     *
+     * False when the export settings differ from the recording (another
+     * volume, take or length): the export then mixes as usual. Valid from
+     * finish() on, while the last seconds are still encoding.
+     */
+    bool matches(const ExportConfig &config) const;
+
+    /**
+     * @brief Returns the soundtrack of the last encode, empty if it failed
+     * or is still running.
+     */
+    QString encodedAudio() const;
+
+    /**
+     * @brief Returns the encoded soundtrack if it was made for @p config.
+     */
+    QString encodedAudioFor(const ExportConfig &config) const;
+
+signals:
+    /**
+     * @brief Emitted when an encode started by start() ends.
+     * @param success True if the soundtrack is ready.
+     */
+    void finished(bool success);
+
+private:
+    /** State shared with the worker thread. */
+    struct LiveState {
+        std::atomic<qint64> finalDurationMs{ -1 };
+        std::atomic<bool> cancelled{ false };
+    };
+
+    /**
+     * @brief Worker: mixes @p mix as it grows into an FFmpeg AAC encoder.
+     * @return @p outputPath on success, an empty string otherwise.
+     */
+    static QString encode(const MixSettings &mix, const QString &outputPath,
+                          std::shared_ptr<LiveState> state);
+
+    ExportConfig m_config;      ///< Recording being encoded
+    qint64 m_durationMs;        ///< Length given to finish()
+    QString m_result;           ///< Soundtrack of the last successful encode
+    std::shared_ptr<LiveState> m_state;
+    QFutureWatcher<QString> *m_watcher;
+};
+
+#endif // LIVEEXPORTENCODER_H
@@ -0,0 +1,241 @@
+/**
+ * @file MediaProbe.cpp
+ * @brief Implementation of the MediaProbe helpers.
+ */
+
+#include "MediaProbe.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QtEndian>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// Window read around each cut point when looking for keyframes.
+// Covers the GOP length of any reasonable delivery format.
+constexpr double KEYFRAME_SEARCH_WINDOW_S = 30.0;
+
+// Packet times match a keyframe time within this (ffprobe prints 6 decimals)
+constexpr double PACKET_TIME_TOLERANCE_S = 0.001;
+
+constexpr int H264_NAL_SLICE = 1;
+constexpr int H264_NAL_IDR_SLICE = 5;
+
+QJsonObject runProbe(const QStringList &args, int timeoutMs)
+{
+    QProcess ffprobe;
+    ffprobe.start("ffprobe", args);
+    if (!ffprobe.waitForFinished(timeoutMs) || ffprobe.exitCode() != 0) {
+        qWarning() << "[MediaProbe] ffprobe failed:" << ffprobe.readAllStandardError();
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(ffprobe.readAllStandardOutput()).object();
+}
+
+double containerStartTime(const QString &path)
+{
+    QJsonObject format = runProbe(QStringList()
+        << "-v" << "error"
+        << "-show_entries" << "format=start_time"
+        << "-of" << "json"
+        << path, 10000).value("format").toObject();
+    return format.value("start_time").toString().toDouble();
+}
+
+/**
+ * Bytes of an ffprobe data dump: "offset: hex groups  ascii" lines, the
+ * hex groups padded to 40 columns.
+ */
+QByteArray parseHexDump(const QString &dump)
+{
+    QByteArray bytes;
+    for (const QString &line : dump.split('\n', Qt::SkipEmptyParts)) {
+        const int colon = line.indexOf(": ");
+        if (colon >= 0) {
+            bytes += QByteArray::fromHex(line.mid(colon + 2, 40).remove(' ').toLatin1());
+        }
+    }
+    return bytes;
+}
+
+/**
+ * Type of the first slice NAL unit of an H.264 access unit: Annex B start
+ * codes (MPEG-TS) or 4-byte lengths (MP4, MKV). 0 if there is none.
+ */
+int firstSliceType(const QByteArray &unit)
+{
+    auto isSlice = [](int type) { return type == H264_NAL_SLICE || type == H264_NAL_IDR_SLICE; };
+
+    if (unit.startsWith(QByteArray("\0\0\1", 3)) || unit.startsWith(QByteArray("\0\0\0\1", 4))) {
+        for (int i = 0; i + 3 < unit.size(); ++i) {
+            if (unit[i] == 0 && unit[i + 1] == 0 && unit[i + 2] == 1) {
+                const int type = unit[i + 3] & 0x1F;
+                if (isSlice(type)) {
+                    return type;
+                }
+            }
+        }
+        return 0;
+    }
+
+    for (qint64 pos = 0; pos + 4 < unit.size();) {
+        const quint32 length = qFromBigEndian<quint32>(unit.constData() + pos);
+        const int type = unit[pos + 4] & 0x1F;
+        if (isSlice(type)) {
+            return type;
+        }
+        pos += 4 + qint64(length);
+    }
+    return 0;
+}
+
+double parseRate(const QString &rate)
+{
+    // ffprobe reports rates as "num/den" (e.g. "30000/1001")
+    QStringList parts = rate.split('/');
+    if (parts.size() == 2 && parts[1].toDouble() > 0) {
+        return parts[0].toDouble() / parts[1].toDouble();
+    }
+    return rate.toDouble();
+}
+
+/**
+ * Runs ffprobe over the packets selected by @p intervalsFor (which receives
+ * the container start time) and keeps the keyframe timestamps.
+ */
+QList<double> readKeyframes(const QString &path,
+                            const std::function<QString(double)> &intervalsFor)
+{
+    // Packet timestamps are absolute, seeking with -ss is relative to the
+    // container start time: fetch it once to convert between the two.
+    double startTime = containerStartTime(path);
+
+    QJsonObject root = runProbe(QStringList()
+        << "-v" << "error"
+        << "-select_streams" << "v:0"
+        << "-read_intervals" << intervalsFor(startTime)
+        << "-show_entries" << "packet=pts_time,flags"
+        << "-of" << "json"
+        << path, 120000);
+
+    QList<double> keyframes;
+    for (const QJsonValue &value : root.value("packets").toArray()) {
+        QJsonObject packet = value.toObject();
+        if (!packet.value("flags").toString().contains('K')) {
+            continue;
+        }
+        bool ok = false;
+        double pts = packet.value("pts_time").toString().toDouble(&ok);
+        if (ok) {
+            keyframes.append(pts - startTime);
+        }
+    }
+
+    std::sort(keyframes.begin(), keyframes.end());
+    keyframes.erase(std::unique(keyframes.begin(), keyframes.end()), keyframes.end());
+    return keyframes;
+}
+
+} // namespace
+
+namespace MediaProbe {
+
+MediaInfo probe(const QString &path)
+{
+    MediaInfo info;
+
+    QJsonObject root = runProbe(QStringList()
+        << "-v" << "error"
+        << "-show_entries"
+        << "stream=codec_type,codec_name,profile,level,width,height,avg_frame_rate,"
+           "r_frame_rate,pix_fmt"
+           ":format=duration"
+        << "-of" << "json"
+        << path, 10000);
+
+    for (const QJsonValue &value : root.value("streams").toArray()) {
+        QJsonObject stream = value.toObject();
+        QString type = stream.value("codec_type").toString();
+
+        if (type == "video" && !info.valid) {
+            info.valid = true;
+            info.videoCodec = stream.value("codec_name").toString();
+            info.pixelFormat = stream.value("pix_fmt").toString();
+            info.profile = stream.value("profile").toString();
+            info.level = qMax(0, stream.value("level").toInt());
+            info.width = stream.value("width").toInt();
+            info.height = stream.value("height").toInt();
+            info.frameRateText = stream.value("avg_frame_rate").toString();
+            info.frameRate = parseRate(info.frameRateText);
+            if (info.frameRate <= 0) {
+                info.frameRateText = stream.value("r_frame_rate").toString();
+                info.frameRate = parseRate(info.frameRateText);
+            }
+        } else if (type == "audio") {
+            info.hasAudio = true;
+        }
+    }
+
+    double durationS = root.value("format").toObject().value("duration").toString().toDouble();
+    info.durationMs = static_cast<qint64>(durationS * 1000.0);
+
+    return info;
+}
+
+QList<double> keyframesNear(const QString &path, qint64 startMs, qint64 endMs)
+{
+    return readKeyframes(path, [startMs, endMs](double startTime) {
+        double start = startMs / 1000.0 + startTime;
+        double end = endMs / 1000.0 + startTime;
+        double tailFrom = std::max(start, end - KEYFRAME_SEARCH_WINDOW_S);
+
+        return QString("%1%+%2,%3%%4")
+            .arg(start, 0, 'f', 3)
+            .arg(KEYFRAME_SEARCH_WINDOW_S, 0, 'f', 3)
+            .arg(tailFrom, 0, 'f', 3)
+            .arg(end + 1.0, 0, 'f', 3);
+    });
+}
+
+QList<double> keyframesInRange(const QString &path, qint64 startMs, qint64 endMs)
+{
+    return readKeyframes(path, [startMs, endMs](double startTime) {
+        return QString("%1%%2")
+            .arg(startMs / 1000.0 + startTime, 0, 'f', 3)
+            .arg(endMs / 1000.0 + startTime + 1.0, 0, 'f', 3);
+    });
+}
+
+bool isIdrKeyframe(const QString &path, double timeS)
+{
+    // Seeking onto a keyframe time lands on that packet: read it alone
+    const double startTime = containerStartTime(path);
+    QJsonObject root = runProbe(QStringList()
+        << "-v" << "error"
+        << "-select_streams" << "v:0"
+        << "-read_intervals" << QString("%1%+#1").arg(timeS + startTime, 0, 'f', 6)
+        << "-show_entries" << "packet=pts_time,data"
+        << "-show_data"
+        << "-of" << "json"
+        << path, 30000);
+
+    const QJsonArray packets = root.value("packets").toArray();
+    if (packets.isEmpty()) {
+        return false;
+    }
+    const QJsonObject packet = packets.first().toObject();
+    bool ok = false;
+    const double pts = packet.value("pts_time").toString().toDouble(&ok) - startTime;
+    if (!ok || qAbs(pts - timeS) > PACKET_TIME_TOLERANCE_S) {
+        return false;
+    }
+    return firstSliceType(parseHexDump(packet.value("data").toString())) == H264_NAL_IDR_SLICE;
+}
+
+} // namespace MediaProbe
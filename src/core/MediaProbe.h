@@ -0,0 +1,100 @@
+/**
+ * @file MediaProbe.h
+ * @brief Synchronous media inspection helpers built on ffprobe.
+ *
+ * These functions spawn ffprobe and block until it returns, so they are
+ * meant to be called from worker threads (QtConcurrent), never from the
+ * GUI thread.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note Requires ffprobe (shipped with FFmpeg) to be available in PATH.
+ */
+
+#ifndef MEDIAPROBE_H
+#define MEDIAPROBE_H
+
+#include <QList>
+#include <QString>
+
+/**
+ * @struct MediaInfo
+ * @brief Stream properties of a media file, as reported by ffprobe.
+ */
+struct MediaInfo {
+    bool valid;                 ///< false if ffprobe failed or found no video
+    QString videoCodec;         ///< e.g. "h264", "hevc"
+    QString pixelFormat;        ///< e.g. "yuv420p"
+    QString profile;            ///< e.g. "High", "Constrained Baseline"
+    int level;                  ///< Codec level x 10 (e.g. 40 for 4.0), 0 if unknown
+    int width;                  ///< Video width in pixels
+    int height;                 ///< Video height in pixels
+    double frameRate;           ///< Average frame rate (FPS)
+    QString frameRateText;      ///< Exact frame rate as "num/den"
+    qint64 durationMs;          ///< Container duration in milliseconds
+    bool hasAudio;              ///< true if at least one audio stream exists
+
+    MediaInfo()
+        : valid(false)
+        , level(0)
+        , width(0)
+        , height(0)
+        , frameRate(0.0)
+        , durationMs(0)
+        , hasAudio(false)
+    {}
+};
+
+/**
+ * @namespace MediaProbe
+ * @brief Blocking ffprobe wrappers used by export planning.
+ */
+namespace MediaProbe {
+
+/**
+ * @brief Reads codec, geometry, frame rate and duration of a media file.
+ * @param path Local file path (or FFmpeg input URL).
+ * @return Probed information; MediaInfo::valid is false on failure.
+ */
+MediaInfo probe(const QString &path);
+
+/**
+ * @brief Lists video keyframe timestamps close to the given cut points.
+ *
+ * Only packet headers are read (no decoding) and only around @p startMs and
+ * @p endMs, so this runs at demux speed even on feature-length files.
+ *
+ * @param path Local file path (or FFmpeg input URL).
+ * @param startMs Start of the range of interest in milliseconds.
+ * @param endMs End of the range of interest in milliseconds.
+ * @return Sorted keyframe presentation times in seconds.
+ */
+QList<double> keyframesNear(const QString &path, qint64 startMs, qint64 endMs);
+
+/**
+ * @brief Lists every video keyframe timestamp inside a range.
+ *
+ * Reads packet headers only (no decoding) from @p startMs to @p endMs.
+ *
+ * @param path Local file path (or FFmpeg input URL).
+ * @param startMs Start of the range in milliseconds.
+ * @param endMs End of the range in milliseconds.
+ * @return Sorted keyframe presentation times in seconds.
+ */
+QList<double> keyframesInRange(const QString &path, qint64 startMs, qint64 endMs);
+
+/**
+ * @brief Returns true if the H.264 keyframe at @p timeS is an IDR picture.
+ *
+ * Keyframe flags also mark open-GOP recovery points, whose leading frames
+ * reference the previous GOP: a stream copy cannot start there. Reads that
+ * one packet and looks for an IDR slice in its NAL units.
+ *
+ * @param path Local file path (or FFmpeg input URL).
+ * @param timeS Keyframe time as returned by keyframesNear(), in seconds.
+ * @return false if it is not an IDR, or cannot be read.
+ */
+bool isIdrKeyframe(const QString &path, double timeS);
+
+} // namespace MediaProbe
+
+#endif // MEDIAPROBE_H
@@ -0,0 +1,151 @@
+/**
+ * @file MediaRelink.cpp
+ * @brief Implementation of MediaRelink functions.
+ */
+
+#include "MediaRelink.h"
+#include "ExportCache.h"
+#include "MediaSource.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+namespace {
+
+bool matches(const QFileInfo &info, const MediaRelink::Identity &identity)
+{
+    // The size is free (already in the directory entry): only files of
+    // exactly the right size are read
+    return info.isFile() && info.size() == identity.size
+           && ExportCache::fingerprint(info.absoluteFilePath()) == identity.fingerprint;
+}
+
+} // namespace
+
+namespace MediaRelink {
+
+Identity identify(const QString &source)
+{
+    Identity identity;
+    MediaSource::ArchiveRange range;
+    if (MediaSource::parse(source, range)) {
+        identity.size = range.size;
+    } else {
+        identity.size = QFileInfo(source).size();
+    }
+    identity.fingerprint = ExportCache::fingerprint(source);
+    if (identity.fingerprint.isEmpty()) {
+        return Identity();
+    }
+    return identity;
+}
+
+QStringList searchRoots(const QString &projectPath, const QString &missingPath)
+{
+    QStringList roots;
+    auto add = [&roots](const QString &path) {
+        if (path.isEmpty()) {
+            return;
+        }
+        QString clean = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+        if (QFileInfo(clean).isDir() && !roots.contains(clean)) {
+            roots.append(clean);
+        }
+    };
+
+    // Next to the project, and the folder it was moved with
+    if (!projectPath.isEmpty()) {
+        QDir projectDir = QFileInfo(projectPath).dir();
+        add(projectDir.path());
+        if (projectDir.cdUp()) {
+            add(projectDir.path());
+        }
+    }
+
+    // The closest folder of the old path that still exists (renamed
+    // sub-folder, remounted drive)
+    if (!missingPath.isEmpty() && !MediaSource::isArchived(missingPath)) {
+        QString oldDir = QFileInfo(missingPath).absolutePath();
+        while (!QFileInfo(oldDir).isDir()) {
+            const QString parent = QFileInfo(oldDir).path();
+            if (parent == oldDir) {
+                break;
+            }
+            oldDir = parent;
+        }
+        if (!QDir(oldDir).isRoot()) {
+            add(oldDir);
+        }
+    }
+
+    add(QStandardPaths::writableLocation(QStandardPaths::MoviesLocation));
+    add(QStandardPaths::writableLocation(QStandardPaths::DownloadLocation));
+    add(QStandardPaths::writableLocation(QStandardPaths::DesktopLocation));
+    add(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation));
+    add(QStandardPaths::writableLocation(QStandardPaths::HomeLocation));
+    return roots;
+}
+
+QString find(const Identity &identity, const QString &fileName, const QStringList &roots,
+             const std::atomic<bool> *cancel)
+{
+    if (!identity.isValid()) {
+        return QString();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Moved along with its name: one lookup per root
+    if (!fileName.isEmpty()) {
+        for (const QString &root : roots) {
+            QFileInfo candidate(QDir(root).filePath(fileName));
+            if (matches(candidate, identity)) {
+                qDebug() << "[MediaRelink] Found" << candidate.absoluteFilePath() << "in"
+                         << timer.elapsed() << "ms";
+                return candidate.absoluteFilePath();
+            }
+        }
+    }
+
+    // Renamed: walk every root, one worker each; roots may overlap (home
+    // holds the others), the most likely ones still finish first
+    std::atomic<bool> done{ false };
+    QMutex resultMutex;
+    QString result;
+    auto stopped = [&]() {
+        return done.load() || (cancel && cancel->load())
+               || timer.elapsed() > SEARCH_TIMEOUT_MS;
+    };
+
+    QStringList walked = roots;
+    QtConcurrent::blockingMap(walked, [&](const QString &root) {
+        QDirIterator it(root, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (!stopped() && it.hasNext()) {
+            it.next();
+            if (matches(it.fileInfo(), identity)) {
+                QMutexLocker lock(&resultMutex);
+                if (!done.exchange(true)) {
+                    result = it.filePath();
+                }
+                return;
+            }
+        }
+    });
+
+    if (result.isEmpty()) {
+        qDebug() << "[MediaRelink] No match after" << timer.elapsed() << "ms";
+    } else {
+        qDebug() << "[MediaRelink] Found" << result << "in" << timer.elapsed() << "ms";
+    }
+    return result;
+}
+
+} // namespace MediaRelink
@@ -0,0 +1,70 @@
+/**
+ * @file MediaRelink.h
+ * @brief Finds a project's video again after it was moved or copied.
+ *
+ * A saved project records the size and content fingerprint of its video
+ * (see ExportCache::fingerprint). When the stored path no longer exists,
+ * the likely places (around the project, around the old path, the
+ * user's video, download and desktop folders) are searched in parallel,
+ * one worker per directory. Only files of exactly the right size are
+ * fingerprinted, and the first match stops every worker.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note Blocking: run find() off the GUI thread.
+ */
+
+#ifndef MEDIARELINK_H
+#define MEDIARELINK_H
+
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+
+namespace MediaRelink {
+
+/** @brief A search gives up after this long. */
+constexpr int SEARCH_TIMEOUT_MS = 15 * 1000;
+
+/**
+ * @struct Identity
+ * @brief What a video is, wherever it lies.
+ */
+struct Identity {
+    qint64 size = 0;
+    QString fingerprint;    ///< ExportCache::fingerprint() of the content
+
+    bool isValid() const { return size > 0 && !fingerprint.isEmpty(); }
+};
+
+/**
+ * @brief Returns the identity of a video (plain file or archived source).
+ * @return An invalid identity if the video cannot be read.
+ */
+Identity identify(const QString &source);
+
+/**
+ * @brief Directories worth searching for a missing video, most likely first.
+ * @param projectPath The project being loaded (may be empty).
+ * @param missingPath Where the video used to be.
+ */
+QStringList searchRoots(const QString &projectPath, const QString &missingPath);
+
+/**
+ * @brief Searches @p roots and their sub-directories for the video.
+ *
+ * Files named like the original are checked first, then every root is
+ * walked by its own worker thread.
+ *
+ * @param identity Size and fingerprint recorded in the project.
+ * @param fileName Original file name, tried first in each root.
+ * @param roots Directories to search (see searchRoots()).
+ * @param cancel Optional: set to stop the search.
+ * @return Path of the match, or an empty string.
+ */
+QString find(const Identity &identity, const QString &fileName, const QStringList &roots,
+             const std::atomic<bool> *cancel = nullptr);
+
+} // namespace MediaRelink
+
+#endif // MEDIARELINK_H
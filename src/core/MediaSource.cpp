@@ -0,0 +1,134 @@
+/**
+ * @file MediaSource.cpp
+ * @brief Implementation of MediaSource functions.
+ */
+
+#include "MediaSource.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QRegularExpression>
+
+namespace {
+
+const QString SUBFILE_PREFIX = QStringLiteral("subfile,,");
+
+/**
+ * @class ArchiveEntryDevice
+ * @brief Read-only window over a byte range of a file.
+ */
+class ArchiveEntryDevice : public QIODevice {
+public:
+    ArchiveEntryDevice(const MediaSource::ArchiveRange &range, QObject *parent)
+        : QIODevice(parent)
+        , m_file(range.archivePath)
+        , m_offset(range.offset)
+        , m_size(range.size)
+    {
+    }
+
+    bool open(OpenMode mode) override
+    {
+        if ((mode & WriteOnly) || !m_file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        // Unbuffered: QFile already buffers, and pos() is then the device position
+        return QIODevice::open(mode | Unbuffered);
+    }
+
+    void close() override
+    {
+        QIODevice::close();
+        m_file.close();
+    }
+
+    bool isSequential() const override { return false; }
+
+    qint64 size() const override { return m_size; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        const qint64 wanted = qMin(maxSize, m_size - pos());
+        if (wanted <= 0) {
+            return 0;
+        }
+        if (!m_file.seek(m_offset + pos())) {
+            return -1;
+        }
+        return m_file.read(data, wanted);
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    QFile m_file;
+    qint64 m_offset;
+    qint64 m_size;
+};
+
+} // namespace
+
+namespace MediaSource {
+
+QString archiveSource(const QString &archivePath, qint64 offset, qint64 size)
+{
+    return QString("%1start,%2,end,%3,,:%4")
+        .arg(SUBFILE_PREFIX)
+        .arg(offset)
+        .arg(offset + size)
+        .arg(QFileInfo(archivePath).absoluteFilePath());
+}
+
+bool isArchived(const QString &source)
+{
+    return source.startsWith(SUBFILE_PREFIX);
+}
+
+bool parse(const QString &source, ArchiveRange &range)
+{
+    static const QRegularExpression pattern(
+        QStringLiteral("^subfile,,start,(\\d+),end,(\\d+),,:(.+)$"));
+    const QRegularExpressionMatch match = pattern.match(source);
+    if (!match.hasMatch()) {
+        return false;
+    }
+    const qint64 start = match.captured(1).toLongLong();
+    const qint64 end = match.captured(2).toLongLong();
+    if (end < start) {
+        return false;
+    }
+    range.archivePath = match.captured(3);
+    range.offset = start;
+    range.size = end - start;
+    return true;
+}
+
+bool exists(const QString &source)
+{
+    ArchiveRange range;
+    if (!parse(source, range)) {
+        return QFile::exists(source);
+    }
+    QFileInfo info(range.archivePath);
+    return info.isFile() && range.offset + range.size <= info.size();
+}
+
+QIODevice *openDevice(const QString &source, QObject *parent)
+{
+    ArchiveRange range;
+    if (!parse(source, range) || !exists(source)) {
+        return nullptr;
+    }
+    auto *device = new ArchiveEntryDevice(range, parent);
+    if (!device->open(QIODevice::ReadOnly)) {
+        qWarning() << "[MediaSource] Cannot open" << range.archivePath;
+        delete device;
+        return nullptr;
+    }
+    return device;
+}
+
+} // namespace MediaSource
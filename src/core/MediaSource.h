@@ -0,0 +1,68 @@
+/**
+ * @file MediaSource.h
+ * @brief Addresses a video that is a plain file or an entry of a project archive.
+ *
+ * A video stored (uncompressed) in a project .zip is not extracted: it is a
+ * byte range of the archive. Such a source is written as FFmpeg's subfile
+ * URL, `subfile,,start,<first byte>,end,<past last byte>,,:<archive>`, so
+ * exports, probes and saved projects pass it around like any path and
+ * FFmpeg reads the range in place. Playback opens it as a seekable
+ * QIODevice over the same range.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ */
+
+#ifndef MEDIASOURCE_H
+#define MEDIASOURCE_H
+
+#include <QString>
+
+class QIODevice;
+class QObject;
+
+namespace MediaSource {
+
+/**
+ * @struct ArchiveRange
+ * @brief Where an archived video lies.
+ */
+struct ArchiveRange {
+    QString archivePath;
+    qint64 offset = 0;      ///< First byte of the video in the archive
+    qint64 size = 0;
+};
+
+/**
+ * @brief Builds the source of @p size bytes at @p offset in @p archivePath.
+ */
+QString archiveSource(const QString &archivePath, qint64 offset, qint64 size);
+
+/**
+ * @brief Returns true if @p source is a byte range of an archive.
+ */
+bool isArchived(const QString &source);
+
+/**
+ * @brief Splits an archived source; returns false for a plain path.
+ */
+bool parse(const QString &source, ArchiveRange &range);
+
+/**
+ * @brief Returns true if the file exists (for an archive: and holds the range).
+ */
+bool exists(const QString &source);
+
+/**
+ * @brief Opens an archived source as a read-only, seekable device.
+ *
+ * Reads go straight to the archive at the entry's offset: nothing is
+ * copied or extracted. size() is the video size and positions are
+ * relative to the video.
+ *
+ * @return Open device owned by @p parent, or nullptr on error.
+ */
+QIODevice *openDevice(const QString &source, QObject *parent = nullptr);
+
+} // namespace MediaSource
+
+#endif // MEDIASOURCE_H
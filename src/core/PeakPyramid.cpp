@@ -0,0 +1,309 @@
+/**
+ * @file PeakPyramid.cpp
+ * @brief Implementation of the PeakPyramid class.
+ */
+
+#include "PeakPyramid.h"
+#include "AudioMixer.h"
+#include "DecodedAudio.h"
+#include "ExportCache.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTemporaryFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define DUBINSTANTE_PEAK_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DUBINSTANTE_PEAK_NEON
+#endif
+
+namespace {
+
+// File layout (cache only, never leaves the machine: peaks in native order)
+//   char[8] magic | u32 sample rate | u32 base frames | u64 frame count
+//   u32 level count | u32 reserved | level count x u64 buckets
+//   levels, finest first: buckets x { i16 min | i16 max }
+const char MAGIC[8] = { 'D', 'B', 'I', 'P', 'E', 'A', 'K', '1' };
+constexpr qint64 HEADER_SIZE = 8 + 4 + 4 + 8 + 4 + 4;
+constexpr quint32 MAX_LEVELS = 48;
+
+const QString CACHE_KIND = QStringLiteral("peaks");
+const QString CACHE_SUFFIX = QStringLiteral("peaks");
+
+/** Lowest and highest of @p count floats (> 0), four at a time when possible. */
+void reducePeaks(const float *samples, qsizetype count, float &lo, float &hi)
+{
+    qsizetype i = 0;
+    lo = hi = samples[0];
+#if defined(DUBINSTANTE_PEAK_SSE)
+    if (count >= 4) {
+        __m128 vlo = _mm_loadu_ps(samples);
+        __m128 vhi = vlo;
+        for (i = 4; i + 4 <= count; i += 4) {
+            const __m128 v = _mm_loadu_ps(samples + i);
+            vlo = _mm_min_ps(vlo, v);
+            vhi = _mm_max_ps(vhi, v);
+        }
+        float los[4], his[4];
+        _mm_storeu_ps(los, vlo);
+        _mm_storeu_ps(his, vhi);
+        lo = std::min({ los[0], los[1], los[2], los[3] });
+        hi = std::max({ his[0], his[1], his[2], his[3] });
+    }
+#elif defined(DUBINSTANTE_PEAK_NEON)
+    if (count >= 4) {
+        float32x4_t vlo = vld1q_f32(samples);
+        float32x4_t vhi = vlo;
+        for (i = 4; i + 4 <= count; i += 4) {
+            const float32x4_t v = vld1q_f32(samples + i);
+            vlo = vminq_f32(vlo, v);
+            vhi = vmaxq_f32(vhi, v);
+        }
+        float los[4], his[4];
+        vst1q_f32(los, vlo);
+        vst1q_f32(his, vhi);
+        lo = std::min({ los[0], los[1], los[2], los[3] });
+        hi = std::max({ his[0], his[1], his[2], his[3] });
+    }
+#endif
+    for (; i < count; ++i) {
+        lo = std::min(lo, samples[i]);
+        hi = std::max(hi, samples[i]);
+    }
+}
+
+qint16 toPeak(float value)
+{
+    return static_cast<qint16>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+/** Next level: each bucket is the min/max of two buckets of @p finer. */
+std::vector<qint16> halve(const std::vector<qint16> &finer)
+{
+    const size_t buckets = finer.size() / 2;
+    std::vector<qint16> coarser(((buckets + 1) / 2) * 2);
+    for (size_t i = 0; i + 1 < buckets; i += 2) {
+        coarser[i] = std::min(finer[2 * i], finer[2 * i + 2]);
+        coarser[i + 1] = std::max(finer[2 * i + 1], finer[2 * i + 3]);
+    }
+    if (buckets % 2) {
+        coarser[coarser.size() - 2] = finer[finer.size() - 2];
+        coarser[coarser.size() - 1] = finer[finer.size() - 1];
+    }
+    return coarser;
+}
+
+template <typename T> void appendLittleEndian(QByteArray &bytes, T value)
+{
+    value = qToLittleEndian(value);
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
+PeakPyramid::PeakPyramid()
+    : m_map(nullptr)
+    , m_sampleRate(AudioMixer::SAMPLE_RATE)
+    , m_frameCount(0)
+{
+}
+
+PeakPyramid::~PeakPyramid()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+}
+
+std::shared_ptr<const PeakPyramid> PeakPyramid::load(const QString &source,
+                                                     const std::atomic<bool> *cancelled)
+{
+    const QString fingerprint = ExportCache::fingerprint(source);
+    if (fingerprint.isEmpty()) {
+        return nullptr;
+    }
+
+    QString path = ExportCache::lookup(CACHE_KIND, fingerprint, CACHE_SUFFIX);
+    if (std::shared_ptr<const PeakPyramid> cached = open(path)) {
+        return cached;
+    }
+    path = build(source, fingerprint, cancelled);
+    return path.isEmpty() ? nullptr : open(path);
+}
+
+QString PeakPyramid::build(const QString &source, const QString &fingerprint,
+                           const std::atomic<bool> *cancelled)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Level 0, straight from the shared decoded audio (mapped, decoded once
+    // for every analysis of this source)
+    const std::shared_ptr<const DecodedAudio> audio = DecodedAudio::load(source, cancelled);
+    if (!audio) {
+        return QString();
+    }
+    const qint64 frameCount = audio->frameCount();
+    const qint64 bucketCount = (frameCount + BASE_FRAMES - 1) / BASE_FRAMES;
+    std::vector<qint16> base(static_cast<size_t>(bucketCount) * 2);
+    for (qint64 b = 0; b < bucketCount; ++b) {
+        if (cancelled && (b & 0xFFFF) == 0 && *cancelled) {
+            return QString();
+        }
+        const qint64 first = b * BASE_FRAMES;
+        const qint64 frames = qMin<qint64>(BASE_FRAMES, frameCount - first);
+        float lo, hi;
+        reducePeaks(audio->samples() + first * AudioMixer::CHANNELS,
+                    frames * AudioMixer::CHANNELS, lo, hi);
+        base[2 * b] = toPeak(lo);
+        base[2 * b + 1] = toPeak(hi);
+    }
+
+    std::vector<std::vector<qint16>> levels;
+    levels.push_back(std::move(base));
+    while (levels.back().size() > 2 && levels.size() < MAX_LEVELS) {
+        std::vector<qint16> next = halve(levels.back());
+        levels.push_back(std::move(next));
+    }
+
+    QByteArray header(MAGIC, sizeof(MAGIC));
+    appendLittleEndian<quint32>(header, AudioMixer::SAMPLE_RATE);
+    appendLittleEndian<quint32>(header, BASE_FRAMES);
+    appendLittleEndian<quint64>(header, static_cast<quint64>(frameCount));
+    appendLittleEndian<quint32>(header, static_cast<quint32>(levels.size()));
+    appendLittleEndian<quint32>(header, 0);
+    for (const std::vector<qint16> &level : levels) {
+        appendLittleEndian<quint64>(header, level.size() / 2);
+    }
+
+    // Written aside, then moved into the cache in one rename
+    QTemporaryFile file(QDir(ExportCache::workDirectory()).filePath("peaks-XXXXXX"));
+    file.setAutoRemove(false);
+    bool written = file.open() && file.write(header) == header.size();
+    for (const std::vector<qint16> &level : levels) {
+        const qint64 bytes = static_cast<qint64>(level.size() * sizeof(qint16));
+        written = written
+                  && file.write(reinterpret_cast<const char *>(level.data()), bytes) == bytes;
+    }
+    file.close();
+    const QString path = written
+                             ? ExportCache::insert(CACHE_KIND, fingerprint, CACHE_SUFFIX,
+                                                   file.fileName())
+                             : QString();
+    if (path.isEmpty()) {
+        QFile::remove(file.fileName());
+        qWarning() << "[PeakPyramid] Cannot write peaks of" << source;
+        return QString();
+    }
+
+    qDebug() << "[PeakPyramid] Built" << levels.size() << "levels for"
+             << static_cast<double>(frameCount) / AudioMixer::SAMPLE_RATE << "s of" << source
+             << "in" << timer.elapsed() << "ms";
+    return path;
+}
+
+std::shared_ptr<const PeakPyramid> PeakPyramid::open(const QString &path)
+{
+    if (path.isEmpty()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<PeakPyramid> pyramid(new PeakPyramid());
+    pyramid->m_file.setFileName(path);
+    if (!pyramid->m_file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    const qint64 size = pyramid->m_file.size();
+    if (size < HEADER_SIZE) {
+        return nullptr;
+    }
+    pyramid->m_map = pyramid->m_file.map(0, size);
+    const uchar *map = pyramid->m_map;
+    if (!map || std::memcmp(map, MAGIC, sizeof(MAGIC)) != 0
+        || qFromLittleEndian<quint32>(map + 12) != quint32(BASE_FRAMES)) {
+        return nullptr;
+    }
+    pyramid->m_sampleRate = qFromLittleEndian<quint32>(map + 8);
+    pyramid->m_frameCount = static_cast<qint64>(qFromLittleEndian<quint64>(map + 16));
+    const quint32 levelCount = qFromLittleEndian<quint32>(map + 24);
+    if (pyramid->m_sampleRate <= 0 || levelCount == 0 || levelCount > MAX_LEVELS
+        || size < HEADER_SIZE + qint64(levelCount) * 8) {
+        return nullptr;
+    }
+
+    // Every level must lie inside the file
+    qint64 offset = HEADER_SIZE + qint64(levelCount) * 8;
+    for (quint32 i = 0; i < levelCount; ++i) {
+        const quint64 buckets = qFromLittleEndian<quint64>(map + HEADER_SIZE + i * 8);
+        if (buckets == 0 || buckets > quint64(size - offset) / 4) {
+            return nullptr;
+        }
+        Level level;
+        level.peaks = reinterpret_cast<const qint16 *>(map + offset);
+        level.count = static_cast<qint64>(buckets);
+        pyramid->m_levels.append(level);
+        offset += level.count * 4;
+    }
+    return pyramid;
+}
+
+qint64 PeakPyramid::durationMs() const
+{
+    return m_frameCount * 1000 / m_sampleRate;
+}
+
+QVector<PeakPyramid::Peak> PeakPyramid::query(qint64 startMs, qint64 endMs, int columns) const
+{
+    QVector<Peak> result(qMax(columns, 0));
+    if (columns <= 0 || endMs <= startMs || m_levels.isEmpty()) {
+        return result;
+    }
+
+    const double startFrame = static_cast<double>(startMs) * m_sampleRate / 1000.0;
+    const double framesPerColumn =
+        static_cast<double>(endMs - startMs) * m_sampleRate / 1000.0 / columns;
+
+    // Coarsest level whose buckets are no wider than a column: each column
+    // then reduces a handful of buckets
+    int index = 0;
+    while (index + 1 < m_levels.size()
+           && static_cast<double>(qint64(BASE_FRAMES) << (index + 1)) <= framesPerColumn) {
+        ++index;
+    }
+    const Level &level = m_levels.at(index);
+    const double bucketFrames = static_cast<double>(qint64(BASE_FRAMES) << index);
+
+    for (int c = 0; c < columns; ++c) {
+        const double from = startFrame + c * framesPerColumn;
+        const double to = from + framesPerColumn;
+        if (to <= 0.0 || from >= m_frameCount) {
+            continue;   // Outside the audio: silence
+        }
+        const qint64 first = qMax<qint64>(0, static_cast<qint64>(std::floor(from / bucketFrames)));
+        const qint64 last = qMin(level.count,
+                                 qMax(first + 1, static_cast<qint64>(std::ceil(to / bucketFrames))));
+        if (first >= last) {
+            continue;
+        }
+
+        qint16 lo = level.peaks[2 * first];
+        qint16 hi = level.peaks[2 * first + 1];
+        for (qint64 b = first + 1; b < last; ++b) {
+            lo = std::min(lo, level.peaks[2 * b]);
+            hi = std::max(hi, level.peaks[2 * b + 1]);
+        }
+        result[c].min = lo / 32767.0f;
+        result[c].max = hi / 32767.0f;
+    }
+    return result;
+}
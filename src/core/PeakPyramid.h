@@ -0,0 +1,108 @@
+/**
+ * @file PeakPyramid.h
+ * @brief Multi-resolution min/max peaks of an audio track, for waveforms.
+ *
+ * The audio (see DecodedAudio) is reduced to the min and max of every
+ * BASE_FRAMES frames (level 0). Each further level halves the previous
+ * one, down to a single bucket, so the whole pyramid is less than twice
+ * level 0 (about 5 MiB per hour). Whatever the zoom, a column of pixels
+ * covers one to three buckets of the right level: drawing costs
+ * O(visible pixels), never O(samples).
+ *
+ * Pyramids are stored in the export cache under the content fingerprint
+ * of their source and memory-mapped when opened: a reopened project, a
+ * copied take or a video played from an archive finds its peaks at once.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note build() is blocking: run it off the GUI thread. An opened pyramid
+ *       is read-only and may be queried from any thread.
+ */
+
+#ifndef PEAKPYRAMID_H
+#define PEAKPYRAMID_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class PeakPyramid
+ * @brief Memory-mapped peak pyramid of one audio source.
+ *
+ * @example
+ * @code
+ * // Worker thread
+ * std::shared_ptr<const PeakPyramid> peaks = PeakPyramid::load(videoPath);
+ *
+ * // Paint event: one min/max pair per column
+ * QVector<PeakPyramid::Peak> columns = peaks->query(startMs, endMs, width());
+ * @endcode
+ */
+class PeakPyramid {
+public:
+    /** @brief Frames reduced into one level-0 bucket (5.3 ms at 48 kHz). */
+    static constexpr int BASE_FRAMES = 256;
+
+    /**
+     * @struct Peak
+     * @brief Lowest and highest sample of a span, both channels, in [-1, 1].
+     */
+    struct Peak {
+        float min = 0.0f;
+        float max = 0.0f;
+    };
+
+    ~PeakPyramid();
+
+    PeakPyramid(const PeakPyramid &) = delete;
+    PeakPyramid &operator=(const PeakPyramid &) = delete;
+
+    /**
+     * @brief Returns the pyramid of @p source, building it on first use.
+     * @param source Media file (video, take...) or archived source.
+     * @param cancelled Optional: aborts the build when set.
+     * @return nullptr if the audio cannot be decoded (or on cancel).
+     */
+    static std::shared_ptr<const PeakPyramid> load(const QString &source,
+                                                   const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * @brief Maps an existing pyramid file.
+     * @return nullptr if missing or invalid.
+     */
+    static std::shared_ptr<const PeakPyramid> open(const QString &path);
+
+    /** @brief Audio length in milliseconds. */
+    qint64 durationMs() const;
+
+    /**
+     * @brief Returns one peak per column for [startMs, endMs).
+     *
+     * Columns outside the audio (before 0, past the end) are silent.
+     *
+     * @param columns Number of columns (usually pixels) to split the span in.
+     */
+    QVector<Peak> query(qint64 startMs, qint64 endMs, int columns) const;
+
+private:
+    struct Level {
+        const qint16 *peaks = nullptr;  ///< Interleaved min, max
+        qint64 count = 0;               ///< Buckets
+    };
+
+    PeakPyramid();
+
+    static QString build(const QString &source, const QString &fingerprint,
+                         const std::atomic<bool> *cancelled);
+
+    QFile m_file;
+    uchar *m_map;
+    qint64 m_sampleRate;
+    qint64 m_frameCount;
+    QVector<Level> m_levels;
+};
+
+#endif // PEAKPYRAMID_H
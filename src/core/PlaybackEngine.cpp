@@ -4,15 +4,83 @@
  */
 
 #include "PlaybackEngine.h"
+#include "ExportCache.h"
+#include "FrameCache.h"
+#include "KeyframeIndex.h"
+#include "MediaSource.h"
+#include "ProxyGenerator.h"
 
+#include <QFutureWatcher>
 #include <QMediaMetaData>
+#include <QTimer>
 #include <QVideoSink>
+#include <QtConcurrent>
+
+#include <cmath>
 
 PlaybackEngine::PlaybackEngine(QObject *parent)
     : QObject(parent), m_mediaPlayer(new QMediaPlayer(this)),
-      m_audioOutput(new QAudioOutput(this)) {
+      m_audioOutput(new QAudioOutput(this)), m_sourceDevice(nullptr),
+      m_scrubTimer(new QTimer(this)), m_scrubTarget(0),
+      m_frameCache(new FrameCache(this)), m_fillTimer(new QTimer(this)),
+      m_proxyGenerator(new ProxyGenerator(this)), m_resumePosition(-1),
+      m_resumePlaying(false) {
   m_mediaPlayer->setAudioOutput(m_audioOutput);
   m_audioOutput->setVolume(1.0f);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 10, 0)
+  // Slowed-down rehearsals keep the actors' pitch
+  m_mediaPlayer->setPitchCompensation(true);
+#endif
+
+  m_scrubTimer->setSingleShot(true);
+  m_scrubTimer->setInterval(SCRUB_SETTLE_MS);
+  connect(m_scrubTimer, &QTimer::timeout, this,
+          [this]() { m_mediaPlayer->setPosition(m_scrubTarget); });
+
+  // Frame cache: filled around a paused position once it stays put, never
+  // while playing (the worker would compete with the player's decoder)
+  m_fillTimer->setSingleShot(true);
+  m_fillTimer->setInterval(FILL_DELAY_MS);
+  connect(m_fillTimer, &QTimer::timeout, this, [this]() {
+    if (m_mediaPlayer->playbackState() != QMediaPlayer::PlayingState)
+      m_frameCache->fill(targetPosition());
+  });
+  connect(m_mediaPlayer, &QMediaPlayer::positionChanged, this, [this]() {
+    if (m_mediaPlayer->playbackState() != QMediaPlayer::PlayingState)
+      m_fillTimer->start();
+  });
+  connect(m_mediaPlayer, &QMediaPlayer::playbackStateChanged, this,
+          [this](QMediaPlayer::PlaybackState state) {
+            if (state == QMediaPlayer::PlayingState) {
+              m_fillTimer->stop();
+              m_frameCache->cancel();
+            } else {
+              m_fillTimer->start();
+            }
+          });
+
+  // Edit proxy of heavy videos: switched to once ready
+  connect(m_proxyGenerator, &ProxyGenerator::progressChanged, this,
+          &PlaybackEngine::proxyProgressChanged);
+  connect(m_proxyGenerator, &ProxyGenerator::proxyReady, this,
+          [this](const QString &source, const QString &proxyPath) {
+            if (source == m_source)
+              useProxy(proxyPath);
+          });
+  connect(m_proxyGenerator, &ProxyGenerator::proxyFailed, this,
+          [this](const QString &source, const QString &message) {
+            if (source == m_source)
+              emit proxyFailed(message);
+          });
+  connect(m_mediaPlayer, &QMediaPlayer::mediaStatusChanged, this,
+          [this](QMediaPlayer::MediaStatus status) {
+            if (status != QMediaPlayer::LoadedMedia || m_resumePosition < 0)
+              return;
+            m_mediaPlayer->setPosition(m_resumePosition);
+            if (m_resumePlaying)
+              m_mediaPlayer->play();
+            m_resumePosition = -1;
+          });
 
   // Forward signals from QMediaPlayer
   connect(m_mediaPlayer, &QMediaPlayer::positionChanged, this,
@@ -25,6 +93,8 @@ PlaybackEngine::PlaybackEngine(QObject *parent)
           &PlaybackEngine::mediaStatusChanged);
   connect(m_mediaPlayer, &QMediaPlayer::metaDataChanged, this,
           &PlaybackEngine::metaDataChanged);
+  connect(m_mediaPlayer, &QMediaPlayer::playbackRateChanged, this,
+          &PlaybackEngine::playbackRateChanged);
 
   // Forward volume signal from audio output
   connect(m_audioOutput, &QAudioOutput::volumeChanged, this,
@@ -38,6 +108,12 @@ PlaybackEngine::PlaybackEngine(QObject *parent)
           });
 }
 
+PlaybackEngine::~PlaybackEngine() {
+  if (m_indexCancel)
+    *m_indexCancel = true;
+  ExportCache::unpin(m_proxyPath);
+}
+
 void PlaybackEngine::setVideoSink(QVideoSink *sink) {
   m_mediaPlayer->setVideoOutput(sink);
 }
@@ -45,20 +121,178 @@ void PlaybackEngine::setVideoSink(QVideoSink *sink) {
 void PlaybackEngine::openFile(const QUrl &url) {
   m_mediaPlayer->setSource(url);
   // Reverted immediate pause() to prevent GStreamer crash
+
+  // The player no longer reads the previous archived video
+  delete m_sourceDevice;
+  m_sourceDevice = nullptr;
+
+  indexSource(url.isLocalFile() ? url.toLocalFile() : QString());
+}
+
+bool PlaybackEngine::openSource(const QString &source) {
+  if (!MediaSource::isArchived(source)) {
+    openFile(QUrl::fromLocalFile(source));
+    return true;
+  }
+
+  QIODevice *device = MediaSource::openDevice(source, this);
+  if (!device)
+    return false;
+
+  m_mediaPlayer->setSourceDevice(device);
+  delete m_sourceDevice;
+  m_sourceDevice = device;
+  indexSource(source);
+  return true;
+}
+
+void PlaybackEngine::indexSource(const QString &source) {
+  if (m_indexCancel)
+    *m_indexCancel = true; // Previous video
+  m_indexCancel.reset();
+  m_scrubTimer->stop();
+  m_keyframeIndex.reset();
+  m_source = source;
+  m_frameCache->setSource(source, nullptr);
+  m_proxyGenerator->cancel();
+  m_resumePosition = -1;
+  if (!m_proxyPath.isEmpty()) {
+    ExportCache::unpin(m_proxyPath);
+    m_proxyPath.clear();
+    emit proxyChanged(false);
+  }
+  emit keyframeIndexChanged();
+  if (source.isEmpty())
+    return;
+
+  // Packet headers only, once per video: later opens read the cached index
+  using Index = std::shared_ptr<const KeyframeIndex>;
+  auto cancel = std::make_shared<std::atomic<bool>>(false);
+  m_indexCancel = cancel;
+  auto *watcher = new QFutureWatcher<Index>(this);
+  connect(watcher, &QFutureWatcher<Index>::finished, this,
+          [this, watcher, cancel]() {
+            watcher->deleteLater();
+            if (*cancel)
+              return; // Another video since
+            m_indexCancel.reset();
+            m_keyframeIndex = watcher->result();
+            m_frameCache->setSource(m_source, m_keyframeIndex);
+            if (m_mediaPlayer->playbackState() != QMediaPlayer::PlayingState)
+              m_fillTimer->start();
+            emit keyframeIndexChanged();
+
+            // After the index: its GOP length is one of the criteria
+            m_proxyGenerator->start(m_source, m_keyframeIndex);
+          });
+  watcher->setFuture(QtConcurrent::run([source, cancel]() {
+    return KeyframeIndex::load(source, cancel.get());
+  }));
+}
+
+void PlaybackEngine::useProxy(const QString &proxyPath) {
+  // Resumed where the original was, once the proxy is loaded
+  m_resumePosition = targetPosition();
+  m_resumePlaying =
+      m_mediaPlayer->playbackState() == QMediaPlayer::PlayingState;
+  m_scrubTimer->stop();
+
+  // Played from the cache for as long as the video is open
+  ExportCache::unpin(m_proxyPath);
+  ExportCache::pin(proxyPath);
+  m_proxyPath = proxyPath;
+  m_mediaPlayer->setSource(QUrl::fromLocalFile(proxyPath));
+  delete m_sourceDevice; // Archived original no longer read
+  m_sourceDevice = nullptr;
+
+  // Same frame times: the index of the original still applies, and the
+  // frame cache decodes the small intra frames instead
+  m_frameCache->setSource(proxyPath, m_keyframeIndex);
+  emit proxyChanged(true);
 }
 
+bool PlaybackEngine::isUsingProxy() const { return !m_proxyPath.isEmpty(); }
+
 void PlaybackEngine::setVolume(float volume) {
   m_audioOutput->setVolume(volume);
 }
 
-void PlaybackEngine::play() { m_mediaPlayer->play(); }
+void PlaybackEngine::setPlaybackRate(qreal rate) {
+  m_mediaPlayer->setPlaybackRate(
+      qBound(MIN_PLAYBACK_RATE, rate, MAX_PLAYBACK_RATE));
+}
+
+void PlaybackEngine::play() {
+  // The player still shows where it was before the cached frames
+  if (m_scrubTimer->isActive()) {
+    m_scrubTimer->stop();
+    m_mediaPlayer->setPosition(m_scrubTarget);
+  }
+  m_mediaPlayer->play();
+}
 
 void PlaybackEngine::pause() { m_mediaPlayer->pause(); }
 
-void PlaybackEngine::stop() { m_mediaPlayer->stop(); }
+void PlaybackEngine::stop() {
+  m_scrubTimer->stop();
+  m_mediaPlayer->stop();
+}
 
 void PlaybackEngine::seek(qint64 position) {
-  m_mediaPlayer->setPosition(position);
+  m_scrubTimer->stop(); // Supersedes the end of a scrub
+  m_mediaPlayer->setPosition(qMax<qint64>(0, position));
+}
+
+void PlaybackEngine::scrub(qint64 position) {
+  if (showCachedFrame(position))
+    return;
+
+  const std::shared_ptr<const KeyframeIndex> index = m_keyframeIndex;
+  // Every proxy frame is a keyframe: the exact frame is cheap
+  if (!index || !m_proxyPath.isEmpty() ||
+      m_mediaPlayer->playbackState() == QMediaPlayer::PlayingState ||
+      index->decodeCost(position) < CHEAP_SEEK_FRAMES) {
+    seek(position);
+    return;
+  }
+
+  // The nearest keyframe shows at once; the exact frame, which decodes the
+  // GOP up to it, only once the user stops dragging
+  const qint64 keyframe = index->nearestKeyframe(position);
+  if (keyframe != m_mediaPlayer->position())
+    m_mediaPlayer->setPosition(keyframe);
+  m_scrubTarget = position;
+  m_scrubTimer->start();
+}
+
+void PlaybackEngine::stepFrames(int count) {
+  const qint64 from = targetPosition();
+  if (m_keyframeIndex) {
+    const qint64 target = m_keyframeIndex->stepFrames(from, count);
+    if (!showCachedFrame(target))
+      seek(target);
+  } else {
+    seek(from + std::llround(count * 1000.0 / videoFrameRate()));
+  }
+}
+
+bool PlaybackEngine::showCachedFrame(qint64 position) {
+  if (m_mediaPlayer->playbackState() == QMediaPlayer::PlayingState)
+    return false;
+  const QImage frame = m_frameCache->frame(position);
+  if (frame.isNull())
+    return false;
+
+  // The player catches up (same frame) once the steps stop, like a scrub
+  m_scrubTarget = position;
+  m_scrubTimer->start();
+  emit cachedFrameReady(frame);
+  emit positionChanged(position);
+  return true;
+}
+
+qint64 PlaybackEngine::targetPosition() const {
+  return m_scrubTimer->isActive() ? m_scrubTarget : m_mediaPlayer->position();
 }
 
 qint64 PlaybackEngine::duration() const { return m_mediaPlayer->duration(); }
@@ -71,6 +305,22 @@ QMediaPlayer::PlaybackState PlaybackEngine::playbackState() const {
 
 float PlaybackEngine::volume() const { return m_audioOutput->volume(); }
 
+qreal PlaybackEngine::playbackRate() const {
+  return m_mediaPlayer->playbackRate();
+}
+
+bool PlaybackEngine::preservesPitch() {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 10, 0)
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::shared_ptr<const KeyframeIndex> PlaybackEngine::keyframeIndex() const {
+  return m_keyframeIndex;
+}
+
 qreal PlaybackEngine::videoFrameRate() const {
   QVariant rate =
       m_mediaPlayer->metaData().value(QMediaMetaData::VideoFrameRate);
@@ -5,6 +5,20 @@
  * This class encapsulates QMediaPlayer and QAudioOutput, providing a clean
  * interface for video/audio playback. It inherits from QObject (not QWidget)
  * to ensure complete separation from UI concerns.
+ *
+ * Each opened video is indexed in the background (KeyframeIndex). Once the
+ * index is known, scrubs show the nearest keyframe at once and the exact
+ * frame when the scrub settles, and frame steps land on real frames.
+ * While paused, the frames around the playhead are decoded ahead into a
+ * FrameCache: steps and short scrubs inside it are shown from memory.
+ *
+ * A heavy video (4K, HEVC, 10-bit, long GOP) is converted in the background
+ * to an all-intra, low-resolution proxy (ProxyGenerator). Once it is ready,
+ * playback and scrubbing switch to it at the same position; position and
+ * frame times are those of the original, which exports keep reading.
+ *
+ * Playback can be slowed down (or sped up) for rehearsals; the audio keeps
+ * its pitch where Qt supports it (6.10 and later).
  * 
  * @note Part of the Core layer - no UI dependencies allowed.
  */
@@ -13,10 +27,19 @@
 #define PLAYBACKENGINE_H
 
 #include <QAudioOutput>
+#include <QImage>
 #include <QMediaPlayer>
 #include <QObject>
 #include <QUrl>
 
+#include <atomic>
+#include <memory>
+
+class FrameCache;
+class KeyframeIndex;
+class ProxyGenerator;
+class QIODevice;
+class QTimer;
 class QVideoSink;
 
 /**
@@ -27,6 +50,8 @@ class QVideoSink;
  * - Media file loading and source management
  * - Playback control (play, pause, stop, seek)
  * - Volume management
+ * - Seek planning from the keyframe index
+ * - Switching heavy videos to their edit proxy
  * - Emitting playback state and position signals
  * 
  * @example
@@ -47,7 +72,23 @@ public:
      */
     explicit PlaybackEngine(QObject *parent = nullptr);
     
-    ~PlaybackEngine() override = default;
+    /** @brief Stops the background indexing of the current video. */
+    ~PlaybackEngine() override;
+
+    /** @brief A scrub shows the exact frame once it stops moving for this long. */
+    static constexpr int SCRUB_SETTLE_MS = 150;
+
+    /** @brief Seeks decoding fewer frames than this go straight to the exact frame. */
+    static constexpr qint64 CHEAP_SEEK_FRAMES = 12;
+
+    /** @brief Slowest playback rate (rehearsal of difficult lines). */
+    static constexpr qreal MIN_PLAYBACK_RATE = 0.25;
+
+    /** @brief Fastest playback rate. */
+    static constexpr qreal MAX_PLAYBACK_RATE = 2.0;
+
+    /** @brief The frame cache fills once the paused position is still for this long. */
+    static constexpr int FILL_DELAY_MS = 300;
 
     // =========================================================================
     // Configuration
@@ -65,6 +106,16 @@ public:
      */
     void openFile(const QUrl &url);
 
+    /**
+     * @brief Opens a video path or an archived source (see MediaSource).
+     *
+     * An archived video is played from its range of the archive through
+     * a seekable device, without extracting it.
+     *
+     * @return False if the source cannot be opened.
+     */
+    bool openSource(const QString &source);
+
     // =========================================================================
     // State Accessors
     // =========================================================================
@@ -80,10 +131,30 @@ public:
     
     /** @brief Returns the current volume level (0.0 to 1.0). */
     float volume() const;
+
+    /** @brief Returns the playback rate (1.0: normal speed). */
+    qreal playbackRate() const;
+
+    /**
+     * @brief Returns true if slowed or sped-up playback keeps the pitch.
+     *
+     * Needs QMediaPlayer::setPitchCompensation (Qt 6.10 and later). Built
+     * against older Qt, the audio is resampled and its pitch follows the rate.
+     */
+    static bool preservesPitch();
     
     /** @brief Returns the video frame rate in FPS. Defaults to 25.0 if unknown. */
     qreal videoFrameRate() const;
 
+    /**
+     * @brief Returns the frame and keyframe index of the current video.
+     * @return nullptr while it is being built (or if it cannot be).
+     */
+    std::shared_ptr<const KeyframeIndex> keyframeIndex() const;
+
+    /** @brief Returns true if the current video plays from its edit proxy. */
+    bool isUsingProxy() const;
+
 public slots:
     // =========================================================================
     // Playback Control
@@ -103,6 +174,25 @@ public slots:
      * @param position Target position in milliseconds.
      */
     void seek(qint64 position);
+
+    /**
+     * @brief Seeks while the user drags (slider, filmstrip).
+     *
+     * While paused, a target far from its keyframe first shows the nearest
+     * keyframe (no decoding from the GOP start), then the exact frame once
+     * the scrub has settled for SCRUB_SETTLE_MS. A cached frame is shown at
+     * once. Without an index, or while playing, same as seek().
+     */
+    void scrub(qint64 position);
+
+    /**
+     * @brief Moves by @p count frames (negative: backwards).
+     *
+     * Lands exactly on the frames listed by the index; until it is known,
+     * steps by the nominal frame duration. While paused, a cached frame is
+     * shown at once and the player follows when the steps stop.
+     */
+    void stepFrames(int count);
     
     /**
      * @brief Sets the playback volume.
@@ -110,6 +200,14 @@ public slots:
      */
     void setVolume(float volume);
 
+    /**
+     * @brief Sets the playback rate, clamped to [MIN_PLAYBACK_RATE, MAX_PLAYBACK_RATE].
+     *
+     * The audio is time-stretched, keeping its pitch, with Qt 6.10 and later;
+     * with older Qt it is resampled (pitch follows the rate).
+     */
+    void setPlaybackRate(qreal rate);
+
 signals:
     // =========================================================================
     // State Change Signals
@@ -132,13 +230,59 @@ signals:
     
     /** @brief Emitted when volume changes. */
     void volumeChanged(float volume);
+
+    /** @brief Emitted when the playback rate changes. */
+    void playbackRateChanged(qreal rate);
     
     /** @brief Emitted when an error occurs during playback. */
     void errorOccurred(const QString &error);
 
+    /** @brief Emitted when the index of the current video is known (or cleared). */
+    void keyframeIndexChanged();
+
+    /**
+     * @brief Emitted with a frame from the cache, shown without the player.
+     *
+     * positionChanged() follows with its position. The player itself only
+     * seeks there once the steps or scrub stop.
+     */
+    void cachedFrameReady(const QImage &frame);
+
+    /** @brief Emitted while the edit proxy of the current video is generated (0-100). */
+    void proxyProgressChanged(int percentage);
+
+    /** @brief Emitted when playback switches to (or away from) an edit proxy. */
+    void proxyChanged(bool active);
+
+    /** @brief Emitted when the edit proxy cannot be generated; the original plays on. */
+    void proxyFailed(const QString &message);
+
 private:
+    void indexSource(const QString &source);
+
+    /** Where the next seek or step starts from: a pending scrub target counts. */
+    qint64 targetPosition() const;
+
+    /** Shows @p position from the frame cache; false while playing or if not cached. */
+    bool showCachedFrame(qint64 position);
+
+    /** Plays @p proxyPath in place of the current video, same position and state. */
+    void useProxy(const QString &proxyPath);
+
     QMediaPlayer *m_mediaPlayer;
     QAudioOutput *m_audioOutput;
+    QIODevice *m_sourceDevice;    ///< Archived video being played, if any
+    std::shared_ptr<const KeyframeIndex> m_keyframeIndex;
+    std::shared_ptr<std::atomic<bool>> m_indexCancel;   ///< Indexing in progress, if any
+    QTimer *m_scrubTimer;         ///< Exact seek at the end of a scrub
+    qint64 m_scrubTarget;
+    QString m_source;             ///< Video being indexed and cached
+    FrameCache *m_frameCache;
+    QTimer *m_fillTimer;          ///< Fills the frame cache once paused and still
+    ProxyGenerator *m_proxyGenerator;
+    QString m_proxyPath;          ///< Proxy being played, if any
+    qint64 m_resumePosition;      ///< Applied once the proxy is loaded (-1: none)
+    bool m_resumePlaying;
 };
 
 #endif // PLAYBACKENGINE_H
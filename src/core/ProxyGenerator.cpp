@@ -0,0 +1,252 @@
+/**
+ * @file ProxyGenerator.cpp
+ * @brief Implementation of the ProxyGenerator class.
+ */
+
+#include "ProxyGenerator.h"
+#include "ExportCache.h"
+#include "KeyframeIndex.h"
+#include "MediaProbe.h"
+#include "ToolCapabilities.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QRegularExpression>
+#include <QTemporaryFile>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+namespace {
+
+const QString CACHE_KIND = QStringLiteral("proxies");
+
+/** What start() found out off the GUI thread. */
+struct ProxyPlan {
+    QString key;            ///< Cache key of the proxy
+    QString cached;         ///< Existing proxy, if any
+    MediaInfo info;
+    bool needed = false;
+    bool x264 = false;      ///< H.264 available (else MJPEG)
+};
+
+/** Cache key: the original's content and the proxy settings. */
+QString proxyKey(const QString &fingerprint)
+{
+    return ExportCache::key(QStringList()
+        << fingerprint << "proxy" << QString::number(ProxyGenerator::PROXY_HEIGHT));
+}
+
+} // namespace
+
+ProxyGenerator::ProxyGenerator(QObject *parent)
+    : QObject(parent)
+    , m_process(nullptr)
+    , m_durationMs(0)
+{
+}
+
+ProxyGenerator::~ProxyGenerator()
+{
+    cancel();
+}
+
+bool ProxyGenerator::needsProxy(const MediaInfo &info, const KeyframeIndex *index)
+{
+    if (info.width > 1920 || info.height > 1080) {
+        return true;
+    }
+
+    static const QStringList heavyCodecs = { "hevc", "av1", "vp9" };
+    if (heavyCodecs.contains(info.videoCodec)) {
+        return true;
+    }
+
+    // yuv420p10le, p010le, yuv422p12be...: more than 8 bits per component
+    static const QRegularExpression deepFormat("(9|10|12|14|16)(le|be)$");
+    if (deepFormat.match(info.pixelFormat).hasMatch()) {
+        return true;
+    }
+
+    if (index && index->keyframeCount() > 0 && info.frameRate > 0.0) {
+        const double gopSeconds =
+            double(index->frameCount()) / index->keyframeCount() / info.frameRate;
+        return gopSeconds > LONG_GOP_SECONDS;
+    }
+    return false;
+}
+
+void ProxyGenerator::start(const QString &source, std::shared_ptr<const KeyframeIndex> index)
+{
+    cancel();
+    m_source = source;
+    if (source.isEmpty()) {
+        return;
+    }
+
+    // Fingerprint, cache lookup and probe are blocking: worker thread
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_planCancel = cancelled;
+    auto *watcher = new QFutureWatcher<ProxyPlan>(this);
+    connect(watcher, &QFutureWatcher<ProxyPlan>::finished, this,
+            [this, watcher, cancelled, source]() {
+        watcher->deleteLater();
+        if (*cancelled) {
+            return;     // Another video since
+        }
+        m_planCancel.reset();
+
+        const ProxyPlan plan = watcher->result();
+        if (!plan.cached.isEmpty()) {
+            qDebug() << "[ProxyGenerator] Cached proxy of" << source << ":" << plan.cached;
+            emit proxyReady(source, plan.cached);
+        } else if (plan.needed) {
+            m_key = plan.key;
+            m_suffix = plan.x264 ? QStringLiteral("mp4") : QStringLiteral("mkv");
+            encode(plan.info);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run([source, index, cancelled]() {
+        ProxyPlan plan;
+        const QString fingerprint = ExportCache::fingerprint(source);
+        if (fingerprint.isEmpty() || *cancelled) {
+            return plan;
+        }
+        plan.key = proxyKey(fingerprint);
+        plan.cached = ExportCache::lookup(CACHE_KIND, plan.key, "mp4");
+        if (plan.cached.isEmpty()) {
+            plan.cached = ExportCache::lookup(CACHE_KIND, plan.key, "mkv");
+        }
+        if (!plan.cached.isEmpty()) {
+            return plan;
+        }
+        plan.info = MediaProbe::probe(source);
+        plan.needed = plan.info.valid && needsProxy(plan.info, index.get());
+        plan.x264 = plan.needed && ToolCapabilities::hasEncoder("libx264");
+        return plan;
+    }));
+}
+
+void ProxyGenerator::encode(const MediaInfo &info)
+{
+    // Written aside, then moved into the cache in one rename
+    QTemporaryFile file(QDir(ExportCache::workDirectory()).filePath("proxy-XXXXXX." + m_suffix));
+    file.setAutoRemove(false);
+    if (!file.open()) {
+        emit proxyFailed(m_source, "Erreur: Impossible de créer le fichier du proxy.");
+        return;
+    }
+    m_outputPath = file.fileName();
+    file.close();
+    m_durationMs = info.durationMs;
+
+    const bool x264 = m_suffix == "mp4";
+    const int height = qMin(info.height, PROXY_HEIGHT) & ~1;
+    QStringList args;
+    args << "-v" << "error" << "-nostdin" << "-y"
+         << "-i" << m_source
+         << "-map" << "0:v:0" << "-map" << "0:a:0?"
+         << "-vf" << QString("scale=-2:%1,format=%2").arg(height)
+                        .arg(x264 ? "yuv420p" : "yuvj420p")
+         // Same frame times as the original: the keyframe index still applies
+         << "-vsync" << "passthrough";
+    if (x264) {
+        // Every frame a keyframe: any seek decodes one small frame
+        args << "-c:v" << "libx264" << "-preset" << "veryfast" << "-tune" << "fastdecode"
+             << "-crf" << "23" << "-g" << "1" << "-bf" << "0"
+             << "-movflags" << "+faststart";
+    } else {
+        args << "-c:v" << "mjpeg" << "-q:v" << "5";
+    }
+    args << "-c:a" << "aac" << "-b:a" << "160k"
+         << "-progress" << "pipe:1" << "-nostats"
+         << m_outputPath;
+
+    m_process = new QProcess(this);
+    connect(m_process, &QProcess::readyReadStandardOutput, this, &ProxyGenerator::parseProgress);
+    connect(m_process, &QProcess::finished, this, &ProxyGenerator::handleFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) {
+            return;     // finished() follows
+        }
+        const QString source = m_source;
+        discardProcess();
+        emit proxyFailed(source, "Erreur: FFmpeg est introuvable, proxy non généré.");
+    });
+
+    qDebug() << "[ProxyGenerator] Converting" << m_source << "to" << m_outputPath;
+    emit progressChanged(0);
+    m_process->start("ffmpeg", args);
+}
+
+void ProxyGenerator::parseProgress()
+{
+    // -progress writes key=value lines; out_time_us (out_time_ms in older
+    // FFmpeg, also microseconds) is the position reached
+    while (m_process && m_process->canReadLine()) {
+        const QByteArray line = m_process->readLine().trimmed();
+        if (m_durationMs <= 0
+            || !(line.startsWith("out_time_us=") || line.startsWith("out_time_ms="))) {
+            continue;
+        }
+        const qint64 doneMs = line.mid(line.indexOf('=') + 1).toLongLong() / 1000;
+        emit progressChanged(qBound(0, static_cast<int>(doneMs * 100 / m_durationMs), 99));
+    }
+}
+
+void ProxyGenerator::handleFinished(int exitCode, QProcess::ExitStatus status)
+{
+    const QString source = m_source;
+    const QString output = m_outputPath;
+    const QString errors = QString::fromUtf8(m_process->readAllStandardError()).trimmed();
+    m_process->deleteLater();
+    m_process = nullptr;
+    m_outputPath.clear();
+
+    const QString path = status == QProcess::NormalExit && exitCode == 0
+                             ? ExportCache::insert(CACHE_KIND, m_key, m_suffix, output)
+                             : QString();
+    if (path.isEmpty()) {
+        QFile::remove(output);
+        qWarning() << "[ProxyGenerator] Conversion of" << source << "failed:" << errors;
+        emit proxyFailed(source, "Erreur: La génération du proxy a échoué.");
+        return;
+    }
+
+    qDebug() << "[ProxyGenerator] Proxy of" << source << "ready:" << path;
+    emit progressChanged(100);
+    emit proxyReady(source, path);
+
+    // Several GB each: keep the proxy budget now. The new proxy is in its
+    // grace period, and pinned by the player from proxyReady() on
+    QThreadPool::globalInstance()->start([]() { ExportCache::evict(); });
+}
+
+void ProxyGenerator::cancel()
+{
+    if (m_planCancel) {
+        *m_planCancel = true;
+        m_planCancel.reset();
+    }
+    discardProcess();
+}
+
+bool ProxyGenerator::isRunning() const
+{
+    return m_process != nullptr;
+}
+
+void ProxyGenerator::discardProcess()
+{
+    if (!m_process) {
+        return;
+    }
+    disconnect(m_process, nullptr, this, nullptr);
+    m_process->kill();
+    m_process->waitForFinished(1000);
+    m_process->deleteLater();
+    m_process = nullptr;
+    QFile::remove(m_outputPath);
+    m_outputPath.clear();
+}
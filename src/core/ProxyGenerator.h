@@ -0,0 +1,112 @@
+/**
+ * @file ProxyGenerator.h
+ * @brief Edit-friendly proxies of heavy videos, generated in the background.
+ *
+ * 4K, HEVC, 10-bit and long-GOP sources are slow for QMediaPlayer to seek:
+ * each seek decodes from the previous keyframe, at full size. Such a source
+ * gets a proxy: H.264 with every frame a keyframe, PROXY_HEIGHT lines,
+ * 8-bit 4:2:0, same frame times, with the audio. PlaybackEngine plays and
+ * scrubs the proxy once it exists; exports keep reading the original.
+ *
+ * Proxies are filed in the export cache under the content fingerprint of
+ * the original, so each video is converted once.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note Requires FFmpeg in PATH. Without libx264, proxies are MJPEG (also
+ *       intra-only, larger).
+ */
+
+#ifndef PROXYGENERATOR_H
+#define PROXYGENERATOR_H
+
+#include <QObject>
+#include <QProcess>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+class KeyframeIndex;
+struct MediaInfo;
+
+/**
+ * @class ProxyGenerator
+ * @brief Finds or builds the proxy of one video at a time.
+ *
+ * @example
+ * @code
+ * auto proxies = new ProxyGenerator(this);
+ * connect(proxies, &ProxyGenerator::progressChanged, progressBar, &QProgressBar::setValue);
+ * connect(proxies, &ProxyGenerator::proxyReady, this,
+ *         [](const QString &source, const QString &proxyPath) { ... });
+ * proxies->start(videoPath, engine->keyframeIndex());
+ * @endcode
+ */
+class ProxyGenerator : public QObject {
+    Q_OBJECT
+
+public:
+    /** @brief Height of a proxy in pixels (width follows the video). */
+    static constexpr int PROXY_HEIGHT = 540;
+
+    /** @brief Keyframes further apart than this on average make a long GOP. */
+    static constexpr double LONG_GOP_SECONDS = 5.0;
+
+    explicit ProxyGenerator(QObject *parent = nullptr);
+
+    /**
+     * @brief Stops the running conversion; its partial output is removed.
+     */
+    ~ProxyGenerator() override;
+
+    /**
+     * @brief Returns true if a video is heavy enough to be edited on a proxy.
+     *
+     * Larger than 1920x1080, HEVC/AV1/VP9, more than 8 bits per component,
+     * or (with @p index) keyframes more than LONG_GOP_SECONDS apart.
+     */
+    static bool needsProxy(const MediaInfo &info, const KeyframeIndex *index);
+
+    /**
+     * @brief Finds or builds the proxy of @p source; replaces the current job.
+     *
+     * Probes in the background. A cached proxy is reported by proxyReady()
+     * without converting; a video that plays well as is reports nothing.
+     *
+     * @param source Video file or archived source.
+     * @param index Frame times of @p source, for the GOP length (optional).
+     */
+    void start(const QString &source, std::shared_ptr<const KeyframeIndex> index);
+
+    /** @brief Stops the current job, if any. */
+    void cancel();
+
+    /** @brief Returns true while a proxy is being converted. */
+    bool isRunning() const;
+
+signals:
+    /** @brief Conversion progress of the current proxy, 0 to 100. */
+    void progressChanged(int percentage);
+
+    /** @brief The proxy of @p source is ready at @p proxyPath. */
+    void proxyReady(const QString &source, const QString &proxyPath);
+
+    /** @brief The proxy of @p source could not be built. */
+    void proxyFailed(const QString &source, const QString &message);
+
+private:
+    void encode(const MediaInfo &info);
+    void parseProgress();
+    void handleFinished(int exitCode, QProcess::ExitStatus status);
+    void discardProcess();
+
+    QString m_source;
+    std::shared_ptr<std::atomic<bool>> m_planCancel;    ///< Probe in progress, if any
+    QProcess *m_process;            ///< Running conversion, if any
+    QString m_key;                  ///< Cache key of the proxy being converted
+    QString m_outputPath;           ///< Its file in the work directory
+    QString m_suffix;               ///< "mp4" (H.264) or "mkv" (MJPEG)
+    qint64 m_durationMs;
+};
+
+#endif // PROXYGENERATOR_H
@@ -0,0 +1,141 @@
+/**
+ * @file RythmoRenderer.cpp
+ * @brief Implementation of the Rythmo band renderer.
+ */
+
+#include "RythmoRenderer.h"
+
+#include <QFontMetrics>
+#include <QPen>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Screen height the band layout is designed for; exports scale from it.
+constexpr double REFERENCE_VIDEO_HEIGHT = 540.0;
+
+const QColor GUIDE_COLOR(0, 120, 215);
+
+} // namespace
+
+// =============================================================================
+// Band painting
+// =============================================================================
+
+namespace RythmoRenderer {
+
+int charWidth(const QFont &font) {
+  QFontMetrics fm(font);
+  return fm.horizontalAdvance('A');
+}
+
+void paintBand(QPainter &painter, const QRect &bandRect, const QString &text,
+               const RythmoTrackStyle &style, int charWidth, double pixelOffset,
+               int targetX, bool playing) {
+  double textStartX = targetX - pixelOffset;
+
+  // 1. Band background
+  QColor bgColor = style.backgroundColor;
+  // If playing, we might want to slightly lighten or darken it as a visual cue
+  if (playing) {
+    bgColor = bgColor.lighter(110);
+  }
+  painter.fillRect(bandRect, bgColor);
+
+  // 2. Scrolling text (virtualized for performance)
+  if (charWidth > 0 && !text.isEmpty()) {
+    painter.setFont(style.font);
+    painter.setPen(style.textColor);
+
+    int textY =
+        bandRect.y() + (bandRect.height() + style.globalSize) / 2 - 2;
+
+    // Only render visible characters
+    int firstVisibleIdx = std::max(
+        0, static_cast<int>((bandRect.x() - textStartX) / charWidth));
+    int lastVisibleIdx = std::min(
+        static_cast<int>(text.length()),
+        static_cast<int>((bandRect.x() + bandRect.width() - textStartX) /
+                         charWidth) +
+            1);
+
+    if (firstVisibleIdx < lastVisibleIdx) {
+      QString visibleText =
+          text.mid(firstVisibleIdx, lastVisibleIdx - firstVisibleIdx);
+      painter.drawText(
+          QPointF(textStartX + (firstVisibleIdx * charWidth), textY),
+          visibleText);
+    }
+  }
+
+  // 3. Band border
+  QPen borderPen(GUIDE_COLOR, 2);
+  painter.setPen(borderPen);
+  painter.drawRect(bandRect);
+
+  // 4. Target line (guide)
+  QPen targetPen(GUIDE_COLOR, 2);
+  targetPen.setStyle(Qt::DashLine);
+  painter.setPen(targetPen);
+  painter.drawLine(targetX, bandRect.y(), targetX,
+                   bandRect.y() + bandRect.height());
+}
+
+} // namespace RythmoRenderer
+
+// =============================================================================
+// Offscreen frame renderer
+// =============================================================================
+
+RythmoFrameRenderer::RythmoFrameRenderer(const QList<RythmoBandTrack> &tracks,
+                                         int speed, int videoWidth,
+                                         int videoHeight)
+    : m_tracks(tracks), m_speed(speed),
+      m_scale(std::max(1, videoHeight) / REFERENCE_VIDEO_HEIGHT),
+      m_logicalWidth(static_cast<int>(std::lround(videoWidth / m_scale))) {
+  for (RythmoBandTrack &track : m_tracks) {
+    // Unhinted glyphs scale linearly, so the text stays on the character
+    // grid whatever the export resolution is
+    track.style.font.setHintingPreference(QFont::PreferNoHinting);
+    m_charWidths.append(RythmoRenderer::charWidth(track.style.font));
+  }
+
+  // Stacked bands, rounded up to an even height for 4:2:0 encoders
+  int height = static_cast<int>(std::ceil(
+      m_tracks.size() * RythmoRenderer::BAND_HEIGHT * m_scale));
+  m_frameSize = QSize(videoWidth, std::max(2, (height + 1) & ~1));
+}
+
+QSize RythmoFrameRenderer::frameSize() const { return m_frameSize; }
+
+QImage RythmoFrameRenderer::renderFrame(qint64 positionMs) const {
+  QImage image(m_frameSize, QImage::Format_ARGB32_Premultiplied);
+  image.fill(Qt::transparent);
+
+  QPainter painter(&image);
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.scale(m_scale, m_scale);
+
+  // Same layout as a playing RythmoWidget: smooth scroll, target at 1/5
+  int targetX = m_logicalWidth / 5;
+  double pixelOffset = (static_cast<double>(positionMs) / 1000.0) * m_speed;
+
+  for (int i = 0; i < m_tracks.size(); ++i) {
+    QRect bandRect(0, i * RythmoRenderer::BAND_HEIGHT, m_logicalWidth,
+                   RythmoRenderer::BAND_HEIGHT);
+    RythmoRenderer::paintBand(painter, bandRect, m_tracks[i].text,
+                              m_tracks[i].style, m_charWidths[i], pixelOffset,
+                              targetX, false);
+
+    // Playback cursor
+    painter.setPen(QPen(GUIDE_COLOR, 3));
+    painter.drawLine(targetX, bandRect.y(), targetX,
+                     bandRect.y() + bandRect.height());
+  }
+  painter.end();
+
+  // FFmpeg's rgba input expects straight (non-premultiplied) alpha
+  return image.convertToFormat(QImage::Format_RGBA8888);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file RythmoRenderer.h
+ * @brief Widget-independent drawing of the Rythmo band.
+ *
+ * The band painting shared by the on-screen RythmoWidget and the offscreen
+ * export renderer lives here, so an exported band looks exactly like the
+ * one the actor saw while recording.
+ *
+ * @note Part of the Core layer - draws with QPainter on any QPaintDevice,
+ * no QWidget dependencies.
+ */
+
+#ifndef RYTHMORENDERER_H
+#define RYTHMORENDERER_H
+
+#include "RythmoManager.h"
+
+#include <QImage>
+#include <QList>
+#include <QPainter>
+#include <QSize>
+
+/**
+ * @struct RythmoBandTrack
+ * @brief Text and style of one track, snapshotted for offscreen rendering.
+ */
+struct RythmoBandTrack {
+  QString text;
+  RythmoTrackStyle style;
+};
+
+/**
+ * @namespace RythmoRenderer
+ * @brief Stateless band painting helpers.
+ */
+namespace RythmoRenderer {
+
+/** @brief Height of one band in logical pixels (same as RythmoWidget). */
+constexpr int BAND_HEIGHT = 35;
+
+/**
+ * @brief Returns the monospace character width of a font.
+ */
+int charWidth(const QFont &font);
+
+/**
+ * @brief Paints the band background, scrolling text, border and target line.
+ * @param painter Active painter.
+ * @param bandRect Area of the band.
+ * @param text Track text.
+ * @param style Track style.
+ * @param charWidth Character width of the style font (see charWidth()).
+ * @param pixelOffset Scroll offset in pixels (position * speed).
+ * @param targetX X coordinate of the target line.
+ * @param playing Lightens the background as a "playing" cue.
+ */
+void paintBand(QPainter &painter, const QRect &bandRect, const QString &text,
+               const RythmoTrackStyle &style, int charWidth, double pixelOffset,
+               int targetX, bool playing);
+
+} // namespace RythmoRenderer
+
+/**
+ * @class RythmoFrameRenderer
+ * @brief Renders the Rythmo bands at exact media timestamps, offscreen.
+ *
+ * The band is laid out as on a 540-line screen and scaled to the video
+ * resolution, so text size and scroll speed keep their on-screen proportions.
+ * renderFrame() is const and only touches copies, so it may be called from
+ * several threads at once.
+ */
+class RythmoFrameRenderer {
+public:
+  /**
+   * @param tracks Tracks to draw, top to bottom.
+   * @param speed Scrolling speed in logical pixels per second.
+   * @param videoWidth Width of the target video.
+   * @param videoHeight Height of the target video.
+   */
+  RythmoFrameRenderer(const QList<RythmoBandTrack> &tracks, int speed,
+                      int videoWidth, int videoHeight);
+
+  /** @brief Size of rendered frames (video width x stacked band height). */
+  QSize frameSize() const;
+
+  /**
+   * @brief Renders the bands as they look at a media position.
+   * @param positionMs Media position in milliseconds.
+   * @return Straight-alpha RGBA8888 image of frameSize().
+   */
+  QImage renderFrame(qint64 positionMs) const;
+
+private:
+  QList<RythmoBandTrack> m_tracks;
+  QList<int> m_charWidths;
+  int m_speed;
+  double m_scale;
+  int m_logicalWidth;
+  QSize m_frameSize;
+};
+
+#endif // RYTHMORENDERER_H
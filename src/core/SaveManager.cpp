@@ -1,15 +1,78 @@
 #include "SaveManager.h"
+#include "Checksum.h"
+#include "MediaRelink.h"
+#include "MediaSource.h"
+#include "ZipReader.h"
+#include "ZipWriter.h"
 #include <QCryptographicHash>
 #include <QDataStream>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
-#include <QProcess>
-#include <QTemporaryDir>
+#include <QSaveFile>
 #include <QtEndian>
+#include <QtConcurrent>
 #include <QtGlobal>
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <memory>
+
+namespace {
+
+// .dbi v2: header, table of contents, then independently checksummed chunks
+//   "DubInstanteFile" | version | flags | u32 chunk count
+//   count x { char[4] type | u32 index | u64 offset | u32 size | u32 CRC-32C }
+//   u32 CRC-32C of everything above
+//   chunk payloads (XOR-masked)
+constexpr int V2_PREFIX_SIZE = 15 + 1 + 1 + 4;
+constexpr int TOC_ENTRY_SIZE = 4 + 4 + 8 + 4 + 4;
+constexpr quint32 MAX_CHUNKS = 4096;
+constexpr quint32 MAX_TRACKS = 64;
+
+// Input bounds, checked before anything is allocated: a project is text
+// and a few settings, so anything larger is corrupt or not ours.
+constexpr qint64 MAX_PROJECT_BYTES = 64 * 1024 * 1024;
+constexpr quint32 MAX_JSON_CHUNK_BYTES = 1024 * 1024; // Settings, styles
+
+// Memory a decode may allocate, estimated from the table of contents (or
+// the v1 payload size) before anything is decoded. Chunks may overlap in
+// the file, so the file cap alone does not bound it.
+constexpr qint64 MAX_DECODED_BYTES = 256 * 1024 * 1024;
+constexpr qint64 TEXT_DECODE_FACTOR = 3; // Masked copy, then UTF-16 text
+constexpr qint64 JSON_DECODE_FACTOR = 5; // Masked copy, JSON DOM, strings
+
+// Below this much track data, threads cost more than they save
+constexpr qint64 PARALLEL_DECODE_BYTES = 1024 * 1024;
+
+const QByteArray CHUNK_SETTINGS("SETS"); // Session settings (JSON)
+const QByteArray CHUNK_TEXT("TEXT");     // Text of track <index> (UTF-8)
+const QByteArray CHUNK_STYLE("STYL");    // Style of track <index> (JSON)
+
+struct Chunk {
+  QByteArray type;
+  quint32 index;
+  QByteArray payload; // Masked
+};
+
+struct ChunkRef {
+  QByteArray type;
+  quint32 index = 0;
+  qint64 offset = 0;
+  quint32 size = 0;
+  quint32 crc = 0;
+};
+
+template <typename T> void appendLittleEndian(QByteArray &bytes, T value) {
+  value = qToLittleEndian(value);
+  bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
 SaveManager::SaveManager(QObject *parent) : QObject(parent) {}
 
 bool SaveManager::save(const QString &filePath, const SaveData &data) {
@@ -17,243 +80,392 @@ bool SaveManager::save(const QString &filePath, const SaveData &data) {
 
   // Convert video path to relative if it's a local file
   QString videoPath = cleanData.videoUrl;
+  stampVideoIdentity(cleanData, videoPath);
   if (!videoPath.isEmpty() && QFileInfo(videoPath).isAbsolute()) {
     QDir saveDir = QFileInfo(filePath).dir();
     cleanData.videoUrl = saveDir.relativeFilePath(videoPath);
   }
 
-  QJsonObject root;
-  root["video_url"] = cleanData.videoUrl;
-  root["video_volume"] = cleanData.videoVolume;
-  root["audio_input_1"] = cleanData.audioInput1;
-  root["audio_gain_1"] = cleanData.audioGain1;
-  root["audio_input_2"] = cleanData.audioInput2;
-  root["audio_gain_2"] = cleanData.audioGain2;
-  root["enable_track_2"] = cleanData.enableTrack2;
-  root["scroll_speed"] = cleanData.scrollSpeed;
-  root["is_text_white"] = cleanData.isTextWhite;
-
-  QJsonArray tracksArray;
-  for (const auto &trackData : cleanData.tracks) {
-    QJsonObject trackObj;
-    trackObj["text"] = trackData.text;
-
-    // Save style parameters
-    QJsonObject styleObj;
-    styleObj["font_size"] = trackData.style.globalSize;
-    styleObj["text_color"] = trackData.style.textColor.name(QColor::HexArgb);
-    styleObj["bg_color"] =
-        trackData.style.backgroundColor.name(QColor::HexArgb);
-
-    trackObj["style"] = styleObj;
-    tracksArray.append(trackObj);
-  }
-  root["tracks"] = tracksArray;
-
-  QJsonDocument doc(root);
-  QByteArray jsonPayload = doc.toJson(QJsonDocument::Compact);
-  QByteArray maskedPayload = applyXorMask(jsonPayload);
-  QByteArray checksum = calculateChecksum(jsonPayload);
-
-  QFile file(filePath);
+  // Written aside and renamed over the target: a crash mid-save never
+  // leaves a truncated project
+  QSaveFile file(filePath);
   if (!file.open(QIODevice::WriteOnly)) {
     qWarning() << "Failed to open file for writing:" << filePath;
     return false;
   }
 
-  // Header
-  file.write(m_header);
-
-  // Version & Flags
-  file.putChar(static_cast<char>(m_version));
-  file.putChar(0); // Flags
-
-  // Payload Size & Data (little-endian for cross-platform portability)
-  quint32 payloadSize =
-      qToLittleEndian(static_cast<quint32>(maskedPayload.size()));
-  file.write(reinterpret_cast<const char *>(&payloadSize), sizeof(payloadSize));
-  file.write(maskedPayload);
-
-  // Checksum
-  file.write(checksum);
+  QElapsedTimer timer;
+  timer.start();
+  QByteArray bytes = encode(cleanData);
+  file.write(bytes);
+  if (!file.commit())
+    return false;
 
-  file.close();
+  qDebug() << "[SaveManager] Saved" << bytes.size() << "bytes,"
+           << cleanData.tracks.size() << "tracks in" << timer.elapsed()
+           << "ms";
   return true;
 }
 
-bool SaveManager::isZipAvailable(QString *errorMessage) {
-#ifdef Q_OS_WIN
-  Q_UNUSED(errorMessage);
-  return true; // PowerShell is always available on Windows
-#else
-  QProcess checkZip;
-  checkZip.start("zip", QStringList() << "-h");
-  if (!checkZip.waitForStarted()) {
-    if (errorMessage) {
-#ifdef Q_OS_MAC
-      *errorMessage = QObject::tr(
-          "L'utilitaire 'zip' est introuvable.\n\n"
-          "Veuillez l'installer pour utiliser cette fonctionnalité.\n"
-          "Lien : https://formulae.brew.sh/formula/zip");
-#else
-      *errorMessage =
-          QObject::tr("L'utilitaire 'zip' est introuvable.\n\n"
-                      "Veuillez l'installer via votre terminal :\n"
-                      "Debian/Ubuntu : sudo apt install zip\n"
-                      "Fedora : sudo dnf install zip\n"
-                      "Arch : sudo pacman -S zip\n\n"
-                      "Ou consultez : https://command-not-found.com/zip");
-#endif
-    }
-    return false;
+QByteArray SaveManager::encode(const SaveData &cleanData) {
+  // One chunk per independent piece: settings, then each track's text
+  // and style. Unknown chunk types are skipped on load, so later
+  // additions (cue data...) do not break older readers.
+  QList<Chunk> chunks;
+  chunks.append({CHUNK_SETTINGS, 0,
+                 applyXorMask(QJsonDocument(encodeSettings(cleanData))
+                                  .toJson(QJsonDocument::Compact))});
+  for (int i = 0; i < cleanData.tracks.size(); ++i) {
+    const TrackSaveData &track = cleanData.tracks.at(i);
+    chunks.append({CHUNK_TEXT, static_cast<quint32>(i),
+                   applyXorMask(track.text.toUtf8())});
+    chunks.append({CHUNK_STYLE, static_cast<quint32>(i),
+                   applyXorMask(QJsonDocument(encodeStyle(track.style))
+                                    .toJson(QJsonDocument::Compact))});
   }
-  checkZip.waitForFinished();
-  return true;
-#endif
-}
-
-bool SaveManager::saveWithMedia(const QString &zipPath, const SaveData &data,
-                                QString *errorMessage) {
 
-  // 1. Create temporary directory
-  QTemporaryDir tempDir;
-  if (!tempDir.isValid()) {
-    qWarning() << "Failed to create temporary directory";
-    if (errorMessage)
-      *errorMessage = QObject::tr("Impossible de créer le dossier temporaire.");
-    return false;
+  const qint64 tocEnd = V2_PREFIX_SIZE + chunks.size() * TOC_ENTRY_SIZE;
+  qint64 total = tocEnd + 4;
+  for (const Chunk &chunk : chunks)
+    total += chunk.payload.size();
+
+  QByteArray bytes;
+  bytes.reserve(static_cast<int>(total));
+
+  // Header: magic, version, flags, chunk count
+  bytes.append(m_header);
+  bytes.append(static_cast<char>(m_version));
+  bytes.append(static_cast<char>(0)); // Flags
+  appendLittleEndian<quint32>(bytes, static_cast<quint32>(chunks.size()));
+
+  // Table of contents (little-endian for cross-platform portability)
+  qint64 offset = tocEnd + 4;
+  for (const Chunk &chunk : chunks) {
+    bytes.append(chunk.type);
+    appendLittleEndian<quint32>(bytes, chunk.index);
+    appendLittleEndian<quint64>(bytes, static_cast<quint64>(offset));
+    appendLittleEndian<quint32>(bytes,
+                                static_cast<quint32>(chunk.payload.size()));
+    appendLittleEndian<quint32>(
+        bytes, Checksum::crc32c(0, chunk.payload.constData(),
+                                chunk.payload.size()));
+    offset += chunk.payload.size();
   }
+  appendLittleEndian<quint32>(
+      bytes, Checksum::crc32c(0, bytes.constData(), bytes.size()));
 
-  // 2. Save .dbi file
-  QString dbiName = QFileInfo(zipPath).completeBaseName() + ".dbi";
-  QString dbiPath = tempDir.filePath(dbiName);
-
-  // We need a modified data object where video path is relative to the ZIP root
-  SaveData zipData = data;
-  QFileInfo videoInfo(data.videoUrl);
-  QString videoFileName = videoInfo.fileName();
-  zipData.videoUrl = videoFileName; // Point to local file inside ZIP
-
-  if (!save(dbiPath, zipData)) {
-    if (errorMessage)
-      *errorMessage = QObject::tr("Échec de la sauvegarde du fichier .dbi");
-    return false;
-  }
+  for (const Chunk &chunk : chunks)
+    bytes.append(chunk.payload);
+  return bytes;
+}
 
-  // 3. Copy video file
+bool SaveManager::saveWithMedia(const QString &zipPath, const SaveData &data,
+                                QString *errorMessage,
+                                const ProgressCallback &progress) {
   QString videoSource = data.videoUrl;
   if (videoSource.startsWith("file://")) {
     videoSource = QUrl(videoSource).toLocalFile();
   }
 
-  QString videoDest = tempDir.filePath(videoFileName);
-  if (!QFile::copy(videoSource, videoDest)) {
-    qWarning() << "Failed to copy video file to temp dir:" << videoSource;
+  // A video played from another archive is copied from its range in it
+  MediaSource::ArchiveRange archived;
+  const bool isArchived = MediaSource::parse(videoSource, archived);
+  QFileInfo videoInfo(isArchived ? archived.archivePath : videoSource);
+  if (!MediaSource::exists(videoSource) || !videoInfo.isFile()) {
     if (errorMessage)
-      *errorMessage =
-          QObject::tr("Impossible de copier la vidéo dans l'archive.");
+      *errorMessage = QObject::tr("La vidéo du projet est introuvable.");
     return false;
   }
+  const QString videoName = isArchived
+                                ? videoInfo.completeBaseName() + ".mp4"
+                                : videoInfo.fileName();
+  const qint64 videoSize = isArchived ? archived.size : videoInfo.size();
+
+  // The .dbi points at the video next to it, at the archive root
+  SaveData zipData = sanitize(data);
+  zipData.videoUrl = videoName;
+  stampVideoIdentity(zipData, videoSource);
+  QByteArray dbi = encode(zipData);
+  QString dbiName = QFileInfo(zipPath).completeBaseName() + ".dbi";
 
-  // 4. Create ZIP archive
-  QProcess zipProcess;
-  zipProcess.setWorkingDirectory(tempDir.path());
-  QStringList args;
-
-#ifdef Q_OS_WIN
-  // On Windows, use PowerShell's Compress-Archive
-  QString sourcePath = QDir::toNativeSeparators(tempDir.path() + "/*");
-  QString destPath = QDir::toNativeSeparators(zipPath);
+  const qint64 total = dbi.size() + videoSize;
+  ZipWriter zip(zipPath);
+  if (progress) {
+    zip.setProgressCallback(
+        [&progress, total](qint64 written) { return progress(written, total); });
+  }
 
-  // Remove existing file first
-  if (QFile::exists(zipPath)) {
-    QFile::remove(zipPath);
+  // The MP4 is already compressed: store it, read once, written once
+  bool ok = zip.open() && zip.addData(dbiName, dbi, ZipWriter::Deflated);
+  if (ok && isArchived) {
+    std::unique_ptr<QIODevice> device(MediaSource::openDevice(videoSource));
+    if (!device) {
+      if (errorMessage)
+        *errorMessage = QObject::tr("La vidéo du projet est introuvable.");
+      return false;
+    }
+    ok = zip.addDevice(videoName, *device, videoInfo.lastModified());
+  } else if (ok) {
+    ok = zip.addFile(videoName, videoSource, ZipWriter::Stored);
   }
+  ok = ok && zip.close();
+  if (!ok && errorMessage)
+    *errorMessage = zip.errorString();
+  return ok;
+}
 
-  // Escape single quotes for PowerShell ('' is the escape sequence inside '')
-  QString escapedSource = sourcePath;
-  escapedSource.replace(QLatin1String("'"), QLatin1String("''"));
-  QString escapedDest = destPath;
-  escapedDest.replace(QLatin1String("'"), QLatin1String("''"));
-
-  zipProcess.setProgram("powershell");
-  args << "-Command"
-       << QString("Compress-Archive -Path '%1' -DestinationPath '%2' -Force")
-              .arg(escapedSource, escapedDest);
-#else
-  // On macOS and Linux, 'zip' is standard
-  zipProcess.setProgram("zip");
-  args << "-r" << zipPath << ".";
-#endif
-
-  zipProcess.setArguments(args);
-  zipProcess.start();
-
-  // Wait indefinitely for the process to finish
-  if (!zipProcess.waitForFinished(-1)) {
-    qWarning() << "Zip process failed to finish";
-    if (errorMessage)
-      *errorMessage = QObject::tr(
-          "Le processus de compression a échoué (timeout ou erreur interne).");
+bool SaveManager::load(const QString &filePath, SaveData &data) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
     return false;
   }
 
-  if (zipProcess.exitCode() != 0) {
-    qWarning() << "Zip process failed with code:" << zipProcess.exitCode();
-    qDebug() << zipProcess.readAllStandardError();
-    if (errorMessage)
-      *errorMessage = QObject::tr("Erreur lors de la compression (Code: %1)")
-                          .arg(zipProcess.exitCode());
+  // Mapped rather than read: chunks are checked and decoded in place
+  QElapsedTimer timer;
+  timer.start();
+  const qint64 size = file.size();
+  if (size > MAX_PROJECT_BYTES) {
+    qWarning() << "[SaveManager] Not a project (" << size << "bytes):"
+               << filePath;
     return false;
   }
+  uchar *mapped = size > 0 ? file.map(0, size) : nullptr;
+  QByteArray bytes =
+      mapped ? QByteArray::fromRawData(reinterpret_cast<const char *>(mapped),
+                                       static_cast<int>(size))
+             : file.read(size);
+  const bool decoded = decode(bytes, data);
+  bytes.clear();
+  if (mapped)
+    file.unmap(mapped);
+  if (!decoded)
+    return false;
 
+  qDebug() << "[SaveManager] Loaded" << size << "bytes,"
+           << data.tracks.size() << "tracks in" << timer.elapsed() << "ms";
+
+  // Resolve relative path
+  if (!data.videoUrl.isEmpty() && !MediaSource::isArchived(data.videoUrl)) {
+    QFileInfo videoInfo(data.videoUrl);
+    if (videoInfo.isRelative()) {
+      QDir saveDir = QFileInfo(filePath).dir();
+      data.videoUrl = saveDir.absoluteFilePath(data.videoUrl);
+    }
+  }
   return true;
 }
 
-bool SaveManager::load(const QString &filePath, SaveData &data) {
-  QFile file(filePath);
-  if (!file.open(QIODevice::ReadOnly)) {
+bool SaveManager::loadArchive(const QString &zipPath, SaveData &data,
+                              QString *errorMessage) {
+  auto failWith = [errorMessage](const QString &message) {
+    qWarning() << "[SaveManager]" << message;
+    if (errorMessage)
+      *errorMessage = message;
     return false;
+  };
+
+  // Only the central directory and the .dbi are read
+  ZipReader zip(zipPath);
+  if (!zip.open())
+    return failWith(zip.errorString());
+
+  const ZipReader::Entry *dbiEntry = nullptr;
+  for (const ZipReader::Entry &entry : zip.entries()) {
+    if (entry.name.endsWith(".dbi", Qt::CaseInsensitive)) {
+      dbiEntry = &entry;
+      break;
+    }
+  }
+  if (!dbiEntry)
+    return failWith(QObject::tr("L'archive ne contient pas de projet .dbi."));
+
+  QByteArray bytes = zip.read(*dbiEntry);
+  if (bytes.isEmpty())
+    return failWith(zip.errorString());
+  if (!decode(bytes, data))
+    return failWith(
+        QObject::tr("Le fichier est corrompu ou d'une version incompatible."));
+
+  if (data.videoUrl.isEmpty() || MediaSource::isArchived(data.videoUrl) ||
+      QFileInfo(data.videoUrl).isAbsolute())
+    return true;
+
+  // The video is played in place: its range of the archive, not a copy
+  const ZipReader::Entry *videoEntry = zip.find(data.videoUrl);
+  if (!videoEntry) {
+    data.videoUrl = QFileInfo(zipPath).dir().absoluteFilePath(data.videoUrl);
+    return true;
   }
+  if (videoEntry->method != 0)
+    return failWith(QObject::tr("La vidéo de l'archive est compressée : "
+                                "extrayez l'archive pour l'ouvrir."));
+
+  data.videoUrl = MediaSource::archiveSource(zipPath, videoEntry->dataOffset,
+                                             videoEntry->size);
+  qDebug() << "[SaveManager] Video" << videoEntry->name << "played from"
+           << zipPath << "at offset" << videoEntry->dataOffset;
+  return true;
+}
 
+bool SaveManager::decode(const QByteArray &bytes, SaveData &data) {
   // Header check
-  QByteArray header(m_header.size(), 0);
-  if (file.read(header.data(), m_header.size()) != m_header.size())
-    return false;
-
-  if (header != m_header) {
+  if (bytes.size() < V2_PREFIX_SIZE || bytes.size() > MAX_PROJECT_BYTES ||
+      !bytes.startsWith(m_header)) {
     qWarning() << "Invalid file header";
     return false;
   }
 
   // Version & Flags
-  char version, flags;
-  if (!file.getChar(&version) || !file.getChar(&flags))
+  const quint8 version = static_cast<quint8>(bytes.at(m_header.size()));
+  if (version > m_version) {
+    qWarning() << "Unsupported version:" << version;
+    return false;
+  }
+  return version >= 2 ? decodeChunks(bytes, data) : decodeV1(bytes, data);
+}
+
+bool SaveManager::decodeChunks(const QByteArray &bytes, SaveData &data) {
+  const char *raw = bytes.constData();
+  const quint32 count = qFromLittleEndian<quint32>(raw + V2_PREFIX_SIZE - 4);
+  const qint64 tocEnd = V2_PREFIX_SIZE + qint64(count) * TOC_ENTRY_SIZE;
+  if (count > MAX_CHUNKS || bytes.size() < tocEnd + 4)
     return false;
 
-  if (static_cast<quint8>(version) > m_version) {
-    qWarning() << "Unsupported version:" << static_cast<quint8>(version);
+  // The table of contents is checked first: every offset below is trusted
+  if (Checksum::crc32c(0, raw, tocEnd) !=
+      qFromLittleEndian<quint32>(raw + tocEnd)) {
+    qWarning() << "Integrity check failed (table of contents)";
     return false;
   }
 
-  // Payload Size (stored as little-endian)
-  quint32 payloadSizeLE;
-  if (file.read(reinterpret_cast<char *>(&payloadSizeLE),
-                sizeof(payloadSizeLE)) != sizeof(payloadSizeLE))
+  // Each known chunk at most once: tracks are decoded in parallel, two
+  // chunks for the same field would race
+  QList<ChunkRef> refs;
+  std::bitset<MAX_TRACKS> textSeen;
+  std::bitset<MAX_TRACKS> styleSeen;
+  bool settingsSeen = false;
+  int trackCount = 0;
+  qint64 trackBytes = 0;
+  qint64 decodedBytes = 0;
+  for (quint32 i = 0; i < count; ++i) {
+    const char *entry = raw + V2_PREFIX_SIZE + qint64(i) * TOC_ENTRY_SIZE;
+    ChunkRef ref;
+    ref.type = QByteArray(entry, 4);
+    ref.index = qFromLittleEndian<quint32>(entry + 4);
+    ref.offset = static_cast<qint64>(qFromLittleEndian<quint64>(entry + 8));
+    ref.size = qFromLittleEndian<quint32>(entry + 16);
+    ref.crc = qFromLittleEndian<quint32>(entry + 20);
+    if (ref.offset < tocEnd + 4 || ref.offset > bytes.size() ||
+        ref.size > bytes.size() - ref.offset)
+      return false;
+
+    if (ref.type == CHUNK_TEXT || ref.type == CHUNK_STYLE) {
+      if (ref.index >= MAX_TRACKS)
+        return false;
+      std::bitset<MAX_TRACKS> &seen =
+          ref.type == CHUNK_TEXT ? textSeen : styleSeen;
+      if (seen.test(ref.index) ||
+          (ref.type == CHUNK_STYLE && ref.size > MAX_JSON_CHUNK_BYTES))
+        return false;
+      seen.set(ref.index);
+      trackCount = qMax(trackCount, static_cast<int>(ref.index) + 1);
+      trackBytes += ref.size;
+      decodedBytes += qint64(ref.size) * (ref.type == CHUNK_TEXT
+                                              ? TEXT_DECODE_FACTOR
+                                              : JSON_DECODE_FACTOR);
+    } else if (ref.type == CHUNK_SETTINGS) {
+      if (settingsSeen || ref.size > MAX_JSON_CHUNK_BYTES)
+        return false;
+      settingsSeen = true;
+      decodedBytes += qint64(ref.size) * JSON_DECODE_FACTOR;
+    } else {
+      continue; // Written by a newer version: not ours to read
+    }
+    refs.append(ref);
+  }
+
+  decodedBytes += qint64(trackCount) * qint64(sizeof(TrackSaveData));
+  if (decodedBytes > MAX_DECODED_BYTES) {
+    qWarning() << "Project too large to decode:" << decodedBytes << "bytes";
     return false;
-  quint32 payloadSize = qFromLittleEndian(payloadSizeLE);
+  }
+
+  // Each chunk is verified on its own, only when it is decoded
+  auto payload = [raw](const ChunkRef &ref, QByteArray &out) {
+    const char *start = raw + ref.offset;
+    if (Checksum::crc32c(0, start, ref.size) != ref.crc)
+      return false;
+    out = QByteArray::fromRawData(start, static_cast<int>(ref.size));
+    return true;
+  };
 
-  // Payload
-  QByteArray maskedPayload = file.read(payloadSize);
-  if (maskedPayload.size() != static_cast<int>(payloadSize))
+  if (!settingsSeen)
     return false;
+  for (const ChunkRef &ref : refs) {
+    if (ref.type != CHUNK_SETTINGS)
+      continue;
+    QByteArray masked;
+    if (!payload(ref, masked)) {
+      qWarning() << "Integrity check failed (settings)";
+      return false;
+    }
+    QJsonDocument doc = QJsonDocument::fromJson(applyXorMask(masked));
+    if (!doc.isObject()) {
+      qWarning() << "Invalid JSON content";
+      return false;
+    }
+    decodeSettings(doc.object(), data);
+  }
 
-  // Checksum
-  QByteArray storedChecksum = file.read(32); // SHA-256 is 32 bytes
-  if (storedChecksum.size() != 32)
+  // Tracks are independent chunks: large ones are decoded in parallel,
+  // each writing only its own field of its own track
+  data.tracks = QList<TrackSaveData>(trackCount);
+  TrackSaveData *tracks = data.tracks.data();
+  std::atomic<bool> tracksOk{true};
+  auto decodeTrackChunk = [&](const ChunkRef &ref) {
+    if (ref.type == CHUNK_SETTINGS)
+      return;
+    QByteArray masked;
+    if (!payload(ref, masked)) {
+      qWarning() << "Integrity check failed (track" << ref.index << ")";
+      tracksOk = false;
+      return;
+    }
+    QByteArray content = applyXorMask(masked);
+    if (ref.type == CHUNK_TEXT) {
+      tracks[ref.index].text = QString::fromUtf8(content);
+    } else {
+      tracks[ref.index].style =
+          decodeStyle(QJsonDocument::fromJson(content).object());
+    }
+  };
+  if (trackBytes >= PARALLEL_DECODE_BYTES)
+    QtConcurrent::blockingMap(refs, decodeTrackChunk);
+  else
+    std::for_each(refs.begin(), refs.end(), decodeTrackChunk);
+  return tracksOk;
+}
+
+bool SaveManager::decodeV1(const QByteArray &bytes, SaveData &data) {
+  // Header, version and flags checked; then payload size (little-endian),
+  // payload and its SHA-256 (32 bytes)
+  const char *raw = bytes.constData();
+  const qint64 payloadOffset = m_header.size() + 2 + 4;
+  const quint32 payloadSize =
+      qFromLittleEndian<quint32>(raw + payloadOffset - 4);
+
+  // The stored size is checked against what the buffer holds before
+  // anything is allocated
+  if (qint64(payloadSize) + 32 > bytes.size() - payloadOffset ||
+      qint64(payloadSize) * JSON_DECODE_FACTOR > MAX_DECODED_BYTES) {
+    qWarning() << "Invalid payload size:" << payloadSize;
     return false;
+  }
+  const QByteArray storedChecksum =
+      QByteArray::fromRawData(raw + payloadOffset + payloadSize, 32);
 
-  QByteArray jsonPayload = applyXorMask(maskedPayload);
+  QByteArray jsonPayload = applyXorMask(QByteArray::fromRawData(
+      raw + payloadOffset, static_cast<int>(payloadSize)));
   QByteArray calculatedChecksum = calculateChecksum(jsonPayload);
 
   if (calculatedChecksum != storedChecksum) {
@@ -268,17 +480,7 @@ bool SaveManager::load(const QString &filePath, SaveData &data) {
   }
 
   QJsonObject root = doc.object();
-
-  // Robust loading with fallbacks
-  data.videoUrl = root.value("video_url").toString("");
-  data.videoVolume = (float)root.value("video_volume").toDouble(1.0);
-  data.audioInput1 = root.value("audio_input_1").toString("");
-  data.audioGain1 = (float)root.value("audio_gain_1").toDouble(1.0);
-  data.audioInput2 = root.value("audio_input_2").toString("");
-  data.audioGain2 = (float)root.value("audio_gain_2").toDouble(1.0);
-  data.enableTrack2 = root.value("enable_track_2").toBool(false);
-  data.scrollSpeed = root.value("scroll_speed").toInt(100);
-  data.isTextWhite = root.value("is_text_white").toBool(true);
+  decodeSettings(root, data);
 
   QJsonArray tracksArray = root.value("tracks").toArray();
   data.tracks.clear();
@@ -295,28 +497,75 @@ bool SaveManager::load(const QString &filePath, SaveData &data) {
 
       QJsonObject styleObj = trackObj.value("style").toObject();
       if (!styleObj.isEmpty()) {
-        trackData.style.globalSize = styleObj.value("font_size").toInt(16);
-        trackData.style.font.setPointSize(trackData.style.globalSize);
-        trackData.style.textColor =
-            QColor(styleObj.value("text_color").toString("#FFFFFFFF"));
-        trackData.style.backgroundColor =
-            QColor(styleObj.value("bg_color").toString("#FF282828"));
+        trackData.style = decodeStyle(styleObj);
       }
     }
     data.tracks.append(trackData);
   }
+  return true;
+}
 
-  // Resolve relative path
-  if (!data.videoUrl.isEmpty()) {
-    QFileInfo videoInfo(data.videoUrl);
-    if (videoInfo.isRelative()) {
-      QDir saveDir = QFileInfo(filePath).dir();
-      data.videoUrl = saveDir.absoluteFilePath(data.videoUrl);
-    }
+QJsonObject SaveManager::encodeStyle(const RythmoTrackStyle &style) {
+  QJsonObject styleObj;
+  styleObj["font_size"] = style.globalSize;
+  styleObj["text_color"] = style.textColor.name(QColor::HexArgb);
+  styleObj["bg_color"] = style.backgroundColor.name(QColor::HexArgb);
+  return styleObj;
+}
+
+RythmoTrackStyle SaveManager::decodeStyle(const QJsonObject &styleObj) {
+  RythmoTrackStyle style;
+  style.globalSize = styleObj.value("font_size").toInt(16);
+  style.font.setPointSize(style.globalSize);
+  style.textColor = QColor(styleObj.value("text_color").toString("#FFFFFFFF"));
+  style.backgroundColor =
+      QColor(styleObj.value("bg_color").toString("#FF282828"));
+  return style;
+}
+
+void SaveManager::stampVideoIdentity(SaveData &data,
+                                     const QString &videoSource) {
+  if (videoSource.isEmpty())
+    return;
+  MediaRelink::Identity identity = MediaRelink::identify(videoSource);
+  if (identity.isValid()) {
+    data.videoSize = identity.size;
+    data.videoFingerprint = identity.fingerprint;
   }
+}
 
-  file.close();
-  return true;
+QJsonObject SaveManager::encodeSettings(const SaveData &data) {
+  QJsonObject root;
+  root["video_url"] = data.videoUrl;
+  root["video_volume"] = data.videoVolume;
+  root["audio_input_1"] = data.audioInput1;
+  root["audio_gain_1"] = data.audioGain1;
+  root["audio_input_2"] = data.audioInput2;
+  root["audio_gain_2"] = data.audioGain2;
+  root["enable_track_2"] = data.enableTrack2;
+  root["scroll_speed"] = data.scrollSpeed;
+  root["is_text_white"] = data.isTextWhite;
+  if (!data.videoFingerprint.isEmpty()) {
+    // As a string: JSON numbers lose precision past 2^53
+    root["video_size"] = QString::number(data.videoSize);
+    root["video_fingerprint"] = data.videoFingerprint;
+  }
+  return root;
+}
+
+void SaveManager::decodeSettings(const QJsonObject &root, SaveData &data) {
+  // Robust loading with fallbacks
+  data.videoUrl = root.value("video_url").toString("");
+  data.videoVolume = (float)root.value("video_volume").toDouble(1.0);
+  data.audioInput1 = root.value("audio_input_1").toString("");
+  data.audioGain1 = (float)root.value("audio_gain_1").toDouble(1.0);
+  data.audioInput2 = root.value("audio_input_2").toString("");
+  data.audioGain2 = (float)root.value("audio_gain_2").toDouble(1.0);
+  data.enableTrack2 = root.value("enable_track_2").toBool(false);
+  data.scrollSpeed = root.value("scroll_speed").toInt(100);
+  data.isTextWhite = root.value("is_text_white").toBool(true);
+  data.videoSize = root.value("video_size").toString().toLongLong();
+  data.videoFingerprint = root.value("video_fingerprint").toString("");
 }
 
 SaveData SaveManager::sanitize(const SaveData &data) {
@@ -10,6 +10,8 @@
 #include <QStringList>
 #include <QUrl>
 
+#include <functional>
+
 #include "RythmoManager.h"
 
 /**
@@ -36,6 +38,10 @@ struct SaveData {
   int scrollSpeed;
   bool isTextWhite;
 
+  // Identity of the video, to find it again if it moves (see MediaRelink)
+  qint64 videoSize = 0;
+  QString videoFingerprint;
+
   // Backwards compatibility: tracks list converted to struct
   QList<TrackSaveData> tracks;
 };
@@ -43,6 +49,11 @@ struct SaveData {
 /**
  * @class SaveManager
  * @brief Handles serialization, obfuscation, and file I/O for .dbi files.
+ *
+ * Version 2 files are chunked: a table of contents, then settings and
+ * each track's text and style as separate chunks, each with its own
+ * CRC-32C. Loading checks only what it decodes and decodes large tracks
+ * in parallel. Version 1 files (one JSON payload and a SHA-256) still load.
  */
 class SaveManager : public QObject {
   Q_OBJECT
@@ -52,20 +63,38 @@ public:
 
   /**
    * @brief Saves the session data to a .dbi file.
+   *
+   * Written through QSaveFile: the previous file is only replaced once
+   * the new one is complete. Safe to call from a worker thread.
+   *
    * @param filePath Target file path.
    * @param data Data to save.
    * @return True if successful.
    */
   bool save(const QString &filePath, const SaveData &data);
-  bool saveWithMedia(const QString &zipPath, const SaveData &data,
-                     QString *errorMessage = nullptr);
 
   /**
-   * @brief Checks if the 'zip' utility is available (Unix only).
-   * @param errorMessage Optional pointer to store install instructions.
-   * @return True if zip is available (always true on Windows).
+   * @brief Called while archiving: bytes written so far and in total.
+   * @return false to cancel the save.
+   */
+  using ProgressCallback = std::function<bool(qint64 written, qint64 total)>;
+
+  /**
+   * @brief Saves the session and its video into a ZIP archive.
+   *
+   * Written in-process (ZipWriter): the video is stored uncompressed and
+   * streamed straight from its file, only the .dbi is deflated. The
+   * archive replaces @p zipPath only once complete.
+   *
+   * @param zipPath Target archive.
+   * @param data Data to save; the video is taken from data.videoUrl.
+   * @param errorMessage Optional: reason of a failure.
+   * @param progress Optional: progress reporting and cancellation.
+   * @return True if successful.
    */
-  static bool isZipAvailable(QString *errorMessage = nullptr);
+  bool saveWithMedia(const QString &zipPath, const SaveData &data,
+                     QString *errorMessage = nullptr,
+                     const ProgressCallback &progress = ProgressCallback());
 
   /**
    * @brief Loads session data from a .dbi file.
@@ -75,17 +104,72 @@ public:
    */
   bool load(const QString &filePath, SaveData &data);
 
+  /**
+   * @brief Loads a project archive written by saveWithMedia() in place.
+   *
+   * Only the central directory and the .dbi are read. A stored video is
+   * not extracted: data.videoUrl becomes its range of the archive (see
+   * MediaSource), played and exported from there.
+   *
+   * @param zipPath Source archive.
+   * @param data Reference to store loaded data.
+   * @param errorMessage Optional: reason of a failure.
+   * @return True if successful and integrity check passed.
+   */
+  bool loadArchive(const QString &zipPath, SaveData &data,
+                   QString *errorMessage = nullptr);
+
+  /**
+   * @brief Parses and verifies the .dbi byte layout (paths left as stored).
+   *
+   * Never trusts @p bytes: sizes and offsets are checked, and the memory
+   * the decode would allocate is bounded, before anything is decoded.
+   * Public for the fuzz harness (tools/fuzz).
+   */
+  bool decode(const QByteArray &bytes, SaveData &data);
+
   /**
    * @brief Normalizes paths and clamps values.
    */
   static SaveData sanitize(const SaveData &data);
 
+  /**
+   * @brief Track style as stored in the .dbi (size and colors).
+   */
+  static QJsonObject encodeStyle(const RythmoTrackStyle &style);
+
+  /**
+   * @brief Reads a style written by encodeStyle(), with defaults.
+   */
+  static RythmoTrackStyle decodeStyle(const QJsonObject &styleObj);
+
 private:
+  /**
+   * @brief Serializes sanitized data to the .dbi byte layout.
+   */
+  QByteArray encode(const SaveData &cleanData);
+
+  /** @brief v2: table of contents, then each chunk checked on its own. */
+  bool decodeChunks(const QByteArray &bytes, SaveData &data);
+
+  /** @brief v1: one masked JSON payload and its SHA-256. */
+  bool decodeV1(const QByteArray &bytes, SaveData &data);
+
+  /**
+   * @brief Records the size and fingerprint of @p videoSource in @p data.
+   *
+   * Kept as loaded when the video cannot be read (still missing).
+   */
+  static void stampVideoIdentity(SaveData &data, const QString &videoSource);
+
+  static QJsonObject encodeSettings(const SaveData &data);
+  static void decodeSettings(const QJsonObject &root, SaveData &data);
+
   QByteArray applyXorMask(const QByteArray &data);
   QByteArray calculateChecksum(const QByteArray &data);
 
   const QByteArray m_header = "DubInstanteFile";
-  const quint8 m_version = 1;
+  const quint8 m_version = 2;
   const quint8 m_xorKey = 0x5A; // Simple static key for obfuscation
 };
 
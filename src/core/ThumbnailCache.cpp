@@ -0,0 +1,174 @@
+/**
+ * @file ThumbnailCache.cpp
+ * @brief Implementation of the ThumbnailCache class.
+ */
+
+#include "ThumbnailCache.h"
+#include "ExportCache.h"
+
+#include <QDir>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QTemporaryFile>
+#include <QThread>
+
+namespace {
+
+const QString CACHE_KIND = QStringLiteral("thumbnails");
+const QString CACHE_SUFFIX = QStringLiteral("jpg");
+
+// Decodes are short FFmpeg processes with their own threads: a few at a
+// time keep up with scrolling without starving playback
+int workerCount()
+{
+    return qBound(1, QThread::idealThreadCount() / 2, 4);
+}
+
+} // namespace
+
+ThumbnailCache::ThumbnailCache(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+    , m_images(static_cast<int>(MEMORY_BYTES / 1024))
+    , m_workers(0)
+{
+    m_pool.setMaxThreadCount(workerCount());
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_queue.clear();
+        ++m_generation;
+    }
+    m_pool.waitForDone();
+}
+
+void ThumbnailCache::setSource(const QString &source)
+{
+    QMutexLocker lock(&m_mutex);
+    if (source == m_source) {
+        return;
+    }
+    m_source = source;
+    ++m_generation;
+    m_images.clear();
+    m_queue.clear();
+    m_inFlight.clear();
+    m_failed.clear();
+}
+
+QImage ThumbnailCache::thumbnail(qint64 timeMs) const
+{
+    QMutexLocker lock(&m_mutex);
+    const QImage *image = m_images.object(timeMs);
+    return image ? *image : QImage();
+}
+
+void ThumbnailCache::request(const QList<qint64> &timesMs)
+{
+    QMutexLocker lock(&m_mutex);
+    m_queue.clear();
+    if (m_source.isEmpty()) {
+        return;
+    }
+    for (qint64 timeMs : timesMs) {
+        if (!m_images.contains(timeMs) && !m_inFlight.contains(timeMs)
+            && !m_failed.contains(timeMs) && !m_queue.contains(timeMs)) {
+            m_queue.append(timeMs);
+        }
+    }
+    while (m_workers < m_pool.maxThreadCount() && m_workers < m_queue.size()) {
+        ++m_workers;
+        m_pool.start([this]() { work(); });
+    }
+}
+
+void ThumbnailCache::work()
+{
+    for (;;) {
+        QString source;
+        quint64 generation;
+        qint64 timeMs;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (m_queue.isEmpty()) {
+                --m_workers;
+                return;
+            }
+            timeMs = m_queue.takeFirst();
+            source = m_source;
+            generation = m_generation;
+            m_inFlight.insert(timeMs);
+        }
+
+        const QImage image = decode(source, timeMs);
+        {
+            QMutexLocker lock(&m_mutex);
+            if (generation != m_generation) {
+                continue;   // Another video since (or shutting down)
+            }
+            m_inFlight.remove(timeMs);
+            if (image.isNull()) {
+                m_failed.insert(timeMs);
+                continue;
+            }
+            m_images.insert(timeMs, new QImage(image),
+                            qMax<int>(1, static_cast<int>(image.sizeInBytes() / 1024)));
+        }
+        emit thumbnailReady(timeMs);
+    }
+}
+
+QImage ThumbnailCache::decode(const QString &source, qint64 timeMs) const
+{
+    QImage image;
+    QString key;
+    const QString fingerprint = ExportCache::fingerprint(source);
+    if (!fingerprint.isEmpty()) {
+        key = ExportCache::key(QStringList() << CACHE_KIND << fingerprint
+                                             << QString::number(THUMBNAIL_HEIGHT)
+                                             << QString::number(timeMs));
+        const QString cached = ExportCache::lookup(CACHE_KIND, key, CACHE_SUFFIX);
+        if (!cached.isEmpty() && image.load(cached)) {
+            return image;
+        }
+    }
+
+    // Input seek to the keyframe at or before timeMs, keyframes only: a
+    // single intra frame is decoded, never the GOP leading up to timeMs
+    QProcess process;
+    process.start("ffmpeg", QStringList()
+        << "-v" << "error" << "-nostdin"
+        << "-skip_frame" << "nokey"
+        << "-noaccurate_seek"
+        << "-ss" << QString::number(timeMs / 1000.0, 'f', 3)
+        << "-i" << source
+        << "-an" << "-sn"
+        << "-frames:v" << "1"
+        << "-vf" << QString("scale=-2:%1").arg(THUMBNAIL_HEIGHT)
+        << "-f" << "image2pipe" << "-c:v" << "mjpeg" << "-q:v" << "5"
+        << "pipe:1");
+    if (!process.waitForFinished(DECODE_TIMEOUT_MS)) {
+        process.kill();
+        process.waitForFinished(1000);
+        return QImage();
+    }
+    const QByteArray jpeg = process.readAllStandardOutput();
+    if (!image.loadFromData(jpeg, "JPG")) {
+        return QImage();
+    }
+
+    // Written aside, then moved into the cache in one rename
+    if (!key.isEmpty()) {
+        QTemporaryFile file(QDir(ExportCache::workDirectory()).filePath("thumbnail-XXXXXX"));
+        file.setAutoRemove(false);
+        const bool written = file.open() && file.write(jpeg) == jpeg.size();
+        file.close();
+        if (!written || ExportCache::insert(CACHE_KIND, key, CACHE_SUFFIX, file.fileName()).isEmpty()) {
+            QFile::remove(file.fileName());
+        }
+    }
+    return image;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file ThumbnailCache.h
+ * @brief Video thumbnails for the filmstrip, decoded in the background.
+ *
+ * Thumbnails are keyframes: FFmpeg seeks to the keyframe at or before the
+ * requested time and decodes that single intra frame, which is the cheapest
+ * frame there is on long-GOP sources. A small thread pool works through the
+ * requested times, latest request first, so the thumbnails on screen come
+ * before the ones scrolled away.
+ *
+ * Decoded thumbnails are kept in a memory LRU (capped at MEMORY_BYTES) and
+ * as JPEG files in the export cache under the content fingerprint of the
+ * video, so a reopened video shows its filmstrip without decoding.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note thumbnail() never blocks: it only looks in memory.
+ */
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+
+/**
+ * @class ThumbnailCache
+ * @brief Asynchronous, cached keyframe thumbnails of one video.
+ *
+ * @example
+ * @code
+ * auto thumbnails = new ThumbnailCache(this);
+ * thumbnails->setSource(videoPath);
+ * connect(thumbnails, &ThumbnailCache::thumbnailReady, widget, qOverload<>(&QWidget::update));
+ *
+ * // Paint event
+ * QImage image = thumbnails->thumbnail(timeMs);
+ * if (image.isNull()) {
+ *     missing.append(timeMs);     // Drawn on a later repaint
+ * }
+ * ...
+ * thumbnails->request(missing);
+ * @endcode
+ */
+class ThumbnailCache : public QObject {
+    Q_OBJECT
+
+public:
+    /** @brief Height of the decoded thumbnails, in pixels (width follows the video). */
+    static constexpr int THUMBNAIL_HEIGHT = 72;
+
+    /** @brief Memory held by decoded thumbnails (16 MiB, ~1000 thumbnails). */
+    static constexpr qint64 MEMORY_BYTES = 16LL * 1024 * 1024;
+
+    /** @brief Longest a single thumbnail may take to decode. */
+    static constexpr int DECODE_TIMEOUT_MS = 10000;
+
+    explicit ThumbnailCache(QObject *parent = nullptr);
+
+    /**
+     * @brief Drops the pending requests and waits for running decodes.
+     */
+    ~ThumbnailCache() override;
+
+    /**
+     * @brief Switches to another video; pending requests are dropped.
+     * @param source Video file or archived source (empty: none).
+     */
+    void setSource(const QString &source);
+
+    /**
+     * @brief Returns the thumbnail at @p timeMs if decoded, else a null image.
+     */
+    QImage thumbnail(qint64 timeMs) const;
+
+    /**
+     * @brief Queues thumbnails to decode, most wanted first.
+     *
+     * Replaces the previous requests that have not started: callers pass
+     * what is on screen now.
+     */
+    void request(const QList<qint64> &timesMs);
+
+signals:
+    /** @brief A requested thumbnail is now available from thumbnail(). */
+    void thumbnailReady(qint64 timeMs);
+
+private:
+    void work();
+    QImage decode(const QString &source, qint64 timeMs) const;
+
+    QThreadPool m_pool;
+    mutable QMutex m_mutex;             ///< Guards everything below
+    QString m_source;
+    quint64 m_generation;               ///< Bumped by setSource(): results of older sources are dropped
+    mutable QCache<qint64, QImage> m_images;    ///< Cost in KiB; lookups refresh the LRU order
+    QList<qint64> m_queue;
+    QSet<qint64> m_inFlight;
+    QSet<qint64> m_failed;              ///< Not asked again (past the end, no video...)
+    int m_workers;
+};
+
+#endif // THUMBNAILCACHE_H
@@ -0,0 +1,217 @@
+/**
+ * @file ToolCapabilities.cpp
+ * @brief Implementation of the ToolCapabilities helpers.
+ */
+
+#include "ToolCapabilities.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+namespace {
+
+constexpr int PROBE_TIMEOUT_MS = 5000;
+
+struct Capabilities {
+    ToolInfo ffmpeg;
+    ToolInfo ffprobe;
+};
+
+QMutex s_mutex;
+QFuture<void> s_probe;
+bool s_probeStarted = false;
+Capabilities s_capabilities;
+
+QString persistPath()
+{
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    dir.mkpath(".");
+    return dir.filePath("tools.json");
+}
+
+/** Identity of a binary: a new build or install changes it. */
+QString binaryStamp(const QFileInfo &info)
+{
+    return QString("%1|%2|%3").arg(info.absoluteFilePath())
+                              .arg(info.size())
+                              .arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+QString run(const QString &program, const QStringList &args)
+{
+    QProcess process;
+    process.start(program, args);
+    if (!process.waitForFinished(PROBE_TIMEOUT_MS) || process.exitCode() != 0) {
+        process.kill();
+        return QString();
+    }
+    return QString::fromUtf8(process.readAllStandardOutput());
+}
+
+/**
+ * Names listed by `ffmpeg -encoders` / `-muxers`: after the dashed line,
+ * each row is "<flags> <name> <description>".
+ */
+QStringList parseList(const QString &output)
+{
+    QStringList names;
+    bool inTable = false;
+    const QStringList lines = output.split('\n');
+    for (const QString &line : lines) {
+        QString trimmed = line.trimmed();
+        if (!inTable) {
+            inTable = trimmed.startsWith("--");
+            continue;
+        }
+        QStringList columns = trimmed.split(' ', Qt::SkipEmptyParts);
+        if (columns.size() >= 2) {
+            // Muxers may list aliases: "matroska,webm"
+            names << columns[1].split(',');
+        }
+    }
+    return names;
+}
+
+ToolInfo toolFromJson(const QJsonObject &object)
+{
+    ToolInfo info;
+    info.available = object.value("available").toBool();
+    info.path = object.value("path").toString();
+    info.version = object.value("version").toString();
+    for (const QJsonValue &value : object.value("encoders").toArray()) {
+        info.encoders << value.toString();
+    }
+    for (const QJsonValue &value : object.value("muxers").toArray()) {
+        info.muxers << value.toString();
+    }
+    return info;
+}
+
+QJsonObject toolToJson(const ToolInfo &info)
+{
+    QJsonObject object;
+    object["available"] = info.available;
+    object["path"] = info.path;
+    object["version"] = info.version;
+    object["encoders"] = QJsonArray::fromStringList(info.encoders);
+    object["muxers"] = QJsonArray::fromStringList(info.muxers);
+    return object;
+}
+
+/**
+ * Probes @p program, or reuses the persisted result for the same binary.
+ * @param known Persisted results (stamp -> tool object).
+ * @param current Receives the result of this binary, to persist.
+ */
+ToolInfo probeTool(const QString &program, bool listCodecs, const QJsonObject &known,
+                   QJsonObject &current)
+{
+    ToolInfo info;
+    info.path = QStandardPaths::findExecutable(program);
+    if (info.path.isEmpty()) {
+        return info;
+    }
+
+    QString stamp = binaryStamp(QFileInfo(info.path));
+    if (known.contains(stamp)) {
+        current.insert(stamp, known.value(stamp));
+        return toolFromJson(known.value(stamp).toObject());
+    }
+
+    QString banner = run(info.path, QStringList() << "-hide_banner" << "-version");
+    info.available = !banner.isEmpty();
+    info.version = banner.section('\n', 0, 0).trimmed();
+    if (info.available && listCodecs) {
+        info.encoders = parseList(run(info.path, QStringList() << "-hide_banner" << "-encoders"));
+        info.muxers = parseList(run(info.path, QStringList() << "-hide_banner" << "-muxers"));
+    }
+    current.insert(stamp, toolToJson(info));
+    return info;
+}
+
+void probeAll()
+{
+    QJsonObject known;
+    QFile file(persistPath());
+    if (file.open(QIODevice::ReadOnly)) {
+        known = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+    }
+
+    // Only the binaries found now are kept: an upgrade drops the old entry
+    QJsonObject current;
+    Capabilities capabilities;
+    capabilities.ffmpeg = probeTool("ffmpeg", true, known, current);
+    capabilities.ffprobe = probeTool("ffprobe", false, known, current);
+
+    if (current != known) {
+        QSaveFile out(persistPath());
+        if (out.open(QIODevice::WriteOnly)) {
+            out.write(QJsonDocument(current).toJson(QJsonDocument::Compact));
+            out.commit();
+        }
+    }
+
+    qDebug() << "[ToolCapabilities]" << capabilities.ffmpeg.version
+             << "-" << capabilities.ffmpeg.encoders.size() << "encoders,"
+             << capabilities.ffmpeg.muxers.size() << "muxers; ffprobe:"
+             << capabilities.ffprobe.available;
+
+    QMutexLocker lock(&s_mutex);
+    s_capabilities = capabilities;
+}
+
+Capabilities snapshot()
+{
+    QFuture<void> probe = ToolCapabilities::probeInBackground();
+    probe.waitForFinished();    // Instant once done
+
+    QMutexLocker lock(&s_mutex);
+    return s_capabilities;
+}
+
+} // namespace
+
+namespace ToolCapabilities {
+
+QFuture<void> probeInBackground()
+{
+    QMutexLocker lock(&s_mutex);
+    if (!s_probeStarted) {
+        s_probeStarted = true;
+        s_probe = QtConcurrent::run(probeAll);
+    }
+    return s_probe;
+}
+
+ToolInfo ffmpeg()
+{
+    return snapshot().ffmpeg;
+}
+
+ToolInfo ffprobe()
+{
+    return snapshot().ffprobe;
+}
+
+bool hasEncoder(const QString &name)
+{
+    return ffmpeg().encoders.contains(name);
+}
+
+bool hasMuxer(const QString &name)
+{
+    return ffmpeg().muxers.contains(name);
+}
+
+} // namespace ToolCapabilities
@@ -0,0 +1,67 @@
+/**
+ * @file ToolCapabilities.h
+ * @brief Cached, background probing of the external tools (FFmpeg, ffprobe).
+ *
+ * Spawning `ffmpeg -version` to answer "is FFmpeg there?" costs up to
+ * seconds and used to block the GUI thread. Tools are now probed once in
+ * the background at startup: version, and for FFmpeg the encoders and
+ * muxers it was built with. Results are persisted keyed by the binary's
+ * path, size and modification time, so later runs answer without
+ * spawning anything until the binary changes.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note Thread-safe.
+ */
+
+#ifndef TOOLCAPABILITIES_H
+#define TOOLCAPABILITIES_H
+
+#include <QFuture>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @struct ToolInfo
+ * @brief What one external tool provides.
+ */
+struct ToolInfo {
+    bool available = false;     ///< Found in PATH and runs
+    QString path;               ///< Resolved executable
+    QString version;            ///< First line of its version banner
+    QStringList encoders;       ///< FFmpeg only: encoder names (e.g. "libx264")
+    QStringList muxers;         ///< FFmpeg only: muxer names (e.g. "mp4")
+};
+
+/**
+ * @namespace ToolCapabilities
+ * @brief Probe once, answer instantly afterwards.
+ */
+namespace ToolCapabilities {
+
+/**
+ * @brief Starts probing every tool on the global thread pool.
+ *
+ * Call once at startup. Later calls return the same future.
+ */
+QFuture<void> probeInBackground();
+
+/**
+ * @brief FFmpeg capabilities.
+ *
+ * Instant once probed; waits for the background probe if it is still
+ * running, or probes now if it was never started.
+ */
+ToolInfo ffmpeg();
+
+/** @brief ffprobe capabilities (same rules as ffmpeg()). */
+ToolInfo ffprobe();
+
+/** @brief Returns true if FFmpeg has the encoder @p name. */
+bool hasEncoder(const QString &name);
+
+/** @brief Returns true if FFmpeg has the muxer @p name. */
+bool hasMuxer(const QString &name);
+
+} // namespace ToolCapabilities
+
+#endif // TOOLCAPABILITIES_H
@@ -0,0 +1,578 @@
+/**
+ * @file ZipReader.cpp
+ * @brief Implementation of the ZipReader class.
+ */
+
+#include "ZipReader.h"
+#include "Checksum.h"
+
+#include <QDebug>
+#include <QtEndian>
+
+namespace {
+
+constexpr quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+constexpr quint32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+constexpr quint32 END_SIGNATURE = 0x06054b50;
+constexpr quint32 ZIP64_END_SIGNATURE = 0x06064b50;
+constexpr quint32 ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+constexpr quint16 ZIP64_EXTRA_ID = 0x0001;
+
+constexpr int END_RECORD_SIZE = 22;
+constexpr int ZIP64_LOCATOR_SIZE = 20;
+constexpr int CENTRAL_HEADER_SIZE = 46;
+constexpr int LOCAL_HEADER_SIZE = 30;
+constexpr int MAX_COMMENT = 0xFFFF;
+
+// Far more than a project archive holds: bounds what a corrupt file costs
+constexpr qint64 MAX_DIRECTORY_BYTES = 16LL * 1024 * 1024;
+
+template <typename T>
+T get(const QByteArray &bytes, qint64 offset)
+{
+    return qFromLittleEndian<T>(bytes.constData() + offset);
+}
+
+// =============================================================================
+// Inflate (RFC 1951), for the small deflated entries such as the .dbi
+// =============================================================================
+
+/** Canonical Huffman code: number of codes per length, symbols by code. */
+struct Huffman {
+    short count[16];
+    short symbol[288];
+};
+
+class Inflater {
+public:
+    Inflater(const QByteArray &input, qint64 expectedSize)
+        : m_in(reinterpret_cast<const uchar *>(input.constData()))
+        , m_inSize(input.size())
+        , m_expected(expectedSize)
+    {
+        m_out.reserve(static_cast<int>(expectedSize));
+    }
+
+    bool run()
+    {
+        int last = 0;
+        do {
+            int type = 0;
+            if (!bits(1, last) || !bits(2, type)) {
+                return false;
+            }
+            bool ok = (type == 0)   ? stored()
+                      : (type == 1) ? fixed()
+                      : (type == 2) ? dynamic()
+                                    : false;
+            if (!ok) {
+                return false;
+            }
+        } while (!last);
+        return m_out.size() == m_expected;
+    }
+
+    QByteArray result() const { return m_out; }
+
+private:
+    bool bits(int need, int &value)
+    {
+        quint32 buffer = m_bitBuffer;
+        while (m_bitCount < need) {
+            if (m_inPos >= m_inSize) {
+                return false;
+            }
+            buffer |= quint32(m_in[m_inPos++]) << m_bitCount;
+            m_bitCount += 8;
+        }
+        value = static_cast<int>(buffer & ((1u << need) - 1));
+        m_bitBuffer = buffer >> need;
+        m_bitCount -= need;
+        return true;
+    }
+
+    bool stored()
+    {
+        m_bitBuffer = 0;    // Rest of the current byte is padding
+        m_bitCount = 0;
+        if (m_inPos + 4 > m_inSize) {
+            return false;
+        }
+        int length = m_in[m_inPos] | (m_in[m_inPos + 1] << 8);
+        int complement = m_in[m_inPos + 2] | (m_in[m_inPos + 3] << 8);
+        m_inPos += 4;
+        if (length != (~complement & 0xFFFF) || m_inPos + length > m_inSize
+            || m_out.size() + length > m_expected) {
+            return false;
+        }
+        m_out.append(reinterpret_cast<const char *>(m_in + m_inPos), length);
+        m_inPos += length;
+        return true;
+    }
+
+    /** Returns false if the lengths over-subscribe the code space. */
+    static bool build(Huffman &h, const short *lengths, int n)
+    {
+        for (short &c : h.count) {
+            c = 0;
+        }
+        for (int symbol = 0; symbol < n; ++symbol) {
+            h.count[lengths[symbol]]++;
+        }
+        int left = 1;
+        for (int len = 1; len < 16; ++len) {
+            left = (left << 1) - h.count[len];
+            if (left < 0) {
+                return false;
+            }
+        }
+        short offsets[16];
+        offsets[1] = 0;
+        for (int len = 1; len < 15; ++len) {
+            offsets[len + 1] = offsets[len] + h.count[len];
+        }
+        for (int symbol = 0; symbol < n; ++symbol) {
+            if (lengths[symbol] != 0) {
+                h.symbol[offsets[lengths[symbol]]++] = static_cast<short>(symbol);
+            }
+        }
+        return true;
+    }
+
+    int decode(const Huffman &h)
+    {
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int len = 1; len < 16; ++len) {
+            int bit = 0;
+            if (!bits(1, bit)) {
+                return -1;
+            }
+            code |= bit;
+            int count = h.count[len];
+            if (code - count < first) {
+                return h.symbol[index + (code - first)];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    bool codes(const Huffman &lengthCode, const Huffman &distanceCode)
+    {
+        static const short lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+                                              31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195,
+                                              227, 258 };
+        static const short lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                               2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const short distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97,
+                                                129, 193, 257, 385, 513, 769, 1025, 1537, 2049,
+                                                3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const short distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                                 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12,
+                                                 13, 13 };
+        for (;;) {
+            int symbol = decode(lengthCode);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < 256) {
+                if (m_out.size() >= m_expected) {
+                    return false;
+                }
+                m_out.append(static_cast<char>(symbol));
+                continue;
+            }
+            if (symbol == 256) {
+                return true;    // End of block
+            }
+
+            symbol -= 257;
+            int extra = 0;
+            if (symbol >= 29 || !bits(lengthExtra[symbol], extra)) {
+                return false;
+            }
+            int length = lengthBase[symbol] + extra;
+
+            symbol = decode(distanceCode);
+            if (symbol < 0 || symbol >= 30 || !bits(distanceExtra[symbol], extra)) {
+                return false;
+            }
+            int distance = distanceBase[symbol] + extra;
+            if (distance > m_out.size() || m_out.size() + length > m_expected) {
+                return false;
+            }
+            // Byte by byte: the copy may overlap what it appends
+            for (int i = 0; i < length; ++i) {
+                m_out.append(m_out.at(m_out.size() - distance));
+            }
+        }
+    }
+
+    bool fixed()
+    {
+        static Huffman lengthCode;
+        static Huffman distanceCode;
+        static const bool built = []() {
+            short lengths[288];
+            int symbol = 0;
+            for (; symbol < 144; ++symbol) lengths[symbol] = 8;
+            for (; symbol < 256; ++symbol) lengths[symbol] = 9;
+            for (; symbol < 280; ++symbol) lengths[symbol] = 7;
+            for (; symbol < 288; ++symbol) lengths[symbol] = 8;
+            build(lengthCode, lengths, 288);
+            for (symbol = 0; symbol < 30; ++symbol) lengths[symbol] = 5;
+            build(distanceCode, lengths, 30);
+            return true;
+        }();
+        Q_UNUSED(built);
+        return codes(lengthCode, distanceCode);
+    }
+
+    bool dynamic()
+    {
+        static const short order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5,
+                                         11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        int literalCount = 0;
+        int distanceCount = 0;
+        int codeCount = 0;
+        if (!bits(5, literalCount) || !bits(5, distanceCount) || !bits(4, codeCount)) {
+            return false;
+        }
+        literalCount += 257;
+        distanceCount += 1;
+        codeCount += 4;
+        if (literalCount > 286 || distanceCount > 30) {
+            return false;
+        }
+
+        short lengths[320] = {};
+        for (int i = 0; i < codeCount; ++i) {
+            int length = 0;
+            if (!bits(3, length)) {
+                return false;
+            }
+            lengths[order[i]] = static_cast<short>(length);
+        }
+        Huffman lengthCode;
+        if (!build(lengthCode, lengths, 19)) {
+            return false;
+        }
+
+        int index = 0;
+        while (index < literalCount + distanceCount) {
+            int symbol = decode(lengthCode);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < 16) {
+                lengths[index++] = static_cast<short>(symbol);
+                continue;
+            }
+            short repeated = 0;
+            int repeat = 0;
+            if (symbol == 16) {
+                if (index == 0 || !bits(2, repeat)) {
+                    return false;
+                }
+                repeated = lengths[index - 1];
+                repeat += 3;
+            } else if (symbol == 17) {
+                if (!bits(3, repeat)) {
+                    return false;
+                }
+                repeat += 3;
+            } else {
+                if (!bits(7, repeat)) {
+                    return false;
+                }
+                repeat += 11;
+            }
+            if (index + repeat > literalCount + distanceCount) {
+                return false;
+            }
+            while (repeat-- > 0) {
+                lengths[index++] = repeated;
+            }
+        }
+        if (lengths[256] == 0) {
+            return false;   // No end-of-block code
+        }
+
+        Huffman literalCode;
+        Huffman distanceCode;
+        if (!build(literalCode, lengths, literalCount)
+            || !build(distanceCode, lengths + literalCount, distanceCount)) {
+            return false;
+        }
+        return codes(literalCode, distanceCode);
+    }
+
+    const uchar *m_in;
+    qint64 m_inSize;
+    qint64 m_inPos = 0;
+    quint32 m_bitBuffer = 0;
+    int m_bitCount = 0;
+    qint64 m_expected;
+    QByteArray m_out;
+};
+
+/**
+ * Reads the Zip64 extended information of a central header: only the
+ * fields whose 32-bit value is 0xFFFFFFFF are present, in this order.
+ */
+bool applyZip64Extra(const QByteArray &extra, ZipReader::Entry &entry, bool sizeInExtra,
+                     bool compressedInExtra, bool offsetInExtra)
+{
+    qint64 pos = 0;
+    while (pos + 4 <= extra.size()) {
+        quint16 id = get<quint16>(extra, pos);
+        quint16 length = get<quint16>(extra, pos + 2);
+        pos += 4;
+        if (pos + length > extra.size()) {
+            return false;
+        }
+        if (id == ZIP64_EXTRA_ID) {
+            qint64 field = pos;
+            auto next = [&](qint64 &value) {
+                if (field + 8 > pos + length) {
+                    return false;
+                }
+                value = static_cast<qint64>(get<quint64>(extra, field));
+                field += 8;
+                return value >= 0;
+            };
+            return (!sizeInExtra || next(entry.size))
+                   && (!compressedInExtra || next(entry.compressedSize))
+                   && (!offsetInExtra || next(entry.headerOffset));
+        }
+        pos += length;
+    }
+    return !sizeInExtra && !compressedInExtra && !offsetInExtra;
+}
+
+} // namespace
+
+ZipReader::ZipReader(const QString &zipPath)
+    : m_file(zipPath)
+{
+}
+
+bool ZipReader::open()
+{
+    m_entries.clear();
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(QString("Impossible d'ouvrir l'archive : %1").arg(m_file.errorString()));
+    }
+
+    qint64 offset = 0;
+    qint64 size = 0;
+    qint64 count = 0;
+    if (!readCentralDirectory(offset, size, count) || !readEntries(offset, size, count)) {
+        return false;
+    }
+    qDebug() << "[ZipReader]" << m_file.fileName() << "-" << m_entries.size() << "entries";
+    return true;
+}
+
+const QList<ZipReader::Entry> &ZipReader::entries() const
+{
+    return m_entries;
+}
+
+const ZipReader::Entry *ZipReader::find(const QString &name) const
+{
+    for (const Entry &entry : m_entries) {
+        if (entry.name == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+QByteArray ZipReader::read(const Entry &entry)
+{
+    if (entry.size > MAX_READ_BYTES || entry.compressedSize > MAX_READ_BYTES) {
+        fail(QString("Entrée trop volumineuse pour être lue : %1").arg(entry.name));
+        return QByteArray();
+    }
+    if (!m_file.seek(entry.dataOffset)) {
+        fail(QString("Archive illisible : %1").arg(entry.name));
+        return QByteArray();
+    }
+    QByteArray raw = m_file.read(entry.compressedSize);
+    if (raw.size() != entry.compressedSize) {
+        fail(QString("Archive tronquée : %1").arg(entry.name));
+        return QByteArray();
+    }
+
+    QByteArray content;
+    if (entry.method == 0) {
+        content = raw;
+    } else if (entry.method == 8) {
+        Inflater inflater(raw, entry.size);
+        if (!inflater.run()) {
+            fail(QString("Données compressées invalides : %1").arg(entry.name));
+            return QByteArray();
+        }
+        content = inflater.result();
+    } else {
+        fail(QString("Méthode de compression non prise en charge (%1) : %2")
+                 .arg(entry.method)
+                 .arg(entry.name));
+        return QByteArray();
+    }
+
+    if (Checksum::crc32(0, content.constData(), content.size()) != entry.crc) {
+        fail(QString("Somme de contrôle invalide : %1").arg(entry.name));
+        return QByteArray();
+    }
+    return content;
+}
+
+QString ZipReader::path() const
+{
+    return m_file.fileName();
+}
+
+QString ZipReader::errorString() const
+{
+    return m_error;
+}
+
+// =============================================================================
+// Central directory
+// =============================================================================
+
+bool ZipReader::readCentralDirectory(qint64 &offset, qint64 &size, qint64 &count)
+{
+    // The end record is last, followed only by a comment of up to 64 KiB
+    const qint64 fileSize = m_file.size();
+    const qint64 tailSize = qMin<qint64>(fileSize, END_RECORD_SIZE + MAX_COMMENT);
+    m_file.seek(fileSize - tailSize);
+    const QByteArray tail = m_file.read(tailSize);
+    if (tail.size() != tailSize) {
+        return fail("Archive illisible.");
+    }
+
+    qint64 end = -1;
+    for (qint64 pos = tail.size() - END_RECORD_SIZE; pos >= 0; --pos) {
+        if (get<quint32>(tail, pos) == END_SIGNATURE) {
+            end = pos;
+            break;
+        }
+    }
+    if (end < 0) {
+        return fail("Ce fichier n'est pas une archive ZIP.");
+    }
+
+    count = get<quint16>(tail, end + 10);
+    size = get<quint32>(tail, end + 12);
+    offset = get<quint32>(tail, end + 16);
+
+    if (count == 0xFFFF || size == 0xFFFFFFFFLL || offset == 0xFFFFFFFFLL) {
+        // Zip64: the locator just before the end record points at the real one
+        const qint64 locator = fileSize - tailSize + end - ZIP64_LOCATOR_SIZE;
+        if (locator < 0 || !m_file.seek(locator)) {
+            return fail("Archive Zip64 invalide.");
+        }
+        const QByteArray locatorBytes = m_file.read(ZIP64_LOCATOR_SIZE);
+        if (locatorBytes.size() != ZIP64_LOCATOR_SIZE
+            || get<quint32>(locatorBytes, 0) != ZIP64_LOCATOR_SIGNATURE) {
+            return fail("Archive Zip64 invalide.");
+        }
+        const qint64 zip64End = static_cast<qint64>(get<quint64>(locatorBytes, 8));
+        if (zip64End < 0 || zip64End > fileSize - 56 || !m_file.seek(zip64End)) {
+            return fail("Archive Zip64 invalide.");
+        }
+        const QByteArray record = m_file.read(56);
+        if (record.size() != 56 || get<quint32>(record, 0) != ZIP64_END_SIGNATURE) {
+            return fail("Archive Zip64 invalide.");
+        }
+        count = static_cast<qint64>(get<quint64>(record, 32));
+        size = static_cast<qint64>(get<quint64>(record, 40));
+        offset = static_cast<qint64>(get<quint64>(record, 48));
+    }
+
+    if (count < 0 || size < 0 || offset < 0 || size > MAX_DIRECTORY_BYTES
+        || offset + size > fileSize || count > size / CENTRAL_HEADER_SIZE) {
+        return fail("Répertoire central de l'archive invalide.");
+    }
+    return true;
+}
+
+bool ZipReader::readEntries(qint64 offset, qint64 size, qint64 count)
+{
+    const qint64 fileSize = m_file.size();
+    if (!m_file.seek(offset)) {
+        return fail("Archive illisible.");
+    }
+    const QByteArray directory = m_file.read(size);
+    if (directory.size() != size) {
+        return fail("Archive tronquée.");
+    }
+
+    qint64 pos = 0;
+    for (qint64 i = 0; i < count; ++i) {
+        if (pos + CENTRAL_HEADER_SIZE > size
+            || get<quint32>(directory, pos) != CENTRAL_HEADER_SIGNATURE) {
+            return fail("Répertoire central de l'archive invalide.");
+        }
+        Entry entry;
+        entry.method = get<quint16>(directory, pos + 10);
+        entry.crc = get<quint32>(directory, pos + 16);
+        entry.compressedSize = get<quint32>(directory, pos + 20);
+        entry.size = get<quint32>(directory, pos + 24);
+        const int nameLength = get<quint16>(directory, pos + 28);
+        const int extraLength = get<quint16>(directory, pos + 30);
+        const int commentLength = get<quint16>(directory, pos + 32);
+        entry.headerOffset = get<quint32>(directory, pos + 42);
+
+        const qint64 recordSize = CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+        if (pos + recordSize > size) {
+            return fail("Répertoire central de l'archive invalide.");
+        }
+        const quint16 flags = get<quint16>(directory, pos + 8);
+        const QByteArray name = directory.mid(pos + CENTRAL_HEADER_SIZE, nameLength);
+        entry.name = (flags & 0x0800) ? QString::fromUtf8(name) : QString::fromLatin1(name);
+
+        const QByteArray extra = directory.mid(pos + CENTRAL_HEADER_SIZE + nameLength, extraLength);
+        if (!applyZip64Extra(extra, entry, entry.size == 0xFFFFFFFFLL,
+                             entry.compressedSize == 0xFFFFFFFFLL,
+                             entry.headerOffset == 0xFFFFFFFFLL)) {
+            return fail(QString("Entrée Zip64 invalide : %1").arg(entry.name));
+        }
+        if (flags & 0x0001) {
+            return fail(QString("Entrée chiffrée non prise en charge : %1").arg(entry.name));
+        }
+        pos += recordSize;
+
+        // The data starts after the local header, whose extra field may
+        // differ from the central one
+        if (entry.headerOffset + LOCAL_HEADER_SIZE > fileSize || !m_file.seek(entry.headerOffset)) {
+            return fail(QString("Entrée invalide : %1").arg(entry.name));
+        }
+        const QByteArray local = m_file.read(LOCAL_HEADER_SIZE);
+        if (local.size() != LOCAL_HEADER_SIZE
+            || get<quint32>(local, 0) != LOCAL_HEADER_SIGNATURE) {
+            return fail(QString("Entrée invalide : %1").arg(entry.name));
+        }
+        entry.dataOffset = entry.headerOffset + LOCAL_HEADER_SIZE + get<quint16>(local, 26)
+                           + get<quint16>(local, 28);
+        if (entry.dataOffset + entry.compressedSize > fileSize) {
+            return fail(QString("Archive tronquée : %1").arg(entry.name));
+        }
+        m_entries.append(entry);
+    }
+    return true;
+}
+
+bool ZipReader::fail(const QString &message)
+{
+    m_error = message;
+    qWarning() << "[ZipReader]" << message;
+    return false;
+}
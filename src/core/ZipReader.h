@@ -0,0 +1,90 @@
+/**
+ * @file ZipReader.h
+ * @brief Reads the central directory of a ZIP archive and small entries.
+ *
+ * Counterpart of ZipWriter for project archives. Only the central
+ * directory is read on open; large stored entries (the video) are not
+ * extracted but located, so they can be played or fed to FFmpeg straight
+ * from their offset in the archive (see MediaSource).
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ */
+
+#ifndef ZIPREADER_H
+#define ZIPREADER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+/**
+ * @class ZipReader
+ * @brief Lists the entries of an archive and reads small ones.
+ *
+ * @example
+ * @code
+ * ZipReader zip("/path/to/project.zip");
+ * if (zip.open()) {
+ *     const ZipReader::Entry *dbi = zip.find("project.dbi");
+ *     QByteArray bytes = dbi ? zip.read(*dbi) : QByteArray();
+ * }
+ * @endcode
+ */
+class ZipReader {
+public:
+    /**
+     * @struct Entry
+     * @brief One file of the archive.
+     */
+    struct Entry {
+        QString name;               ///< Path inside the archive
+        quint16 method = 0;         ///< 0 = stored, 8 = deflated
+        quint32 crc = 0;
+        qint64 compressedSize = 0;
+        qint64 size = 0;
+        qint64 headerOffset = 0;    ///< Local header position
+        qint64 dataOffset = 0;      ///< First byte of the (compressed) data
+    };
+
+    /** @brief Largest entry read() loads into memory (64 MiB). */
+    static constexpr qint64 MAX_READ_BYTES = 64LL * 1024 * 1024;
+
+    explicit ZipReader(const QString &zipPath);
+
+    /**
+     * @brief Reads the central directory (Zip64 aware).
+     */
+    bool open();
+
+    /** @brief Entries in central directory order. */
+    const QList<Entry> &entries() const;
+
+    /**
+     * @brief Returns the entry named @p name, or nullptr.
+     */
+    const Entry *find(const QString &name) const;
+
+    /**
+     * @brief Reads and decompresses a small entry, checking its CRC-32.
+     * @return Content, or an empty array on error (see errorString()).
+     */
+    QByteArray read(const Entry &entry);
+
+    /** @brief Path of the archive. */
+    QString path() const;
+
+    /** @brief Human-readable reason of the last failure. */
+    QString errorString() const;
+
+private:
+    bool readCentralDirectory(qint64 &offset, qint64 &size, qint64 &count);
+    bool readEntries(qint64 offset, qint64 size, qint64 count);
+    bool fail(const QString &message);
+
+    QFile m_file;
+    QList<Entry> m_entries;
+    QString m_error;
+};
+
+#endif // ZIPREADER_H
@@ -0,0 +1,360 @@
+/**
+ * @file ZipWriter.cpp
+ * @brief Implementation of the ZipWriter class.
+ */
+
+#include "ZipWriter.h"
+#include "Checksum.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+namespace {
+
+// Large sequential reads keep the disk streaming; one buffer is reused
+constexpr qint64 CHUNK_BYTES = 4 * 1024 * 1024;
+
+// Above this, a 32-bit field holds 0xFFFFFFFF and the value goes to Zip64
+constexpr qint64 ZIP32_LIMIT = 0xFFFFFFFFLL;
+constexpr int ZIP16_LIMIT = 0xFFFF;
+
+constexpr quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+constexpr quint32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+constexpr quint32 END_SIGNATURE = 0x06054b50;
+constexpr quint32 ZIP64_END_SIGNATURE = 0x06064b50;
+constexpr quint32 ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+constexpr quint16 ZIP64_EXTRA_ID = 0x0001;
+
+constexpr quint16 VERSION_DEFAULT = 20;     // 2.0: deflate
+constexpr quint16 VERSION_ZIP64 = 45;       // 4.5: Zip64
+constexpr quint16 FLAG_UTF8 = 0x0800;       // Bit 11: names are UTF-8
+constexpr qint64 CRC_OFFSET = 14;           // In the local header
+
+template <typename T>
+void put(QByteArray &out, T value)
+{
+    T le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+
+/** 32-bit field value; 0xFFFFFFFF sends the reader to the Zip64 field. */
+quint32 clamp32(qint64 value)
+{
+    return value >= ZIP32_LIMIT ? 0xFFFFFFFFu : static_cast<quint32>(value);
+}
+
+void toDosDateTime(const QDateTime &dateTime, quint16 &time, quint16 &date)
+{
+    QDate d = dateTime.date();
+    QTime t = dateTime.time();
+    if (d.year() < 1980) {
+        d = QDate(1980, 1, 1);
+        t = QTime(0, 0);
+    }
+    time = static_cast<quint16>((t.hour() << 11) | (t.minute() << 5) | (t.second() / 2));
+    date = static_cast<quint16>(((d.year() - 1980) << 9) | (d.month() << 5) | d.day());
+}
+
+/**
+ * Raw deflate stream of @p data. qCompress produces a 4-byte length, then
+ * a zlib stream: a 2-byte header, the deflate data and a 4-byte Adler-32.
+ */
+QByteArray rawDeflate(const QByteArray &data)
+{
+    QByteArray zlib = qCompress(data, 9);
+    if (zlib.size() < 10) {
+        return QByteArray();
+    }
+    return zlib.mid(6, zlib.size() - 10);
+}
+
+} // namespace
+
+ZipWriter::ZipWriter(const QString &zipPath)
+    : m_file(zipPath)
+    , m_dataWritten(0)
+    , m_cancelled(false)
+    , m_closed(false)
+{
+}
+
+ZipWriter::~ZipWriter()
+{
+    if (m_file.isOpen() && !m_closed) {
+        m_file.cancelWriting();     // Nothing replaces the target
+    }
+}
+
+void ZipWriter::setProgressCallback(const ProgressCallback &callback)
+{
+    m_progress = callback;
+}
+
+bool ZipWriter::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly)) {
+        return fail(QString("Impossible de créer l'archive : %1").arg(m_file.errorString()));
+    }
+    return true;
+}
+
+// =============================================================================
+// Entries
+// =============================================================================
+
+bool ZipWriter::addData(const QString &name, const QByteArray &data, Compression compression)
+{
+    Entry entry;
+    entry.name = name.toUtf8();
+    entry.size = data.size();
+    entry.crc = Checksum::crc32(0, data.constData(), data.size());
+    toDosDateTime(QDateTime::currentDateTime(), entry.dosTime, entry.dosDate);
+
+    QByteArray payload = data;
+    if (compression == Deflated && !data.isEmpty()) {
+        QByteArray deflated = rawDeflate(data);
+        if (!deflated.isEmpty() && deflated.size() < data.size()) {
+            payload = deflated;
+            entry.method = 8;
+        }
+    }
+    entry.compressedSize = payload.size();
+
+    if (!writeLocalHeader(entry) || !write(payload)) {
+        return false;
+    }
+    m_entries.append(entry);
+    return reportProgress(data.size());
+}
+
+bool ZipWriter::addFile(const QString &name, const QString &sourcePath, Compression compression)
+{
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        return fail(QString("Impossible de lire %1 : %2").arg(sourcePath, source.errorString()));
+    }
+
+    if (compression == Deflated) {
+        return addData(name, source.readAll(), Deflated);
+    }
+    return addDevice(name, source, QFileInfo(source).lastModified());
+}
+
+bool ZipWriter::addDevice(const QString &name, QIODevice &source, const QDateTime &modified)
+{
+    Entry entry;
+    entry.name = name.toUtf8();
+    entry.size = source.size();
+    entry.compressedSize = entry.size;
+    toDosDateTime(modified, entry.dosTime, entry.dosDate);
+
+    // Sizes are known up front; the CRC is patched in once streamed
+    if (!writeLocalHeader(entry)) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QByteArray buffer(static_cast<int>(CHUNK_BYTES), Qt::Uninitialized);
+    qint64 copied = 0;
+    quint32 crc = 0;
+    while (copied < entry.size) {
+        qint64 read = source.read(buffer.data(), qMin(CHUNK_BYTES, entry.size - copied));
+        if (read <= 0) {
+            return fail(QString("Lecture interrompue de %1").arg(name));
+        }
+        crc = Checksum::crc32(crc, buffer.constData(), read);
+        if (m_file.write(buffer.constData(), read) != read) {
+            return fail(QString("Écriture de l'archive impossible : %1").arg(m_file.errorString()));
+        }
+        copied += read;
+        if (!reportProgress(read)) {
+            return false;
+        }
+    }
+    entry.crc = crc;
+
+    qint64 end = m_file.pos();
+    QByteArray crcField;
+    put<quint32>(crcField, crc);
+    if (!m_file.seek(entry.offset + CRC_OFFSET) || !write(crcField) || !m_file.seek(end)) {
+        return fail(QString("Écriture de l'archive impossible : %1").arg(m_file.errorString()));
+    }
+
+    qint64 elapsedMs = qMax<qint64>(1, timer.elapsed());
+    qDebug() << "[ZipWriter] Stored" << name << entry.size / (1024 * 1024) << "MiB in"
+             << elapsedMs << "ms (" << (entry.size / 1000) / elapsedMs << "MB/s )";
+
+    m_entries.append(entry);
+    return true;
+}
+
+bool ZipWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return fail("Archive non ouverte.");
+    }
+    if (!writeCentralDirectory()) {
+        return false;
+    }
+    if (!m_file.commit()) {
+        return fail(QString("Impossible d'enregistrer l'archive : %1").arg(m_file.errorString()));
+    }
+    m_closed = true;
+    return true;
+}
+
+QString ZipWriter::errorString() const
+{
+    return m_error;
+}
+
+bool ZipWriter::wasCancelled() const
+{
+    return m_cancelled;
+}
+
+// =============================================================================
+// Records
+// =============================================================================
+
+bool ZipWriter::writeLocalHeader(Entry &entry)
+{
+    entry.offset = m_file.pos();
+    const bool zip64 = entry.size >= ZIP32_LIMIT || entry.compressedSize >= ZIP32_LIMIT;
+
+    QByteArray header;
+    put<quint32>(header, LOCAL_HEADER_SIGNATURE);
+    put<quint16>(header, zip64 ? VERSION_ZIP64 : VERSION_DEFAULT);
+    put<quint16>(header, FLAG_UTF8);
+    put<quint16>(header, entry.method);
+    put<quint16>(header, entry.dosTime);
+    put<quint16>(header, entry.dosDate);
+    put<quint32>(header, entry.crc);
+    put<quint32>(header, clamp32(entry.compressedSize));
+    put<quint32>(header, clamp32(entry.size));
+    put<quint16>(header, static_cast<quint16>(entry.name.size()));
+    put<quint16>(header, zip64 ? 20 : 0);
+    header.append(entry.name);
+    if (zip64) {
+        // The local Zip64 field always carries both sizes
+        put<quint16>(header, ZIP64_EXTRA_ID);
+        put<quint16>(header, 16);
+        put<quint64>(header, static_cast<quint64>(entry.size));
+        put<quint64>(header, static_cast<quint64>(entry.compressedSize));
+    }
+    return write(header);
+}
+
+bool ZipWriter::writeCentralDirectory()
+{
+    const qint64 directoryOffset = m_file.pos();
+
+    QByteArray directory;
+    for (const Entry &entry : m_entries) {
+        // The central Zip64 field only carries the values that overflowed
+        QByteArray extra;
+        if (entry.size >= ZIP32_LIMIT) {
+            put<quint64>(extra, static_cast<quint64>(entry.size));
+        }
+        if (entry.compressedSize >= ZIP32_LIMIT) {
+            put<quint64>(extra, static_cast<quint64>(entry.compressedSize));
+        }
+        if (entry.offset >= ZIP32_LIMIT) {
+            put<quint64>(extra, static_cast<quint64>(entry.offset));
+        }
+        QByteArray extraField;
+        if (!extra.isEmpty()) {
+            put<quint16>(extraField, ZIP64_EXTRA_ID);
+            put<quint16>(extraField, static_cast<quint16>(extra.size()));
+            extraField.append(extra);
+        }
+        const quint16 version = extraField.isEmpty() ? VERSION_DEFAULT : VERSION_ZIP64;
+
+        put<quint32>(directory, CENTRAL_HEADER_SIGNATURE);
+        put<quint16>(directory, version);              // Made by (MS-DOS attributes)
+        put<quint16>(directory, version);              // Needed to extract
+        put<quint16>(directory, FLAG_UTF8);
+        put<quint16>(directory, entry.method);
+        put<quint16>(directory, entry.dosTime);
+        put<quint16>(directory, entry.dosDate);
+        put<quint32>(directory, entry.crc);
+        put<quint32>(directory, clamp32(entry.compressedSize));
+        put<quint32>(directory, clamp32(entry.size));
+        put<quint16>(directory, static_cast<quint16>(entry.name.size()));
+        put<quint16>(directory, static_cast<quint16>(extraField.size()));
+        put<quint16>(directory, 0);                    // Comment length
+        put<quint16>(directory, 0);                    // Disk number
+        put<quint16>(directory, 0);                    // Internal attributes
+        put<quint32>(directory, 0);                    // External attributes
+        put<quint32>(directory, clamp32(entry.offset));
+        directory.append(entry.name);
+        directory.append(extraField);
+    }
+    if (!write(directory)) {
+        return false;
+    }
+
+    const qint64 directorySize = directory.size();
+    const qint64 count = m_entries.size();
+    QByteArray end;
+    if (count >= ZIP16_LIMIT || directorySize >= ZIP32_LIMIT || directoryOffset >= ZIP32_LIMIT) {
+        const qint64 zip64EndOffset = m_file.pos();
+        put<quint32>(end, ZIP64_END_SIGNATURE);
+        put<quint64>(end, 44);                         // Size of the rest of the record
+        put<quint16>(end, VERSION_ZIP64);
+        put<quint16>(end, VERSION_ZIP64);
+        put<quint32>(end, 0);                          // This disk
+        put<quint32>(end, 0);                          // Disk of the central directory
+        put<quint64>(end, static_cast<quint64>(count));
+        put<quint64>(end, static_cast<quint64>(count));
+        put<quint64>(end, static_cast<quint64>(directorySize));
+        put<quint64>(end, static_cast<quint64>(directoryOffset));
+
+        put<quint32>(end, ZIP64_LOCATOR_SIGNATURE);
+        put<quint32>(end, 0);
+        put<quint64>(end, static_cast<quint64>(zip64EndOffset));
+        put<quint32>(end, 1);                          // Total disks
+    }
+
+    const quint16 count16 = count >= ZIP16_LIMIT ? 0xFFFF : static_cast<quint16>(count);
+    put<quint32>(end, END_SIGNATURE);
+    put<quint16>(end, 0);
+    put<quint16>(end, 0);
+    put<quint16>(end, count16);
+    put<quint16>(end, count16);
+    put<quint32>(end, clamp32(directorySize));
+    put<quint32>(end, clamp32(directoryOffset));
+    put<quint16>(end, 0);                              // Comment length
+    return write(end);
+}
+
+bool ZipWriter::write(const QByteArray &bytes)
+{
+    if (m_file.write(bytes) != bytes.size()) {
+        return fail(QString("Écriture de l'archive impossible : %1").arg(m_file.errorString()));
+    }
+    return true;
+}
+
+bool ZipWriter::reportProgress(qint64 bytes)
+{
+    m_dataWritten += bytes;
+    if (m_progress && !m_progress(m_dataWritten)) {
+        m_cancelled = true;
+        return fail("Sauvegarde annulée.");
+    }
+    return true;
+}
+
+bool ZipWriter::fail(const QString &message)
+{
+    m_error = message;
+    qWarning() << "[ZipWriter]" << message;
+    return false;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file ZipWriter.h
+ * @brief Streaming ZIP archive writer (stored and deflated entries, Zip64).
+ *
+ * Replaces the external `zip` / `Compress-Archive` for "save with media".
+ * Media is already compressed, so it is stored (method 0) and streamed
+ * straight from its source in large sequential chunks: the video is read
+ * once and written once, with no temporary copy. Small entries such as the
+ * .dbi are deflated in memory. Entries and archives past 4 GiB use Zip64.
+ *
+ * The archive is written through QSaveFile: it only replaces the target
+ * once close() succeeded, and a cancelled or failed archive leaves nothing.
+ *
+ * @note Part of the Core layer - no UI dependencies allowed.
+ * @note Not thread-safe: use one writer from one thread (e.g. QtConcurrent).
+ */
+
+#ifndef ZIPWRITER_H
+#define ZIPWRITER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QSaveFile>
+#include <QString>
+
+#include <functional>
+
+class QDateTime;
+class QIODevice;
+
+/**
+ * @class ZipWriter
+ * @brief Writes a ZIP archive entry by entry.
+ *
+ * @example
+ * @code
+ * ZipWriter zip("/path/to/project.zip");
+ * zip.setProgressCallback([&](qint64 written) {
+ *     reportProgress(written, total);
+ *     return !cancelled;              // false aborts the archive
+ * });
+ * bool ok = zip.open()
+ *           && zip.addData("project.dbi", dbi)                       // deflated
+ *           && zip.addFile("video.mp4", videoPath, ZipWriter::Stored) // streamed
+ *           && zip.close();
+ * @endcode
+ */
+class ZipWriter {
+public:
+    /**
+     * @enum Compression
+     * @brief How an entry is stored.
+     */
+    enum Compression {
+        Stored,     ///< Method 0: bytes copied as is (media, already compressed)
+        Deflated    ///< Method 8: compressed in memory (small files only)
+    };
+
+    /**
+     * @brief Called as data is written; return false to cancel.
+     * @param bytesWritten Bytes of entry data written so far, all entries together.
+     */
+    using ProgressCallback = std::function<bool(qint64 bytesWritten)>;
+
+    explicit ZipWriter(const QString &zipPath);
+
+    /**
+     * @brief Discards the archive unless close() succeeded.
+     */
+    ~ZipWriter();
+
+    ZipWriter(const ZipWriter &) = delete;
+    ZipWriter &operator=(const ZipWriter &) = delete;
+
+    /**
+     * @brief Sets the progress/cancellation callback (call before adding entries).
+     */
+    void setProgressCallback(const ProgressCallback &callback);
+
+    /**
+     * @brief Starts writing the archive (to a temporary file next to it).
+     */
+    bool open();
+
+    /**
+     * @brief Adds an entry from memory.
+     * @param name Path inside the archive ('/' separators).
+     * @param data Content.
+     * @param compression Deflated entries fall back to Stored if they would grow.
+     */
+    bool addData(const QString &name, const QByteArray &data,
+                 Compression compression = Deflated);
+
+    /**
+     * @brief Adds an entry from a file on disk.
+     *
+     * Stored entries are streamed in large chunks without loading the file;
+     * Deflated entries are read whole, for small files only.
+     *
+     * @param name Path inside the archive ('/' separators).
+     * @param sourcePath File to read.
+     * @param compression Stored for media.
+     */
+    bool addFile(const QString &name, const QString &sourcePath,
+                 Compression compression = Stored);
+
+    /**
+     * @brief Streams an open, random-access device as a Stored entry.
+     *
+     * Used for a video that is itself an entry of another archive
+     * (see MediaSource::openDevice).
+     *
+     * @param name Path inside the archive ('/' separators).
+     * @param source Device positioned at its start; size() bytes are copied.
+     * @param modified Timestamp of the entry.
+     */
+    bool addDevice(const QString &name, QIODevice &source, const QDateTime &modified);
+
+    /**
+     * @brief Writes the central directory and replaces the target file.
+     */
+    bool close();
+
+    /**
+     * @brief Human-readable reason of the last failure.
+     */
+    QString errorString() const;
+
+    /**
+     * @brief Returns true if the progress callback cancelled the archive.
+     */
+    bool wasCancelled() const;
+
+private:
+    /**
+     * @struct Entry
+     * @brief What the central directory needs to know about one entry.
+     */
+    struct Entry {
+        QByteArray name;        ///< UTF-8
+        quint16 method = 0;
+        quint16 dosTime = 0;
+        quint16 dosDate = 0;
+        quint32 crc = 0;
+        qint64 compressedSize = 0;
+        qint64 size = 0;
+        qint64 offset = 0;      ///< Local header position
+    };
+
+    bool writeLocalHeader(Entry &entry);
+    bool writeCentralDirectory();
+    bool write(const QByteArray &bytes);
+    bool reportProgress(qint64 bytes);
+    bool fail(const QString &message);
+
+    QSaveFile m_file;
+    QList<Entry> m_entries;
+    ProgressCallback m_progress;
+    qint64 m_dataWritten;
+    QString m_error;
+    bool m_cancelled;
+    bool m_closed;
+};
+
+#endif // ZIPWRITER_H
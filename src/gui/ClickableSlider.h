@@ -4,6 +4,7 @@
  * 
  * Standard QSlider requires dragging the handle. This subclass allows
  * clicking anywhere on the groove to jump to that position immediately.
+ * It can also draw an audio waveform behind the groove.
  * 
  * @note Part of the GUI layer - header-only implementation.
  */
@@ -11,11 +12,16 @@
 #ifndef CLICKABLESLIDER_H
 #define CLICKABLESLIDER_H
 
+#include "../core/PeakPyramid.h"
+
 #include <QMouseEvent>
+#include <QPainter>
 #include <QSlider>
 #include <QStyle>
 #include <QStyleOptionSlider>
 
+#include <memory>
+
 /**
  * @class ClickableSlider
  * @brief QSlider subclass with click-to-position functionality.
@@ -24,6 +30,7 @@
  * - Click anywhere on groove to jump to that position
  * - Standard drag behavior still works on handle
  * - Supports both horizontal and vertical orientations
+ * - Optional waveform behind the groove (horizontal, values in ms)
  */
 class ClickableSlider : public QSlider {
     Q_OBJECT
@@ -33,7 +40,43 @@ public:
         : QSlider(orientation, parent)
     {}
 
+    /**
+     * @brief Draws @p peaks behind the groove, the range being milliseconds.
+     * @param peaks nullptr removes the waveform.
+     */
+    void setWaveform(std::shared_ptr<const PeakPyramid> peaks)
+    {
+        m_waveform = std::move(peaks);
+        update();
+    }
+
 protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        if (m_waveform && orientation() == Qt::Horizontal && maximum() > minimum()) {
+            QStyleOptionSlider opt;
+            initStyleOption(&opt);
+            QRect handleRect = style()->subControlRect(
+                QStyle::CC_Slider, &opt, QStyle::SC_SliderHandle, this);
+
+            // Same span as the handle centre, one column per pixel
+            const int left = handleRect.width() / 2;
+            const int columns = width() - 2 * left;
+            const QVector<PeakPyramid::Peak> peaks =
+                m_waveform->query(minimum(), maximum(), columns);
+
+            QPainter painter(this);
+            painter.setPen(QColor(0, 120, 215, 90));
+            const double middle = height() / 2.0;
+            const double scale = middle - 2.0;
+            for (int x = 0; x < peaks.size(); ++x) {
+                painter.drawLine(QPointF(left + x + 0.5, middle - peaks[x].max * scale),
+                                 QPointF(left + x + 0.5, middle - peaks[x].min * scale));
+            }
+        }
+        QSlider::paintEvent(event);
+    }
+
     void mousePressEvent(QMouseEvent *event) override
     {
         if (event->button() != Qt::LeftButton) {
@@ -105,6 +148,8 @@ private:
         
         return val;
     }
+
+    std::shared_ptr<const PeakPyramid> m_waveform;
 };
 
 #endif // CLICKABLESLIDER_H
@@ -0,0 +1,198 @@
+/**
+ * @file ExportQueueDialog.cpp
+ * @brief Implementation of the ExportQueueDialog class.
+ */
+
+#include "ExportQueueDialog.h"
+#include "ExportQueue.h"
+
+#include <QDialogButtonBox>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+enum Column { FileColumn, StateColumn, PriorityColumn, ProgressColumn };
+
+QString stateText(ExportJob::State state) {
+  switch (state) {
+  case ExportJob::Queued:
+    return QObject::tr("En attente");
+  case ExportJob::Held:
+    return QObject::tr("Suspendu");
+  case ExportJob::Running:
+    return QObject::tr("En cours");
+  case ExportJob::Succeeded:
+    return QObject::tr("Terminé");
+  case ExportJob::Failed:
+    return QObject::tr("Échec");
+  case ExportJob::Cancelled:
+    return QObject::tr("Annulé");
+  }
+  return QString();
+}
+
+bool isPending(ExportJob::State state) {
+  return state == ExportJob::Queued || state == ExportJob::Held;
+}
+
+} // namespace
+
+ExportQueueDialog::ExportQueueDialog(ExportQueue *queue, QWidget *parent)
+    : QDialog(parent), m_queue(queue) {
+  setupUi();
+
+  connect(m_queue, &ExportQueue::jobChanged, this,
+          &ExportQueueDialog::onJobChanged);
+  connect(m_queue, &ExportQueue::jobRemoved, this,
+          &ExportQueueDialog::rebuild);
+
+  rebuild();
+}
+
+void ExportQueueDialog::setupUi() {
+  setWindowTitle(tr("File d'export"));
+  resize(640, 320);
+
+  QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+  m_jobList = new QTreeWidget(this);
+  m_jobList->setColumnCount(4);
+  m_jobList->setHeaderLabels(
+      {tr("Fichier"), tr("État"), tr("Priorité"), tr("Progression")});
+  m_jobList->setRootIsDecorated(false);
+  m_jobList->setSelectionMode(QAbstractItemView::SingleSelection);
+  m_jobList->header()->setSectionResizeMode(FileColumn, QHeaderView::Stretch);
+  m_jobList->header()->setStretchLastSection(false);
+  m_jobList->setColumnWidth(ProgressColumn, 140);
+  connect(m_jobList, &QTreeWidget::itemSelectionChanged, this,
+          &ExportQueueDialog::updateButtons);
+  mainLayout->addWidget(m_jobList);
+
+  // Job actions
+  QHBoxLayout *actionsLayout = new QHBoxLayout();
+  m_cancelButton = new QPushButton(tr("Annuler l'export"));
+  m_holdButton = new QPushButton(tr("Suspendre"));
+  m_raiseButton = new QPushButton(tr("Monter"));
+  m_lowerButton = new QPushButton(tr("Descendre"));
+  m_clearButton = new QPushButton(tr("Retirer les terminés"));
+  actionsLayout->addWidget(m_cancelButton);
+  actionsLayout->addWidget(m_holdButton);
+  actionsLayout->addWidget(m_raiseButton);
+  actionsLayout->addWidget(m_lowerButton);
+  actionsLayout->addStretch();
+  actionsLayout->addWidget(m_clearButton);
+  mainLayout->addLayout(actionsLayout);
+
+  connect(m_cancelButton, &QPushButton::clicked, this,
+          [this]() { m_queue->cancelJob(selectedJob()); });
+  connect(m_holdButton, &QPushButton::clicked, this, [this]() {
+    const ExportJob job = m_queue->job(selectedJob());
+    m_queue->setJobHeld(job.id, job.state == ExportJob::Queued);
+  });
+  // Priorities are relative: one step above or below the current value
+  connect(m_raiseButton, &QPushButton::clicked, this, [this]() {
+    const ExportJob job = m_queue->job(selectedJob());
+    m_queue->setJobPriority(job.id, job.priority + 1);
+  });
+  connect(m_lowerButton, &QPushButton::clicked, this, [this]() {
+    const ExportJob job = m_queue->job(selectedJob());
+    m_queue->setJobPriority(job.id, job.priority - 1);
+  });
+  connect(m_clearButton, &QPushButton::clicked, m_queue,
+          &ExportQueue::clearFinished);
+
+  QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+  connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+  mainLayout->addWidget(buttons);
+}
+
+void ExportQueueDialog::rebuild() {
+  const QString selected = selectedJob();
+  m_jobList->clear();
+
+  for (const ExportJob &job : m_queue->jobs()) {
+    QTreeWidgetItem *item = new QTreeWidgetItem(m_jobList);
+    item->setData(FileColumn, Qt::UserRole, job.id);
+
+    QProgressBar *progress = new QProgressBar(m_jobList);
+    progress->setRange(0, 100);
+    m_jobList->setItemWidget(item, ProgressColumn, progress);
+
+    updateItem(item);
+    if (job.id == selected)
+      item->setSelected(true);
+  }
+  updateButtons();
+}
+
+void ExportQueueDialog::onJobChanged(const QString &id) {
+  QTreeWidgetItem *item = findItem(id);
+  const QList<ExportJob> jobs = m_queue->jobs();
+  int index = -1;
+  for (int i = 0; i < jobs.size(); ++i) {
+    if (jobs.at(i).id == id) {
+      index = i;
+      break;
+    }
+  }
+
+  // New job, or a priority change moved it
+  if (!item || m_jobList->indexOfTopLevelItem(item) != index ||
+      m_jobList->topLevelItemCount() != jobs.size()) {
+    rebuild();
+    return;
+  }
+  updateItem(item);
+  if (item->isSelected())
+    updateButtons();
+}
+
+void ExportQueueDialog::updateItem(QTreeWidgetItem *item) {
+  const ExportJob job =
+      m_queue->job(item->data(FileColumn, Qt::UserRole).toString());
+
+  item->setText(FileColumn, QFileInfo(job.config.outputPath).fileName());
+  item->setToolTip(FileColumn, job.config.outputPath);
+  item->setText(StateColumn, stateText(job.state));
+  item->setToolTip(StateColumn, job.message);
+  item->setText(PriorityColumn, QString::number(job.priority));
+
+  if (auto *progress = qobject_cast<QProgressBar *>(
+          m_jobList->itemWidget(item, ProgressColumn))) {
+    progress->setValue(job.progress);
+  }
+}
+
+void ExportQueueDialog::updateButtons() {
+  const ExportJob job = m_queue->job(selectedJob());
+  const bool pending = !job.id.isEmpty() && isPending(job.state);
+
+  m_cancelButton->setEnabled(pending || job.state == ExportJob::Running);
+  m_holdButton->setEnabled(pending);
+  m_holdButton->setText(job.state == ExportJob::Held ? tr("Reprendre")
+                                                     : tr("Suspendre"));
+  m_raiseButton->setEnabled(pending);
+  m_lowerButton->setEnabled(pending);
+}
+
+QString ExportQueueDialog::selectedJob() const {
+  const QList<QTreeWidgetItem *> selection = m_jobList->selectedItems();
+  return selection.isEmpty()
+             ? QString()
+             : selection.first()->data(FileColumn, Qt::UserRole).toString();
+}
+
+QTreeWidgetItem *ExportQueueDialog::findItem(const QString &id) const {
+  for (int i = 0; i < m_jobList->topLevelItemCount(); ++i) {
+    QTreeWidgetItem *item = m_jobList->topLevelItem(i);
+    if (item->data(FileColumn, Qt::UserRole).toString() == id)
+      return item;
+  }
+  return nullptr;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file ExportQueueDialog.h
+ * @brief View of the export queue: per-job progress, cancel, hold, priority.
+ *
+ * Lists the jobs of an ExportQueue in scheduling order and follows them
+ * through ExportQueue::jobChanged. Queued and running jobs can be
+ * cancelled; jobs that have not started can be held, released and moved
+ * up or down the queue.
+ *
+ * @note Part of the GUI layer - the queue itself lives in ExportQueue.
+ */
+
+#ifndef EXPORTQUEUEDIALOG_H
+#define EXPORTQUEUEDIALOG_H
+
+#include <QDialog>
+
+class ExportQueue;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+/**
+ * @class ExportQueueDialog
+ * @brief Non-modal window over the export queue.
+ */
+class ExportQueueDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit ExportQueueDialog(ExportQueue *queue, QWidget *parent = nullptr);
+
+private:
+  void setupUi();
+
+  /** @brief Rebuilds the list in scheduling order, keeping the selection. */
+  void rebuild();
+
+  /** @brief Updates one job in place, or rebuilds if its place changed. */
+  void onJobChanged(const QString &id);
+
+  void updateItem(QTreeWidgetItem *item);
+  void updateButtons();
+
+  /** @brief Id of the selected job, or an empty string. */
+  QString selectedJob() const;
+
+  QTreeWidgetItem *findItem(const QString &id) const;
+
+  ExportQueue *m_queue;
+
+  QTreeWidget *m_jobList;
+  QPushButton *m_cancelButton;
+  QPushButton *m_holdButton;
+  QPushButton *m_raiseButton;
+  QPushButton *m_lowerButton;
+  QPushButton *m_clearButton;
+};
+
+#endif // EXPORTQUEUEDIALOG_H
@@ -0,0 +1,141 @@
+/**
+ * @file FilmstripWidget.cpp
+ * @brief Implementation of the FilmstripWidget class.
+ */
+
+#include "FilmstripWidget.h"
+#include "ThumbnailCache.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+
+#include <algorithm>
+
+FilmstripWidget::FilmstripWidget(ThumbnailCache *thumbnails, QWidget *parent)
+    : QWidget(parent), m_thumbnails(thumbnails), m_durationMs(0),
+      m_positionMs(0) {
+  setFixedHeight(STRIP_HEIGHT);
+  setCursor(Qt::PointingHandCursor);
+  hide();
+
+  connect(m_thumbnails, &ThumbnailCache::thumbnailReady, this,
+          [this]() { update(); });
+}
+
+// =============================================================================
+// Slots
+// =============================================================================
+
+void FilmstripWidget::setDuration(qint64 durationMs) {
+  m_durationMs = qMax<qint64>(0, durationMs);
+  setVisible(m_durationMs > 0);
+  update();
+}
+
+void FilmstripWidget::setPosition(qint64 positionMs) {
+  // Repaint only when the playhead moves by a pixel
+  const bool moved = xAt(positionMs) != xAt(m_positionMs);
+  m_positionMs = positionMs;
+  if (moved)
+    update();
+}
+
+// =============================================================================
+// Painting
+// =============================================================================
+
+void FilmstripWidget::paintEvent(QPaintEvent *) {
+  QPainter painter(this);
+  painter.fillRect(rect(), QColor(20, 20, 20));
+  if (m_durationMs <= 0 || width() <= 0)
+    return;
+  painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+  const int tileWidth = qMax(1, height() * 16 / 9);
+  const int tileCount = (width() + tileWidth - 1) / tileWidth;
+  const double msPerPixel = static_cast<double>(m_durationMs) / width();
+  const double tileAspect = static_cast<double>(tileWidth) / height();
+
+  // Thumbnail times on a power-of-two grid of seconds: after a resize most
+  // of them are already decoded
+  qint64 stepMs = 1000;
+  while (stepMs * 2 <= tileWidth * msPerPixel)
+    stepMs *= 2;
+
+  QList<qint64> missing;
+  for (int i = 0; i < tileCount; ++i) {
+    const QRect tile(i * tileWidth, 0, tileWidth, height());
+    const double centreMs = (tile.left() + tileWidth / 2.0) * msPerPixel;
+    const qint64 timeMs = qMin(qRound64(centreMs / stepMs) * stepMs,
+                               (m_durationMs - 1) / stepMs * stepMs);
+
+    const QImage image = m_thumbnails->thumbnail(timeMs);
+    if (image.isNull()) {
+      painter.fillRect(tile.adjusted(1, 1, -1, -1), QColor(45, 45, 45));
+      if (!missing.contains(timeMs))
+        missing.append(timeMs);
+      continue;
+    }
+
+    // Centre crop to the tile's shape
+    QRectF source(image.rect());
+    if (source.width() / source.height() > tileAspect) {
+      const double cropped = source.height() * tileAspect;
+      source.setLeft((source.width() - cropped) / 2.0);
+      source.setWidth(cropped);
+    } else {
+      const double cropped = source.width() / tileAspect;
+      source.setTop((source.height() - cropped) / 2.0);
+      source.setHeight(cropped);
+    }
+    painter.drawImage(QRectF(tile.adjusted(1, 1, -1, -1)), image, source);
+  }
+
+  // Nearest the playhead first; tiles no longer on screen are dropped
+  std::sort(missing.begin(), missing.end(), [this](qint64 a, qint64 b) {
+    return qAbs(a - m_positionMs) < qAbs(b - m_positionMs);
+  });
+  m_thumbnails->request(missing);
+
+  // Playhead
+  const int x = xAt(m_positionMs);
+  painter.setPen(QPen(QColor(0, 120, 215), 2));
+  painter.drawLine(x, 0, x, height());
+}
+
+// =============================================================================
+// Mouse
+// =============================================================================
+
+void FilmstripWidget::mousePressEvent(QMouseEvent *event) {
+  if (event->button() != Qt::LeftButton || m_durationMs <= 0) {
+    QWidget::mousePressEvent(event);
+    return;
+  }
+  emit seekRequested(positionAt(event->position().toPoint().x()));
+  event->accept();
+}
+
+void FilmstripWidget::mouseMoveEvent(QMouseEvent *event) {
+  if (!(event->buttons() & Qt::LeftButton) || m_durationMs <= 0) {
+    QWidget::mouseMoveEvent(event);
+    return;
+  }
+  emit seekRequested(positionAt(event->position().toPoint().x()));
+  event->accept();
+}
+
+qint64 FilmstripWidget::positionAt(int x) const {
+  if (width() <= 0)
+    return 0;
+  const qint64 position = static_cast<qint64>(
+      static_cast<double>(x) * m_durationMs / width());
+  return qBound<qint64>(0, position, m_durationMs);
+}
+
+int FilmstripWidget::xAt(qint64 positionMs) const {
+  if (m_durationMs <= 0)
+    return 0;
+  return static_cast<int>(static_cast<double>(positionMs) * width() /
+                          m_durationMs);
+}
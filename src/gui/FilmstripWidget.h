@@ -0,0 +1,59 @@
+/**
+ * @file FilmstripWidget.h
+ * @brief Thumbnail track of the whole video, above the position slider.
+ *
+ * Tiles the video's keyframe thumbnails across its width, with the
+ * playhead on top. Clicking or dragging seeks. Missing thumbnails are
+ * requested from ThumbnailCache, nearest the playhead first, and drawn
+ * as they arrive: painting never waits for a decode.
+ *
+ * @note Part of the GUI layer - pure UI, thumbnails come from ThumbnailCache.
+ */
+
+#ifndef FILMSTRIPWIDGET_H
+#define FILMSTRIPWIDGET_H
+
+#include <QWidget>
+
+class ThumbnailCache;
+
+/**
+ * @class FilmstripWidget
+ * @brief Clickable filmstrip of one video.
+ */
+class FilmstripWidget : public QWidget {
+  Q_OBJECT
+
+public:
+  /** @brief Height of the strip, in pixels. */
+  static constexpr int STRIP_HEIGHT = 48;
+
+  explicit FilmstripWidget(ThumbnailCache *thumbnails,
+                           QWidget *parent = nullptr);
+
+public slots:
+  /** @brief Sets the video length; the strip hides while it is 0. */
+  void setDuration(qint64 durationMs);
+
+  /** @brief Moves the playhead. */
+  void setPosition(qint64 positionMs);
+
+signals:
+  /** @brief The user clicked or dragged to @p positionMs. */
+  void seekRequested(qint64 positionMs);
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void mousePressEvent(QMouseEvent *event) override;
+  void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+  qint64 positionAt(int x) const;
+  int xAt(qint64 positionMs) const;
+
+  ThumbnailCache *m_thumbnails;
+  qint64 m_durationMs;
+  qint64 m_positionMs;
+};
+
+#endif // FILMSTRIPWIDGET_H
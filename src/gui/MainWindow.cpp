@@ -7,13 +7,23 @@
 
 // Core includes
 #include "AudioRecorder.h"
+#include "AutosaveManager.h"
+#include "ExportQueue.h"
 #include "ExportService.h"
+#include "LiveExportEncoder.h"
+#include "MediaRelink.h"
+#include "MediaSource.h"
+#include "PeakPyramid.h"
 #include "PlaybackEngine.h"
 #include "RythmoManager.h"
 #include "SaveManager.h"
+#include "ThumbnailCache.h"
+#include "ToolCapabilities.h"
 
 // GUI includes
 #include "ClickableSlider.h"
+#include "ExportQueueDialog.h"
+#include "FilmstripWidget.h"
 #include "RythmoOverlay.h"
 #include "TrackPanel.h"
 #include "TrackSettingsDialog.h"
@@ -26,18 +36,24 @@
 #include <QEvent>
 #include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QFrame>
 #include <QHBoxLayout>
+#include <QInputDialog>
 #include <QMessageBox>
 #include <QResizeEvent>
 #include <QStandardPaths>
 #include <QStatusBar>
+#include <QTimer>
 #include <QVBoxLayout>
 
 #include <QFutureWatcher>
 #include <QProgressDialog>
 #include <QtConcurrent>
 
+#include <atomic>
+#include <memory>
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
       // Initialize Core services
@@ -47,12 +63,16 @@ MainWindow::MainWindow(QWidget *parent)
       m_audioRecorder1(new AudioRecorder(this)),
       m_audioRecorder2(new AudioRecorder(this)),
       m_exportService(new ExportService(this)),
-      m_saveManager(new SaveManager(this))
+      m_liveEncoder(new LiveExportEncoder(this)),
+      m_exportQueue(new ExportQueue(this)),
+      m_saveManager(new SaveManager(this)),
+      m_autosave(new AutosaveManager(this)),
+      m_thumbnails(new ThumbnailCache(this))
       // Initialize state
       ,
       m_previousVolume(100), m_isRecording(false),
       m_isFullscreenRecording(false), m_lastRecordedDurationMs(0),
-      m_recordingStartTimeMs(0) {
+      m_recordingStartTimeMs(0), m_rehearsalRate(1.0) {
   loadStylesheet();
   setupUi();
   createMenus();
@@ -68,12 +88,41 @@ MainWindow::MainWindow(QWidget *parent)
   m_tempAudioPath1 = tempDir + "/temp_dub.wav";
   m_tempAudioPath2 = tempDir + "/temp_dub_2.wav";
 
+  // Probe FFmpeg and ffprobe off the GUI thread; export answers from the
+  // cached result afterwards
+  auto *toolWatcher = new QFutureWatcher<void>(this);
+  connect(toolWatcher, &QFutureWatcher<void>::finished, this,
+          [this, toolWatcher]() {
+            toolWatcher->deleteLater();
+            if (!ToolCapabilities::ffmpeg().available) {
+              statusBar()->showMessage(
+                  tr("FFmpeg introuvable : l'export est indisponible."));
+            }
+          });
+  toolWatcher->setFuture(ToolCapabilities::probeInBackground());
+
+  // Offer the autosaved session once the window is up, then journal edits
+  m_autosave->setSnapshotProvider([this]() { return currentSaveData(); });
+  QTimer::singleShot(0, this, &MainWindow::restoreAutosave);
+
   // Window configuration
   setWindowTitle("DubInstante - Studio");
   resize(900, 600);
   setMinimumSize(800, 500);
 }
 
+MainWindow::~MainWindow() {
+  // A relink search must not outlive the window
+  cancelRelink();
+
+  // A take still waiting for its live soundtrack is mixed as usual, next
+  // time the queue runs
+  if (!m_pendingLiveJob.isEmpty()) {
+    m_exportQueue->setPaused(true);
+    m_exportQueue->attachEncodedAudio(m_pendingLiveJob, QString());
+  }
+}
+
 // =============================================================================
 // UI Setup
 // =============================================================================
@@ -130,6 +179,9 @@ void MainWindow::setupUi() {
   // Position Slider
   // =========================================================================
 
+  m_filmstrip = new FilmstripWidget(m_thumbnails, this);
+  mainLayout->addWidget(m_filmstrip);
+
   m_positionSlider = new ClickableSlider(Qt::Horizontal, this);
   m_positionSlider->setRange(0, 0);
   mainLayout->addWidget(m_positionSlider);
@@ -157,6 +209,21 @@ void MainWindow::setupUi() {
       "color: #666; font-family: monospace; font-weight: bold;");
   controlsLayout->addWidget(m_timeLabel);
 
+  // Playback rate: slowed down to rehearse difficult lines
+  m_rateCombo = new QComboBox(this);
+  for (qreal rate : {0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0})
+    m_rateCombo->addItem(QString::number(rate) + "×", rate);
+  m_rateCombo->setCurrentIndex(m_rateCombo->findData(1.0));
+  // Before Qt 6.10 QMediaPlayer cannot keep the pitch: say so where the
+  // rate is chosen
+  m_rateCombo->setToolTip(
+      PlaybackEngine::preservesPitch()
+          ? tr("Vitesse de lecture (répétition)")
+          : tr("Vitesse de lecture (répétition)\n"
+               "La hauteur du son suit la vitesse : la correction de "
+               "hauteur nécessite Qt 6.10 ou plus récent."));
+  controlsLayout->addWidget(m_rateCombo);
+
   controlsLayout->addStretch();
 
   // Volume controls
@@ -258,7 +325,7 @@ void MainWindow::createMenus() {
   // === Files Menu ===
   QMenu *filesMenu = menuBar->addMenu(tr("Files"));
 
-  m_actionOpenMp4 = new QAction(tr("Open MP4"), this);
+  m_actionOpenMp4 = new QAction(tr("Open video"), this);
   connect(m_actionOpenMp4, &QAction::triggered, this, &MainWindow::onOpenFile);
   filesMenu->addAction(m_actionOpenMp4);
 
@@ -272,6 +339,60 @@ void MainWindow::createMenus() {
           &MainWindow::onSaveProject);
   filesMenu->addAction(m_actionSaveProject);
 
+  m_actionExportStems =
+      new QAction(tr("Exporter aussi les stems (doublage seul, son original)"), this);
+  m_actionExportStems->setCheckable(true);
+  filesMenu->addAction(m_actionExportStems);
+
+  m_actionExportMultiTrack =
+      new QAction(tr("Export multipiste (une piste audio par langue)"), this);
+  m_actionExportMultiTrack->setCheckable(true);
+  filesMenu->addAction(m_actionExportMultiTrack);
+
+  m_actionLiveEncode =
+      new QAction(tr("Encoder l'audio pendant l'enregistrement"), this);
+  m_actionLiveEncode->setCheckable(true);
+  m_actionLiveEncode->setChecked(true);
+  filesMenu->addAction(m_actionLiveEncode);
+
+  // Exports queue up and run in the background, even while recording
+  QMenu *queueMenu = filesMenu->addMenu(tr("File d'export"));
+
+  m_actionShowQueue = new QAction(tr("Afficher la file..."), this);
+  connect(m_actionShowQueue, &QAction::triggered, this, [this]() {
+    ExportQueueDialog *dialog = new ExportQueueDialog(m_exportQueue, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+  });
+  queueMenu->addAction(m_actionShowQueue);
+  queueMenu->addSeparator();
+
+  m_actionExportPriority = new QAction(tr("Exporter en priorité"), this);
+  m_actionExportPriority->setCheckable(true);
+  queueMenu->addAction(m_actionExportPriority);
+
+  m_actionPauseQueue = new QAction(tr("Mettre la file en pause"), this);
+  m_actionPauseQueue->setCheckable(true);
+  connect(m_actionPauseQueue, &QAction::toggled, m_exportQueue,
+          &ExportQueue::setPaused);
+  queueMenu->addAction(m_actionPauseQueue);
+
+  m_actionQueueJobs = new QAction(tr("Exports simultanés..."), this);
+  connect(m_actionQueueJobs, &QAction::triggered, this, [this]() {
+    bool ok = false;
+    int count = QInputDialog::getInt(
+        this, tr("File d'export"), tr("Nombre d'exports simultanés :"),
+        m_exportQueue->maxConcurrentJobs(), 1, 16, 1, &ok);
+    if (ok)
+      m_exportQueue->setMaxConcurrentJobs(count);
+  });
+  queueMenu->addAction(m_actionQueueJobs);
+
+  m_actionClearQueue = new QAction(tr("Retirer les exports terminés"), this);
+  connect(m_actionClearQueue, &QAction::triggered, m_exportQueue,
+          &ExportQueue::clearFinished);
+  queueMenu->addAction(m_actionClearQueue);
+
   // === Application Menu ===
   QMenu *appMenu = menuBar->addMenu(tr("Application"));
 
@@ -308,6 +429,12 @@ void MainWindow::createMenus() {
   m_actionExportRythmo->setCheckable(true);
   rythmoMenu->addAction(m_actionExportRythmo);
 
+  m_actionExportRythmoOnly =
+      new QAction(tr("Exporter la bande seule (transparente)..."), this);
+  connect(m_actionExportRythmoOnly, &QAction::triggered, this,
+          &MainWindow::onExportRythmoOnly);
+  rythmoMenu->addAction(m_actionExportRythmoOnly);
+
   // === Account Menu (Right aligned) ===
   QMenuBar *rightMenuBar = new QMenuBar(menuBar);
   rightMenuBar->setObjectName("rightMenuBar");
@@ -368,6 +495,26 @@ void MainWindow::setupConnections() {
           &MainWindow::onPlaybackStateChanged);
   connect(m_playbackEngine, &PlaybackEngine::errorOccurred, this,
           &MainWindow::onError);
+  connect(m_playbackEngine, &PlaybackEngine::cachedFrameReady, m_videoWidget,
+          &VideoWidget::showImage);
+
+  // Edit proxy of heavy videos
+  connect(m_playbackEngine, &PlaybackEngine::proxyProgressChanged, this,
+          [this](int percentage) {
+            statusBar()->showMessage(
+                tr("Génération du proxy d'édition : %1 %").arg(percentage));
+          });
+  connect(m_playbackEngine, &PlaybackEngine::proxyChanged, this,
+          [this](bool active) {
+            if (active)
+              statusBar()->showMessage(tr("Lecture sur le proxy d'édition "
+                                          "(l'export utilise l'original)"),
+                                       5000);
+          });
+  connect(m_playbackEngine, &PlaybackEngine::proxyFailed, this,
+          [this](const QString &message) {
+            statusBar()->showMessage(message, 10000);
+          });
 
   // PlaybackEngine -> RythmoManager -> RythmoOverlay
   connect(m_playbackEngine, &PlaybackEngine::positionChanged, m_rythmoManager,
@@ -378,6 +525,20 @@ void MainWindow::setupConnections() {
           [this](QMediaPlayer::PlaybackState state) {
             m_rythmoOverlay->setPlaying(state == QMediaPlayer::PlayingState);
           });
+  // The band extrapolates between position updates at the playback rate
+  connect(m_playbackEngine, &PlaybackEngine::playbackRateChanged,
+          m_rythmoOverlay, &RythmoOverlay::setPlaybackRate);
+  connect(m_rateCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+          this, [this](int index) {
+            const qreal rate = m_rateCombo->itemData(index).toReal();
+            m_playbackEngine->setPlaybackRate(rate);
+            if (rate != 1.0 && !PlaybackEngine::preservesPitch())
+              statusBar()->showMessage(
+                  tr("Vitesse %1× : la hauteur du son est modifiée "
+                     "(correction de hauteur avec Qt 6.10+ uniquement).")
+                      .arg(rate),
+                  5000);
+          });
 
   // =========================================================================
   // RythmoOverlay Interactions -> PlaybackEngine
@@ -427,17 +588,13 @@ void MainWindow::setupConnections() {
           });
 
   // Navigation (frame stepping via RythmoWidget arrow keys)
-  qreal fps = m_playbackEngine->videoFrameRate();
-  int frameStep = (fps > 0) ? static_cast<int>(1000.0 / fps) : 40;
   connect(m_rythmoOverlay->track1(), &RythmoWidget::navigationRequested, this,
-          [this, frameStep](bool forward) {
-            qint64 delta = forward ? frameStep : -frameStep;
-            m_playbackEngine->seek(m_playbackEngine->position() + delta);
+          [this](bool forward) {
+            m_playbackEngine->stepFrames(forward ? 1 : -1);
           });
   connect(m_rythmoOverlay->track2(), &RythmoWidget::navigationRequested, this,
-          [this, frameStep](bool forward) {
-            qint64 delta = forward ? frameStep : -frameStep;
-            m_playbackEngine->seek(m_playbackEngine->position() + delta);
+          [this](bool forward) {
+            m_playbackEngine->stepFrames(forward ? 1 : -1);
           });
 
   // =========================================================================
@@ -445,7 +602,9 @@ void MainWindow::setupConnections() {
   // =========================================================================
 
   connect(m_positionSlider, &QSlider::sliderMoved, m_playbackEngine,
-          &PlaybackEngine::seek);
+          &PlaybackEngine::scrub);
+  connect(m_filmstrip, &FilmstripWidget::seekRequested, m_playbackEngine,
+          &PlaybackEngine::scrub);
 
   // Frame stepping configuration
   connect(m_playbackEngine, &PlaybackEngine::metaDataChanged, this, [this]() {
@@ -553,6 +712,35 @@ void MainWindow::setupConnections() {
               m_rythmoOverlay->track2()->setTrackStyle(style);
           });
 
+  // =========================================================================
+  // Autosave
+  // =========================================================================
+
+  // Every edit is journaled; the writing happens on the autosave thread
+  connect(m_rythmoManager, &RythmoManager::textChanged, m_autosave,
+          &AutosaveManager::recordText);
+  connect(m_rythmoManager, &RythmoManager::trackStyleChanged, m_autosave,
+          &AutosaveManager::recordTrackStyle);
+  connect(m_speedSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+          m_autosave,
+          [this](int value) { m_autosave->recordSetting("scroll_speed", value); });
+  connect(m_textColorCheck, &QCheckBox::toggled, m_autosave,
+          [this](bool checked) {
+            m_autosave->recordSetting("is_text_white", checked);
+          });
+  connect(m_actionEnableTrack2, &QAction::toggled, m_autosave,
+          [this](bool checked) {
+            m_autosave->recordSetting("enable_track_2", checked);
+          });
+  connect(m_playbackEngine, &PlaybackEngine::volumeChanged, m_autosave,
+          [this](float volume) {
+            m_autosave->recordSetting("video_volume", volume);
+          });
+  connect(m_track1Panel, &TrackPanel::volumeChanged, m_autosave,
+          [this](float gain) { m_autosave->recordSetting("audio_gain_1", gain); });
+  connect(m_track2Panel, &TrackPanel::volumeChanged, m_autosave,
+          [this](float gain) { m_autosave->recordSetting("audio_gain_2", gain); });
+
   // Recording
   connect(m_recordButton, &QPushButton::clicked, this,
           &MainWindow::toggleRecording);
@@ -561,6 +749,18 @@ void MainWindow::setupConnections() {
   connect(m_audioRecorder2, &AudioRecorder::errorOccurred, this,
           &MainWindow::onError);
 
+  // Takes are drawn on their band once the recorder has closed the file
+  connect(m_audioRecorder1, &AudioRecorder::recorderStateChanged, this,
+          [this](QMediaRecorder::RecorderState state) {
+            if (state == QMediaRecorder::StoppedState)
+              loadTakeWaveform(0);
+          });
+  connect(m_audioRecorder2, &AudioRecorder::recorderStateChanged, this,
+          [this](QMediaRecorder::RecorderState state) {
+            if (state == QMediaRecorder::StoppedState)
+              loadTakeWaveform(1);
+          });
+
   // =========================================================================
   // Export
   // =========================================================================
@@ -569,6 +769,20 @@ void MainWindow::setupConnections() {
           &MainWindow::onExportProgress);
   connect(m_exportService, &ExportService::exportFinished, this,
           &MainWindow::onExportFinished);
+  connect(m_exportQueue, &ExportQueue::overallProgressChanged, this,
+          &MainWindow::onExportProgress);
+  connect(m_exportQueue, &ExportQueue::jobFinished, this,
+          &MainWindow::onQueueJobFinished);
+
+  // The live soundtrack of the last take goes to the export waiting for it
+  connect(m_liveEncoder, &LiveExportEncoder::finished, this, [this]() {
+    if (m_pendingLiveJob.isEmpty())
+      return;
+    m_exportQueue->attachEncodedAudio(m_pendingLiveJob,
+                                      m_liveEncoder->encodedAudio());
+    m_pendingLiveJob.clear();
+    m_liveEncoder->cancel(); // Moved to the job, or of no use
+  });
 }
 
 // =============================================================================
@@ -576,12 +790,19 @@ void MainWindow::setupConnections() {
 // =============================================================================
 
 void MainWindow::onOpenFile() {
-  QString fileName = QFileDialog::getOpenFileName(this, tr("Ouvrir"), "",
-                                                  tr("Vidéos MP4 (*.mp4)"));
+  // Heavy formats play from an edit proxy (see PlaybackEngine)
+  QString fileName = QFileDialog::getOpenFileName(
+      this, tr("Ouvrir"), "",
+      tr("Vidéos (*.mp4 *.m4v *.mov *.mkv *.mxf *.avi *.webm);;"
+         "Tous les fichiers (*)"));
 
   if (!fileName.isEmpty()) {
+    cancelRelink(); // Located by hand
     m_playbackEngine->openFile(QUrl::fromLocalFile(fileName));
     setProperty("currentVideoPath", fileName);
+    m_autosave->recordSetting("video_url", fileName);
+    m_thumbnails->setSource(fileName);
+    loadVideoWaveform(fileName);
   }
 }
 
@@ -611,97 +832,124 @@ void MainWindow::onSaveProject() {
     fileName += suffix;
   }
 
-  SaveData data;
-  data.videoUrl = property("currentVideoPath").toString();
-  data.videoVolume = m_playbackEngine->volume();
-  data.audioInput1 = m_track1Panel->selectedDevice().description();
-  data.audioGain1 = m_track1Panel->gain();
-  data.audioInput2 = m_track2Panel->selectedDevice().description();
-  data.audioGain2 = m_track2Panel->gain();
-  data.scrollSpeed = m_speedSpinBox->value();
-  data.isTextWhite = m_textColorCheck->isChecked();
-  data.enableTrack2 = m_actionEnableTrack2->isChecked();
-
-  TrackSaveData track1Data;
-  track1Data.text = m_rythmoManager->text(0);
-  track1Data.style = m_rythmoManager->trackStyle(0);
-
-  TrackSaveData track2Data;
-  track2Data.text = m_rythmoManager->text(1);
-  track2Data.style = m_rythmoManager->trackStyle(1);
-
-  data.tracks << track1Data << track2Data;
+  SaveData data = currentSaveData();
+  const qint64 savedAt = m_autosave->sequence();
 
   if (saveWithVideo) {
-    // Check zip availability BEFORE launching thread (for specific error
-    // messages)
-    QString zipError;
-    if (!SaveManager::isZipAvailable(&zipError)) {
-      QMessageBox::critical(this, tr("Erreur de sauvegarde"), zipError);
-      return;
-    }
-
     // Show progress dialog
     QProgressDialog *progressDialog = new QProgressDialog(this);
-    progressDialog->setLabelText(
-        tr("Création de l'archive ZIP en cours...\nCela peut prendre quelques "
-           "minutes selon la taille de la vidéo."));
-    progressDialog->setRange(0, 0); // Indeterminate
-    progressDialog->setCancelButton(
-        nullptr); // Disable cancel for safety during zip
+    progressDialog->setLabelText(tr("Création de l'archive ZIP en cours..."));
+    progressDialog->setRange(0, 1000);
     progressDialog->setWindowModality(Qt::WindowModal);
     progressDialog->show();
 
+    // The archive is only written in place once complete: cancelling
+    // leaves the previous file untouched
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    connect(progressDialog, &QProgressDialog::canceled, this,
+            [cancelled]() { *cancelled = true; });
+
     // Run in background thread
+    auto error = std::make_shared<QString>();
     QFutureWatcher<bool> *watcher = new QFutureWatcher<bool>(this);
     connect(watcher, &QFutureWatcher<bool>::finished, this,
-            [this, watcher, progressDialog, fileName]() {
+            [this, watcher, progressDialog, cancelled, error, savedAt]() {
               bool result = watcher->result();
               progressDialog->close();
               progressDialog->deleteLater();
               watcher->deleteLater();
 
               if (result) {
+                m_autosave->markClean(savedAt);
                 statusBar()->showMessage(tr("Projet sauvegardé"), 3000);
+              } else if (*cancelled) {
+                statusBar()->showMessage(tr("Sauvegarde annulée"), 3000);
               } else {
                 QMessageBox::critical(
                     this, tr("Erreur"),
-                    tr("Impossible de créer l'archive ZIP.\nVérifiez l'espace "
-                       "disque ou les permissions."));
+                    tr("Impossible de créer l'archive ZIP.\n%1").arg(*error));
               }
             });
 
-    QFuture<bool> future = QtConcurrent::run([this, fileName, data]() {
-      return m_saveManager->saveWithMedia(fileName, data);
-    });
+    QFuture<bool> future =
+        QtConcurrent::run([this, fileName, data, progressDialog, cancelled,
+                           error]() {
+          int lastPermille = -1;
+          auto progress = [progressDialog, cancelled,
+                           &lastPermille](qint64 written, qint64 total) {
+            int permille =
+                total > 0 ? static_cast<int>(written * 1000 / total) : 0;
+            if (permille != lastPermille) {
+              lastPermille = permille;
+              // Dropped if the dialog is already gone
+              QMetaObject::invokeMethod(
+                  progressDialog,
+                  [progressDialog, permille]() {
+                    progressDialog->setValue(permille);
+                  },
+                  Qt::QueuedConnection);
+            }
+            return !*cancelled;
+          };
+          return m_saveManager->saveWithMedia(fileName, data, error.get(),
+                                              progress);
+        });
     watcher->setFuture(future);
 
   } else {
-    if (m_saveManager->save(fileName, data)) {
-      statusBar()->showMessage(tr("Projet sauvegardé"), 3000);
-    } else {
-      QMessageBox::critical(this, tr("Erreur"),
-                            tr("Impossible de sauvegarder le projet."));
-    }
+    // Encoded and written off the GUI thread: saving never stalls typing
+    // or playback
+    QFutureWatcher<bool> *watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this,
+            [this, watcher, savedAt]() {
+              watcher->deleteLater();
+              if (watcher->result()) {
+                m_autosave->markClean(savedAt);
+                statusBar()->showMessage(tr("Projet sauvegardé"), 3000);
+              } else {
+                QMessageBox::critical(
+                    this, tr("Erreur"),
+                    tr("Impossible de sauvegarder le projet."));
+              }
+            });
+    watcher->setFuture(QtConcurrent::run([this, fileName, data]() {
+      return m_saveManager->save(fileName, data);
+    }));
   }
 }
 
 void MainWindow::onLoadProject() {
   QString fileName = QFileDialog::getOpenFileName(
-      this, tr("Charger un projet"), "", tr("DubInstante Project (*.dbi)"));
+      this, tr("Charger un projet"), "",
+      tr("DubInstante Project (*.dbi *.zip)"));
 
   if (fileName.isEmpty())
     return;
 
+  // Archives are opened in place: the video is played from inside them
   SaveData data;
-  if (!m_saveManager->load(fileName, data)) {
+  QString errorMessage;
+  bool loaded = fileName.endsWith(".zip", Qt::CaseInsensitive)
+                    ? m_saveManager->loadArchive(fileName, data, &errorMessage)
+                    : m_saveManager->load(fileName, data);
+  if (!loaded) {
     QMessageBox::critical(
         this, tr("Erreur"),
-        tr("Le fichier est corrompu ou d'une version incompatible."));
+        errorMessage.isEmpty()
+            ? tr("Le fichier est corrompu ou d'une version incompatible.")
+            : errorMessage);
     return;
   }
 
-  // Apply loaded data
+  statusBar()->showMessage(tr("Projet chargé"), 3000);
+  applySaveData(data, fileName);
+  m_autosave->markClean(m_autosave->sequence());
+}
+
+void MainWindow::applySaveData(const SaveData &data,
+                               const QString &projectPath) {
+  cancelRelink(); // Was looking for the previous project's video
+
   m_speedSpinBox->setValue(data.scrollSpeed);
   m_textColorCheck->setChecked(data.isTextWhite);
   m_actionEnableTrack2->setChecked(data.enableTrack2);
@@ -725,14 +973,15 @@ void MainWindow::onLoadProject() {
       localPath = QUrl(localPath).toLocalFile();
     }
 
-    if (!QFile::exists(localPath)) {
-      QMessageBox::warning(
-          this, tr("Relink"),
-          tr("La vidéo est introuvable. Veuillez la localiser."));
-      onOpenFile(); // Simple relink via open file dialog
+    if (!MediaSource::exists(localPath)) {
+      relinkVideo(data, localPath, projectPath);
+    } else if (!m_playbackEngine->openSource(localPath)) {
+      promptRelink();
     } else {
-      m_playbackEngine->openFile(QUrl::fromLocalFile(localPath));
       setProperty("currentVideoPath", localPath);
+      m_autosave->recordSetting("video_url", localPath);
+      m_thumbnails->setSource(localPath);
+      loadVideoWaveform(localPath);
     }
   }
 
@@ -755,8 +1004,150 @@ void MainWindow::onLoadProject() {
     }
   }
   m_track2Panel->setVolume(data.audioGain2);
+}
 
-  statusBar()->showMessage(tr("Projet chargé"), 3000);
+void MainWindow::relinkVideo(const SaveData &data, const QString &missingPath,
+                             const QString &projectPath) {
+  MediaRelink::Identity identity;
+  identity.size = data.videoSize;
+  identity.fingerprint = data.videoFingerprint;
+  if (!identity.isValid()) {
+    promptRelink(); // Saved before fingerprints were recorded
+    return;
+  }
+
+  // Searched off the GUI thread; the dialog only if nothing matches
+  auto cancel = std::make_shared<std::atomic<bool>>(false);
+  m_relinkCancel = cancel;
+  statusBar()->showMessage(tr("Recherche de la vidéo déplacée..."));
+
+  const QString fileName = QFileInfo(missingPath).fileName();
+  const QStringList roots = MediaRelink::searchRoots(projectPath, missingPath);
+  auto *watcher = new QFutureWatcher<QString>(this);
+  connect(watcher, &QFutureWatcher<QString>::finished, this,
+          [this, watcher, cancel]() {
+            watcher->deleteLater();
+            if (*cancel)
+              return; // Another project or video since
+            m_relinkCancel.reset();
+
+            const QString found = watcher->result();
+            if (found.isEmpty() || !m_playbackEngine->openSource(found)) {
+              statusBar()->clearMessage();
+              promptRelink();
+              return;
+            }
+            setProperty("currentVideoPath", found);
+            m_autosave->recordSetting("video_url", found);
+            m_thumbnails->setSource(found);
+            loadVideoWaveform(found);
+            statusBar()->showMessage(tr("Vidéo retrouvée : %1").arg(found),
+                                     5000);
+          });
+  watcher->setFuture(
+      QtConcurrent::run([identity, fileName, roots, cancel]() {
+        return MediaRelink::find(identity, fileName, roots, cancel.get());
+      }));
+}
+
+void MainWindow::loadVideoWaveform(const QString &source) {
+  m_positionSlider->setWaveform(nullptr);
+  m_rythmoOverlay->track1()->setWaveform(nullptr);
+  m_rythmoOverlay->track2()->setWaveform(nullptr);
+
+  // Decoded once in the background, then reopened from the cache
+  using Peaks = std::shared_ptr<const PeakPyramid>;
+  auto *watcher = new QFutureWatcher<Peaks>(this);
+  connect(watcher, &QFutureWatcher<Peaks>::finished, this,
+          [this, watcher, source]() {
+            watcher->deleteLater();
+            if (property("currentVideoPath").toString() != source)
+              return; // Another video since
+            const Peaks peaks = watcher->result();
+            m_positionSlider->setWaveform(peaks);
+            m_rythmoOverlay->track1()->setWaveform(peaks);
+            m_rythmoOverlay->track2()->setWaveform(peaks);
+          });
+  watcher->setFuture(
+      QtConcurrent::run([source]() { return PeakPyramid::load(source); }));
+}
+
+void MainWindow::loadTakeWaveform(int track) {
+  const QString path = track == 0 ? m_tempAudioPath1 : m_tempAudioPath2;
+  if (m_isRecording || !QFile::exists(path))
+    return;
+
+  using Peaks = std::shared_ptr<const PeakPyramid>;
+  const qint64 startMs = m_recordingStartTimeMs;
+  auto *watcher = new QFutureWatcher<Peaks>(this);
+  connect(watcher, &QFutureWatcher<Peaks>::finished, this,
+          [this, watcher, track, startMs]() {
+            watcher->deleteLater();
+            if (m_isRecording)
+              return; // A new take replaces this one
+            RythmoWidget *band = track == 0 ? m_rythmoOverlay->track1()
+                                            : m_rythmoOverlay->track2();
+            band->setTakeWaveform(watcher->result(), startMs);
+          });
+  watcher->setFuture(
+      QtConcurrent::run([path]() { return PeakPyramid::load(path); }));
+}
+
+void MainWindow::cancelRelink() {
+  if (m_relinkCancel) {
+    *m_relinkCancel = true;
+    m_relinkCancel.reset();
+  }
+}
+
+void MainWindow::promptRelink() {
+  QMessageBox::warning(this, tr("Relink"),
+                       tr("La vidéo est introuvable. Veuillez la localiser."));
+  onOpenFile(); // Simple relink via open file dialog
+}
+
+SaveData MainWindow::currentSaveData() const {
+  SaveData data;
+  data.videoUrl = property("currentVideoPath").toString();
+  data.videoVolume = m_playbackEngine->volume();
+  data.audioInput1 = m_track1Panel->selectedDevice().description();
+  data.audioGain1 = m_track1Panel->gain();
+  data.audioInput2 = m_track2Panel->selectedDevice().description();
+  data.audioGain2 = m_track2Panel->gain();
+  data.scrollSpeed = m_speedSpinBox->value();
+  data.isTextWhite = m_textColorCheck->isChecked();
+  data.enableTrack2 = m_actionEnableTrack2->isChecked();
+
+  TrackSaveData track1Data;
+  track1Data.text = m_rythmoManager->text(0);
+  track1Data.style = m_rythmoManager->trackStyle(0);
+
+  TrackSaveData track2Data;
+  track2Data.text = m_rythmoManager->text(1);
+  track2Data.style = m_rythmoManager->trackStyle(1);
+
+  data.tracks << track1Data << track2Data;
+  return data;
+}
+
+void MainWindow::restoreAutosave() {
+  SaveData recovered;
+  bool restore = false;
+  if (m_autosave->recover(recovered)) {
+    restore = QMessageBox::question(
+                  this, tr("Récupération"),
+                  tr("Des modifications non sauvegardées de la dernière "
+                     "session ont été retrouvées.\nVoulez-vous les "
+                     "restaurer ?"),
+                  QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
+  }
+  if (restore) {
+    applySaveData(recovered);
+    statusBar()->showMessage(tr("Session restaurée"), 3000);
+  }
+
+  // A restored session is still unsaved: it stays recoverable
+  m_autosave->start(!restore);
 }
 
 // =============================================================================
@@ -767,6 +1158,7 @@ void MainWindow::onPositionChanged(qint64 position) {
   if (!m_positionSlider->isSliderDown()) {
     m_positionSlider->setValue(static_cast<int>(position));
   }
+  m_filmstrip->setPosition(position);
 
   m_timeLabel->setText(TimeFormatter::format(position) + " / " +
                        TimeFormatter::format(m_playbackEngine->duration()));
@@ -774,6 +1166,7 @@ void MainWindow::onPositionChanged(qint64 position) {
 
 void MainWindow::onDurationChanged(qint64 duration) {
   m_positionSlider->setRange(0, static_cast<int>(duration));
+  m_filmstrip->setDuration(duration);
 }
 
 void MainWindow::onPlaybackStateChanged(QMediaPlayer::PlaybackState state) {
@@ -798,15 +1191,51 @@ void MainWindow::toggleRecording() {
       return;
     }
 
+    // Takes are recorded in real time: a take recorded at a rehearsal rate
+    // would drift against the picture at export (duration and start offset
+    // are wall-clock). Back to the rehearsal rate at STOP
+    m_rehearsalRate = m_playbackEngine->playbackRate();
+    m_playbackEngine->setPlaybackRate(1.0);
+    m_rateCombo->setEnabled(false);
+
     m_playbackEngine->seek(0);
     m_recordingStartTimeMs = m_playbackEngine->position();
 
+    // The previous export already holds its takes; if it still waits for
+    // the live soundtrack, it mixes as usual instead: the encoder is needed
+    // for this take
+    if (!m_pendingLiveJob.isEmpty()) {
+      m_exportQueue->attachEncodedAudio(m_pendingLiveJob, QString());
+      m_pendingLiveJob.clear();
+    }
+    m_liveEncoder->cancel();
+
+    // The previous takes must not be mistaken for the new ones while the
+    // recorders create their files
+    QFile::remove(m_tempAudioPath1);
+    QFile::remove(m_tempAudioPath2);
+    m_rythmoOverlay->track1()->setTakeWaveform(nullptr, 0);
+    m_rythmoOverlay->track2()->setTakeWaveform(nullptr, 0);
+
     m_track1Panel->startRecording(QUrl::fromLocalFile(m_tempAudioPath1));
 
     if (m_actionEnableTrack2->isChecked()) {
       m_track2Panel->startRecording(QUrl::fromLocalFile(m_tempAudioPath2));
     }
 
+    if (m_actionLiveEncode->isChecked()) {
+      // Mix and encode the soundtrack as the takes come in: ready at STOP
+      ExportConfig live;
+      live.videoPath = currentVideo;
+      live.audioPath = m_tempAudioPath1;
+      if (m_actionEnableTrack2->isChecked()) {
+        live.secondAudioPath = m_tempAudioPath2;
+      }
+      live.startTimeMs = m_recordingStartTimeMs;
+      live.originalVolume = m_playbackEngine->volume();
+      m_liveEncoder->start(live);
+    }
+
     // Enter fullscreen if action is checked
     if (m_actionFullscreen->isChecked()) {
       enterFullscreenRecording();
@@ -841,6 +1270,10 @@ void MainWindow::toggleRecording() {
     m_rythmoOverlay->setEditable(true);
 
     m_lastRecordedDurationMs = m_recordingTimer.elapsed();
+    m_liveEncoder->finish(m_lastRecordedDurationMs);
+
+    m_playbackEngine->setPlaybackRate(m_rehearsalRate);
+    m_rateCombo->setEnabled(true);
 
     m_isRecording = false;
     m_recordButton->setChecked(false);
@@ -866,11 +1299,114 @@ void MainWindow::toggleRecording() {
       config.startTimeMs = m_recordingStartTimeMs;
       config.originalVolume = m_playbackEngine->volume();
 
+      // Take gains stay at unity: TrackPanel already applies its gain to the
+      // microphone while recording
+      config.audioGain = 1.0f;
+      config.secondAudioGain = 1.0f;
+
+      // Nothing is burned into the picture: copy the video stream
+      config.videoMode = ExportConfig::SmartRender;
+
       if (m_actionEnableTrack2->isChecked()) {
         config.secondAudioPath = m_tempAudioPath2;
       }
 
-      m_exportService->startExport(config);
+      if (m_actionExportMultiTrack->isChecked()) {
+        // One MP4: original version plus one tagged stream per take
+        ExportAudioTrack original;
+        original.audioPath = currentVideo;
+        original.startMs = m_recordingStartTimeMs;
+        original.gain = 1.0f;
+        original.language = "und";
+        original.title = tr("Version originale");
+        config.audioTracks.append(original);
+
+        int takeCount = m_actionEnableTrack2->isChecked() ? 2 : 1;
+        for (int i = 0; i < takeCount; ++i) {
+          ExportAudioTrack take;
+          take.audioPath = (i == 0) ? m_tempAudioPath1 : m_tempAudioPath2;
+          take.title = tr("Piste %1").arg(i + 1);
+
+          // Asked again until valid; cancelling abandons the export
+          QString language = "fra";
+          for (;;) {
+            bool ok = false;
+            language = QInputDialog::getText(
+                           this, tr("Export multipiste"),
+                           tr("Code langue ISO 639-2 de la piste %1 :")
+                               .arg(i + 1),
+                           QLineEdit::Normal, language, &ok)
+                           .trimmed()
+                           .toLower();
+            if (!ok) {
+              m_exportProgressBar->setVisible(m_exportQueue->isBusy());
+              statusBar()->showMessage(tr("Export multipiste annulé."), 5000);
+              m_liveEncoder->cancel();
+              return;
+            }
+            if (ExportService::isLanguageCode(language))
+              break;
+            QMessageBox::warning(
+                this, tr("Export multipiste"),
+                tr("\"%1\" n'est pas un code ISO 639-2 : trois lettres, par "
+                   "exemple fra, eng, deu, spa.")
+                    .arg(language));
+          }
+          take.language = language;
+          config.audioTracks.append(take);
+        }
+      } else if (m_actionExportStems->isChecked()) {
+        // Same pass: the dubbed takes alone and the original audio alone
+        // next to the full mix. The original audio still holds the original
+        // dialogue: with no separated stems it is no M&E
+        QFileInfo outputInfo(outputFile);
+        QString base = outputInfo.absoluteDir().filePath(
+            outputInfo.completeBaseName());
+
+        ExportOutput dialogue;
+        dialogue.outputPath = base + "_dialogue.mp4";
+        dialogue.originalVolume = 0.0f;
+        config.additionalOutputs.append(dialogue);
+
+        ExportOutput originalAudio;
+        originalAudio.outputPath = base + "_original.mp4";
+        originalAudio.originalVolume = config.originalVolume;
+        originalAudio.audioGain = 0.0f;
+        originalAudio.secondAudioGain = 0.0f;
+        config.additionalOutputs.append(originalAudio);
+      }
+
+      if (m_actionExportRythmo->isChecked()) {
+        // Burned-in bands change every frame: encode segments in parallel
+        config.videoMode = ExportConfig::ParallelReEncode;
+        config.rythmoSpeed = m_rythmoManager->speed();
+        int trackCount = m_actionEnableTrack2->isChecked() ? 2 : 1;
+        for (int i = 0; i < trackCount; ++i) {
+          config.burnInTracks.append(RythmoBandTrack{
+              m_rythmoManager->text(i), m_rythmoManager->trackStyle(i)});
+        }
+      }
+
+      // Only a single mix can use the live soundtrack
+      bool singleMix =
+          config.additionalOutputs.isEmpty() && config.audioTracks.isEmpty();
+      if (singleMix && m_liveEncoder->isRunning() &&
+          m_liveEncoder->matches(config)) {
+        // The live soundtrack is encoding its last seconds. Queued now so
+        // the takes are stored before another REC, on hold until the
+        // soundtrack is attached (see setupConnections)
+        m_pendingLiveJob = enqueueExport(config, true);
+        if (m_pendingLiveJob.isEmpty())
+          m_liveEncoder->cancel();
+      } else {
+        // Empty unless the live soundtrack matches: then the export mixes
+        if (singleMix)
+          config.encodedAudioPath = m_liveEncoder->encodedAudioFor(config);
+        enqueueExport(config);
+        m_liveEncoder->cancel(); // Moved to the job, or of no use
+      }
+    } else {
+      m_liveEncoder->cancel();
     }
   }
 }
@@ -977,6 +1513,104 @@ void MainWindow::onExportFinished(bool success, const QString &message) {
   }
 }
 
+void MainWindow::onQueueJobFinished(const QString &id, bool success,
+                                    const QString &message) {
+  if (!m_exportQueue->isBusy())
+    m_exportProgressBar->setVisible(false);
+
+  // Never interrupt a take with a dialog: the next loop may be recording.
+  // A job cancelled by the user is no error either
+  const bool cancelled =
+      m_exportQueue->job(id).state == ExportJob::Cancelled;
+  if (success || cancelled || m_isRecording) {
+    statusBar()->showMessage(message, 10000);
+  } else {
+    QMessageBox::critical(this, tr("Export"), message);
+  }
+}
+
+QString MainWindow::enqueueExport(const ExportConfig &config, bool held) {
+  int priority = m_actionExportPriority->isChecked() ? 1 : 0;
+  const QString id = m_exportQueue->enqueue(config, priority, held);
+  if (id.isEmpty()) {
+    m_exportProgressBar->setVisible(m_exportQueue->isBusy());
+    QMessageBox::critical(
+        this, tr("Export"),
+        tr("Impossible d'ajouter l'export à la file : les prises n'ont pas "
+           "pu être conservées."));
+    return id;
+  }
+  statusBar()->showMessage(tr("Export ajouté à la file : %1")
+                               .arg(QFileInfo(config.outputPath).fileName()),
+                           5000);
+  return id;
+}
+
+void MainWindow::onExportRythmoOnly() {
+  QString currentVideo = property("currentVideoPath").toString();
+  if (currentVideo.isEmpty()) {
+    QMessageBox::warning(this, tr("Export"),
+                         tr("Ouvrez d'abord une vidéo : la bande est rendue à "
+                            "sa cadence et à sa résolution."));
+    return;
+  }
+
+  const QString proResFilter = tr("ProRes 4444 (*.mov)");
+  const QString vp9Filter = tr("WebM VP9 alpha (*.webm)");
+  const QString pngFilter = tr("Séquence PNG (*.png)");
+
+  // Only offer what this FFmpeg build can encode
+  QStringList filters;
+  if (ToolCapabilities::hasEncoder("prores_ks"))
+    filters << proResFilter;
+  if (ToolCapabilities::hasEncoder("libvpx-vp9"))
+    filters << vp9Filter;
+  if (ToolCapabilities::hasEncoder("png"))
+    filters << pngFilter;
+  if (filters.isEmpty()) {
+    QMessageBox::warning(this, tr("Export"),
+                         tr("Cette version de FFmpeg n'a aucun encodeur "
+                            "avec transparence (ProRes, VP9, PNG)."));
+    return;
+  }
+
+  QString selectedFilter = filters.first();
+  QString outputFile = QFileDialog::getSaveFileName(
+      this, tr("Exporter la bande rythmo"), QDir::homePath() + "/rythmo",
+      filters.join(";;"), &selectedFilter);
+  if (outputFile.isEmpty())
+    return;
+
+  RythmoExportConfig config;
+  config.videoPath = currentVideo;
+  config.speed = m_rythmoManager->speed();
+  int trackCount = m_actionEnableTrack2->isChecked() ? 2 : 1;
+  for (int i = 0; i < trackCount; ++i) {
+    config.tracks.append(RythmoBandTrack{m_rythmoManager->text(i),
+                                         m_rythmoManager->trackStyle(i)});
+  }
+
+  QFileInfo outputInfo(outputFile);
+  if (selectedFilter == pngFilter) {
+    // One numbered file per frame next to the chosen name
+    config.format = RythmoExportConfig::PngSequence;
+    config.outputPath = outputInfo.absoluteDir().filePath(
+        outputInfo.completeBaseName() + "_%06d.png");
+  } else if (selectedFilter == vp9Filter) {
+    config.format = RythmoExportConfig::VP9Alpha;
+    config.outputPath = outputInfo.suffix().isEmpty() ? outputFile + ".webm"
+                                                      : outputFile;
+  } else {
+    config.format = RythmoExportConfig::ProRes4444;
+    config.outputPath = outputInfo.suffix().isEmpty() ? outputFile + ".mov"
+                                                      : outputFile;
+  }
+
+  m_exportProgressBar->setVisible(true);
+  m_exportProgressBar->setValue(0);
+  m_exportService->startRythmoExport(config);
+}
+
 // =============================================================================
 // Slots - Error Handling
 // =============================================================================
@@ -1046,20 +1680,17 @@ void MainWindow::keyPressEvent(QKeyEvent *event) {
   }
 
   // Frame-by-frame navigation
-  qreal fps = m_playbackEngine->videoFrameRate();
-  int frameStep = (fps > 0) ? static_cast<int>(1000.0 / fps) : 40;
-
   if (event->key() == Qt::Key_Left) {
     // Only intercept if we are not in an input widget
     if (!focusWidget() || !focusWidget()->inherits("QAbstractSpinBox")) {
-      m_playbackEngine->seek(m_playbackEngine->position() - frameStep);
+      m_playbackEngine->stepFrames(-1);
       event->accept();
       return;
     }
   } else if (event->key() == Qt::Key_Right) {
     // Only intercept if we are not in an input widget
     if (!focusWidget() || !focusWidget()->inherits("QAbstractSpinBox")) {
-      m_playbackEngine->seek(m_playbackEngine->position() + frameStep);
+      m_playbackEngine->stepFrames(1);
       event->accept();
       return;
     }
@@ -13,6 +13,7 @@
 #define MAINWINDOW_H
 
 #include <QCheckBox>
+#include <QComboBox>
 #include <QElapsedTimer>
 #include <QFrame>
 #include <QKeyEvent>
@@ -31,21 +32,30 @@
 #include <QToolButton>
 #include <QWidgetAction>
 
+#include <atomic>
+#include <memory>
+
 // Forward declarations - Core layer
 class PlaybackEngine;
 class RythmoManager;
 class AudioRecorder;
 class ExportService;
+class ExportQueue;
+class LiveExportEncoder;
 class SaveManager;
+class AutosaveManager;
+class ThumbnailCache;
 
 // Forward declarations - GUI layer
 class VideoWidget;
 class RythmoOverlay;
 class TrackPanel;
 class ClickableSlider;
+class FilmstripWidget;
 
 // Forward declaration - Utils
 struct ExportConfig;
+struct SaveData;
 
 /**
  * @class MainWindow
@@ -65,7 +75,7 @@ class MainWindow : public QMainWindow {
 
 public:
   explicit MainWindow(QWidget *parent = nullptr);
-  ~MainWindow() override = default;
+  ~MainWindow() override;
 
 protected:
   bool eventFilter(QObject *watched, QEvent *event) override;
@@ -89,6 +99,9 @@ private slots:
   // Export
   void onExportProgress(int percentage);
   void onExportFinished(bool success, const QString &message);
+  void onQueueJobFinished(const QString &id, bool success,
+                          const QString &message);
+  void onExportRythmoOnly();
 
   // Error handling
   void onError(const QString &errorMessage);
@@ -102,6 +115,17 @@ private:
   void enterFullscreenRecording();
   void exitFullscreenRecording();
   void showShortcutsPopup();
+  QString enqueueExport(const ExportConfig &config, bool held = false);
+  SaveData currentSaveData() const;
+  void applySaveData(const SaveData &data,
+                     const QString &projectPath = QString());
+  void relinkVideo(const SaveData &data, const QString &missingPath,
+                   const QString &projectPath);
+  void cancelRelink();
+  void promptRelink();
+  void loadVideoWaveform(const QString &source);
+  void loadTakeWaveform(int track);
+  void restoreAutosave();
 
   // =========================================================================
   // Core Services (Business Logic)
@@ -112,7 +136,11 @@ private:
   AudioRecorder *m_audioRecorder1;
   AudioRecorder *m_audioRecorder2;
   ExportService *m_exportService;
+  LiveExportEncoder *m_liveEncoder;
+  ExportQueue *m_exportQueue;
   SaveManager *m_saveManager;
+  AutosaveManager *m_autosave;
+  ThumbnailCache *m_thumbnails;
 
   // =========================================================================
   // GUI Components
@@ -126,8 +154,10 @@ private:
   // Playback controls
   QPushButton *m_playPauseButton;
   QPushButton *m_stopButton;
+  FilmstripWidget *m_filmstrip;
   ClickableSlider *m_positionSlider;
   QLabel *m_timeLabel;
+  QComboBox *m_rateCombo; ///< Playback rate, for rehearsals
 
   // Volume controls
   QPushButton *m_volumeButton;
@@ -152,6 +182,14 @@ private:
   QAction *m_actionOpenMp4;
   QAction *m_actionLoadProject;
   QAction *m_actionSaveProject;
+  QAction *m_actionExportStems;
+  QAction *m_actionExportMultiTrack;
+  QAction *m_actionLiveEncode;
+  QAction *m_actionExportPriority;
+  QAction *m_actionShowQueue;
+  QAction *m_actionPauseQueue;
+  QAction *m_actionQueueJobs;
+  QAction *m_actionClearQueue;
 
   QAction *m_actionExpertMode;
   QAction *m_actionEnableTrack2;
@@ -161,6 +199,7 @@ private:
 
   QAction *m_actionPersonalizeRythmo;
   QAction *m_actionExportRythmo;
+  QAction *m_actionExportRythmoOnly;
 
   // =========================================================================
   // State
@@ -174,6 +213,9 @@ private:
   QElapsedTimer m_recordingTimer;
   qint64 m_lastRecordedDurationMs;
   qint64 m_recordingStartTimeMs;
+  qreal m_rehearsalRate; ///< Playback rate to restore after a recording
+  QString m_pendingLiveJob; ///< Queued take waiting for its live soundtrack
+  std::shared_ptr<std::atomic<bool>> m_relinkCancel; ///< Running search
 };
 
 #endif // MAINWINDOW_H
@@ -59,6 +59,11 @@ void RythmoOverlay::setPlaying(bool playing) {
   m_rythmo2->setPlaying(playing);
 }
 
+void RythmoOverlay::setPlaybackRate(qreal rate) {
+  m_rythmo1->setPlaybackRate(rate);
+  m_rythmo2->setPlaybackRate(rate);
+}
+
 void RythmoOverlay::setSpeed(int speed) {
   m_rythmo1->setSpeed(speed);
   m_rythmo2->setSpeed(speed);
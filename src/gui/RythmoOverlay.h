@@ -59,6 +59,9 @@ public slots:
   /** @brief Sets playing state for both tracks. */
   void setPlaying(bool playing);
 
+  /** @brief Sets the media playback rate for both tracks' extrapolation. */
+  void setPlaybackRate(qreal rate);
+
   /** @brief Sets scrolling speed for both tracks. */
   void setSpeed(int speed);
 
@@ -4,6 +4,7 @@
  */
 
 #include "RythmoWidget.h"
+#include "../core/RythmoRenderer.h"
 
 #include <QFontDatabase>
 #include <QFontMetrics>
@@ -71,6 +72,18 @@ void RythmoWidget::setEditable(bool editable) { m_editable = editable; }
 
 bool RythmoWidget::isEditable() const { return m_editable; }
 
+void RythmoWidget::setWaveform(std::shared_ptr<const PeakPyramid> peaks) {
+  m_waveform = std::move(peaks);
+  update();
+}
+
+void RythmoWidget::setTakeWaveform(std::shared_ptr<const PeakPyramid> peaks,
+                                   qint64 startMs) {
+  m_takeWaveform = std::move(peaks);
+  m_takeStartMs = startMs;
+  update();
+}
+
 void RythmoWidget::setText(const QString &text) {
   if (m_text != text) {
     m_text = text;
@@ -118,6 +131,19 @@ void RythmoWidget::setPlaying(bool playing) {
   }
 }
 
+void RythmoWidget::setPlaybackRate(qreal rate) {
+  if (rate <= 0.0 || qFuzzyCompare(rate, m_playbackRate))
+    return;
+
+  // Re-anchor: the time already elapsed was at the previous rate
+  if (m_isPlaying) {
+    animate();
+    m_lastSyncPosition = m_currentPosition;
+    m_lastSyncTime = QDateTime::currentMSecsSinceEpoch();
+  }
+  m_playbackRate = rate;
+}
+
 void RythmoWidget::sync(qint64 positionMs) {
   // Always update anchor points for interpolation
   m_lastSyncPosition = positionMs;
@@ -146,8 +172,9 @@ void RythmoWidget::animate() {
   qint64 now = QDateTime::currentMSecsSinceEpoch();
   qint64 elapsed = now - m_lastSyncTime;
 
-  // Extrapolate position based on time elapsed since last sync
-  m_currentPosition = m_lastSyncPosition + elapsed;
+  // Extrapolate position based on time elapsed since last sync, at the
+  // playback rate (slowed down for rehearsals)
+  m_currentPosition = m_lastSyncPosition + qRound64(elapsed * m_playbackRate);
 
   // Note: m_cursorIndex will be calculated on-the-fly in paintEvent
   // via cursorIndex() method, or we could update it here if needed.
@@ -163,8 +190,7 @@ void RythmoWidget::animate() {
 
 int RythmoWidget::charWidth() const {
   if (m_cachedCharWidth == -1) {
-    QFontMetrics fm(m_style.font);
-    m_cachedCharWidth = fm.horizontalAdvance('A');
+    m_cachedCharWidth = RythmoRenderer::charWidth(m_style.font);
   }
   return m_cachedCharWidth;
 }
@@ -246,47 +272,12 @@ void RythmoWidget::paintEvent(QPaintEvent *event) {
     pixelOffset = static_cast<double>(cursorIndex() * cw);
   }
 
-  double textStartX = targetX - pixelOffset;
-
-  // 3. Draw band background
-  QColor bgColor = m_style.backgroundColor;
-  // If playing, we might want to slightly lighten or darken it as a visual cue
-  if (m_isPlaying) {
-    bgColor = bgColor.lighter(110);
-  }
-  painter.fillRect(bandRect, bgColor);
-
-  // 4. Draw scrolling text (virtualized for performance)
-  if (cw > 0 && !m_text.isEmpty()) {
-    painter.setFont(m_style.font);
-    painter.setPen(m_style.textColor);
-
-    int textY = bandY + (bandHeight + m_style.globalSize) / 2 - 2;
-
-    // Only render visible characters
-    int firstVisibleIdx = std::max(0, static_cast<int>(-textStartX / cw));
-    int lastVisibleIdx =
-        std::min(static_cast<int>(m_text.length()),
-                 static_cast<int>((width() - textStartX) / cw) + 1);
-
-    if (firstVisibleIdx < lastVisibleIdx) {
-      QString visibleText =
-          m_text.mid(firstVisibleIdx, lastVisibleIdx - firstVisibleIdx);
-      painter.drawText(QPointF(textStartX + (firstVisibleIdx * cw), textY),
-                       visibleText);
-    }
-  }
-
-  // 5. Draw band border
-  QPen borderPen(QColor(0, 120, 215), 2);
-  painter.setPen(borderPen);
-  painter.drawRect(bandRect);
+  // 3-6. Band background, text, border and target line
+  RythmoRenderer::paintBand(painter, bandRect, m_text, m_style, cw,
+                            pixelOffset, targetX, m_isPlaying);
 
-  // 6. Draw target line (guide)
-  QPen targetPen(QColor(0, 120, 215), 2);
-  targetPen.setStyle(Qt::DashLine);
-  painter.setPen(targetPen);
-  painter.drawLine(targetX, bandY, targetX, bandY + bandHeight);
+  // Waveforms over the band, faint enough to keep the text readable
+  paintWaveforms(painter, bandRect, pixelOffset, targetX);
 
   // 7. Draw edit cursor (always at targetX to align with playback line)
   if (cw > 0) {
@@ -340,6 +331,46 @@ void RythmoWidget::paintEvent(QPaintEvent *event) {
   }
 }
 
+void RythmoWidget::paintWaveforms(QPainter &painter, const QRect &bandRect,
+                                  double pixelOffset, int targetX) {
+  if ((!m_waveform && !m_takeWaveform) || m_speed <= 0)
+    return;
+
+  // Time under the left edge and right edge of the band, one column per
+  // pixel: the pyramid picks the matching resolution
+  const qint64 startMs =
+      static_cast<qint64>((pixelOffset - targetX) * 1000.0 / m_speed);
+  const qint64 endMs = startMs + static_cast<qint64>(
+                                     bandRect.width() * 1000.0 / m_speed);
+  const double middle = bandRect.center().y() + 0.5;
+  const double scale = bandRect.height() / 2.0 - 1.0;
+
+  auto draw = [&](const QVector<PeakPyramid::Peak> &peaks,
+                  const QColor &color) {
+    painter.setPen(color);
+    for (int x = 0; x < peaks.size(); ++x) {
+      painter.drawLine(
+          QPointF(bandRect.left() + x + 0.5, middle - peaks[x].max * scale),
+          QPointF(bandRect.left() + x + 0.5, middle - peaks[x].min * scale));
+    }
+  };
+
+  painter.save();
+  painter.setRenderHint(QPainter::Antialiasing, false);
+  if (m_waveform) {
+    draw(m_waveform->query(startMs, endMs, bandRect.width()),
+         QColor(128, 128, 128, 70));
+  }
+  if (m_takeWaveform) {
+    QColor takeColor = m_style.textColor;
+    takeColor.setAlpha(90);
+    draw(m_takeWaveform->query(startMs - m_takeStartMs, endMs - m_takeStartMs,
+                               bandRect.width()),
+         takeColor);
+  }
+  painter.restore();
+}
+
 // =============================================================================
 // Mouse Events
 // =============================================================================
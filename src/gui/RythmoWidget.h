@@ -16,12 +16,17 @@
 #ifndef RYTHMOWIDGET_H
 #define RYTHMOWIDGET_H
 
+#include "../core/PeakPyramid.h"
 #include "../core/RythmoManager.h"
 #include <QColor>
 #include <QFont>
 #include <QTimer>
 #include <QWidget>
 
+#include <memory>
+
+class QPainter;
+
 /**
  * @class RythmoWidget
  * @brief Displays a single Rythmo track with scrolling text.
@@ -65,6 +70,16 @@ public:
   void setEditable(bool editable);
   bool isEditable() const;
 
+  /** @brief Waveform of the original audio, scrolled with the text. */
+  void setWaveform(std::shared_ptr<const PeakPyramid> peaks);
+
+  /**
+   * @brief Waveform of this band's take.
+   * @param startMs Video position where the take starts.
+   */
+  void setTakeWaveform(std::shared_ptr<const PeakPyramid> peaks,
+                       qint64 startMs);
+
 signals:
   void textChanged(const QString &text);
 
@@ -96,6 +111,12 @@ public slots:
    */
   void setPlaying(bool playing);
 
+  /**
+   * @brief Sets the media speed the band scrolls at between syncs.
+   * @param rate Media milliseconds per wall-clock millisecond (1.0: normal).
+   */
+  void setPlaybackRate(qreal rate);
+
   /**
    * @brief Legacy sync method for compatibility.
    */
@@ -171,6 +192,8 @@ private:
   qint64 charDurationMs() const;
   void requestDebouncedSeek(qint64 positionMs);
   void triggerSeek();
+  void paintWaveforms(QPainter &painter, const QRect &bandRect,
+                      double pixelOffset, int targetX);
 
   // =========================================================================
   // Display State (set externally)
@@ -189,6 +212,11 @@ private:
   QColor m_barColor;
   QColor m_playingBarColor;
 
+  // Waveforms (original audio, take)
+  std::shared_ptr<const PeakPyramid> m_waveform;
+  std::shared_ptr<const PeakPyramid> m_takeWaveform;
+  qint64 m_takeStartMs = 0;
+
   // Interaction state
   int m_lastMouseX;
 
@@ -203,6 +231,7 @@ private:
   QTimer *m_animationTimer;
   qint64 m_lastSyncPosition = 0;
   qint64 m_lastSyncTime = 0; // System time (ms) at last sync
+  qreal m_playbackRate = 1.0; // Media ms per system ms
 
 private slots:
   void animate();
@@ -26,6 +26,15 @@ QVideoSink *VideoWidget::videoSink() const
     return m_videoSink;
 }
 
+void VideoWidget::showImage(const QImage &image)
+{
+    if (image.isNull()) {
+        return;
+    }
+    m_currentImage = image;
+    update();
+}
+
 void VideoWidget::handleFrame(const QVideoFrame &frame)
 {
     if (!frame.isValid()) {
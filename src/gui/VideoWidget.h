@@ -39,6 +39,14 @@ public:
      */
     QVideoSink *videoSink() const;
 
+public slots:
+    /**
+     * @brief Shows an already decoded frame (see PlaybackEngine::cachedFrameReady).
+     *
+     * Replaced by the next frame from the sink.
+     */
+    void showImage(const QImage &image);
+
 protected:
     void paintEvent(QPaintEvent *event) override;
 
@@ -0,0 +1,113 @@
+/**
+ * @file Checksum.cpp
+ * @brief Implementation of Checksum utility functions.
+ */
+
+#include "Checksum.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define DUBINSTANTE_CRC32C_SSE42
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define DUBINSTANTE_CRC32C_ARM
+#endif
+
+namespace {
+
+// Slicing-by-8: eight tables let the loop consume 8 bytes per iteration,
+// several times faster than the byte-wise algorithm on large files.
+using CrcTables = std::array<std::array<quint32, 256>, 8>;
+
+CrcTables makeTables(quint32 polynomial)
+{
+    CrcTables tables{};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ polynomial : crc >> 1;
+        }
+        tables[0][i] = crc;
+    }
+    for (quint32 i = 0; i < 256; ++i) {
+        for (int slice = 1; slice < 8; ++slice) {
+            quint32 previous = tables[slice - 1][i];
+            tables[slice][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+        }
+    }
+    return tables;
+}
+
+quint32 update(const CrcTables &t, quint32 crc, const char *data, qint64 size)
+{
+    const auto *p = reinterpret_cast<const uchar *>(data);
+    crc = ~crc;
+
+    while (size >= 8) {
+        // Assembled byte by byte: no alignment or endianness assumption
+        quint32 low = crc ^ (quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16
+                             | quint32(p[3]) << 24);
+        quint32 high = quint32(p[4]) | quint32(p[5]) << 8 | quint32(p[6]) << 16
+                       | quint32(p[7]) << 24;
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF]
+              ^ t[4][low >> 24] ^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF]
+              ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    }
+    return ~crc;
+}
+
+#if defined(DUBINSTANTE_CRC32C_SSE42) || defined(DUBINSTANTE_CRC32C_ARM)
+quint32 updateCrc32cHardware(quint32 crc, const char *data, qint64 size)
+{
+    crc = ~crc;
+    while (size >= 8) {
+        quint64 word;
+        std::memcpy(&word, data, 8);    // Unaligned-safe load
+#if defined(DUBINSTANTE_CRC32C_SSE42)
+        crc = static_cast<quint32>(_mm_crc32_u64(crc, word));
+#else
+        crc = __crc32cd(crc, word);
+#endif
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+#if defined(DUBINSTANTE_CRC32C_SSE42)
+        crc = _mm_crc32_u8(crc, static_cast<uchar>(*data++));
+#else
+        crc = __crc32cb(crc, static_cast<uchar>(*data++));
+#endif
+    }
+    return ~crc;
+}
+#endif
+
+} // namespace
+
+namespace Checksum {
+
+quint32 crc32(quint32 crc, const char *data, qint64 size)
+{
+    static const CrcTables tables = makeTables(0xEDB88320u);
+    return update(tables, crc, data, size);
+}
+
+quint32 crc32c(quint32 crc, const char *data, qint64 size)
+{
+#if defined(DUBINSTANTE_CRC32C_SSE42) || defined(DUBINSTANTE_CRC32C_ARM)
+    return updateCrc32cHardware(crc, data, size);
+#else
+    static const CrcTables tables = makeTables(0x82F63B78u);
+    return update(tables, crc, data, size);
+#endif
+}
+
+} // namespace Checksum
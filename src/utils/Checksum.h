@@ -0,0 +1,44 @@
+/**
+ * @file Checksum.h
+ * @brief Incremental CRC-32 and CRC-32C for archives and file formats.
+ *
+ * @note Part of the Utils layer - shared utilities.
+ */
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <QtGlobal>
+
+/**
+ * @namespace Checksum
+ * @brief Table-driven checksums, fast enough to run over multi-gigabyte media.
+ */
+namespace Checksum {
+
+/**
+ * @brief Updates a CRC-32 (IEEE 802.3, as used by ZIP and PNG).
+ * @param crc Value returned for the previous chunk (0 to start).
+ * @param data Bytes to add.
+ * @param size Number of bytes.
+ * @return CRC-32 of everything added so far.
+ *
+ * @code
+ * quint32 crc = 0;
+ * while (...)
+ *     crc = Checksum::crc32(crc, chunk.constData(), chunk.size());
+ * @endcode
+ */
+quint32 crc32(quint32 crc, const char *data, qint64 size);
+
+/**
+ * @brief Updates a CRC-32C (Castagnoli, as used by iSCSI and ext4).
+ *
+ * Same usage as crc32(). Uses the CPU's CRC32 instructions when the
+ * build targets them (SSE4.2, ARMv8 CRC), the table-driven code otherwise.
+ */
+quint32 crc32c(quint32 crc, const char *data, qint64 size);
+
+} // namespace Checksum
+
+#endif // CHECKSUM_H
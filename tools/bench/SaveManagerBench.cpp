@@ -0,0 +1,137 @@
+/**
+ * @file SaveManagerBench.cpp
+ * @brief Save/load benchmark for SaveManager on a large synthetic project.
+ *
+ * Built only with -DDUBINSTANTE_BUILD_BENCHMARKS=ON (see CMakeLists.txt).
+ *
+ * `SaveManagerBench [--tracks N] [--chars M] [--runs R]` saves a project
+ * of N tracks of M characters each (mixed ASCII and accented text, with
+ * the runs of spaces that encode timing), loads it back and checks the
+ * round trip, R times. Reports the best and median save() and load()
+ * times and the load throughput.
+ */
+
+#include "SaveManager.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// The decoder's own limit on the number of tracks
+constexpr int MAX_TRACKS = 64;
+
+/** Dialogue-like text: words, accents and timing spaces. */
+QString syntheticTrack(int track, int chars) {
+  static const QStringList words = {
+      QStringLiteral("Bonjour"), QStringLiteral("à"),
+      QStringLiteral("tous"),    QStringLiteral("déjà"),
+      QStringLiteral("pourquoi"), QStringLiteral("ça"),
+      QStringLiteral("répète"),  QStringLiteral("encore")};
+
+  QString text;
+  text.reserve(chars);
+  for (int i = 0; text.size() < chars; ++i) {
+    text += words.at((i * 7 + track) % words.size());
+    text += QString((i + track) % 5 + 1, QChar(' '));
+  }
+  text.truncate(chars);
+  return text;
+}
+
+struct Timings {
+  std::vector<double> ms;
+
+  void add(qint64 ns) { ms.push_back(ns / 1e6); }
+  double best() const { return *std::min_element(ms.begin(), ms.end()); }
+  double median() const {
+    std::vector<double> sorted = ms;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted.at(sorted.size() / 2);
+  }
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  // Track styles hold fonts and colors
+  QGuiApplication app(argc, argv);
+
+  int trackCount = 8;
+  int chars = 1000 * 1000;
+  int runs = 5;
+  const QStringList args = app.arguments().mid(1);
+  for (int i = 0; i + 1 < args.size(); ++i) {
+    if (args.at(i) == "--tracks")
+      trackCount = qBound(1, args.at(++i).toInt(), MAX_TRACKS);
+    else if (args.at(i) == "--chars")
+      chars = qMax(1, args.at(++i).toInt());
+    else if (args.at(i) == "--runs")
+      runs = qMax(1, args.at(++i).toInt());
+  }
+
+  SaveData project;
+  project.videoVolume = 0.8f;
+  project.audioGain1 = 1.0f;
+  project.audioGain2 = 0.5f;
+  project.enableTrack2 = true;
+  project.scrollSpeed = 120;
+  project.isTextWhite = true;
+  for (int i = 0; i < trackCount; ++i)
+    project.tracks.append(TrackSaveData{syntheticTrack(i, chars), {}});
+
+  QTemporaryDir dir;
+  if (!dir.isValid()) {
+    std::fprintf(stderr, "Cannot create a temporary directory\n");
+    return 1;
+  }
+  const QString path = dir.filePath("bench.dbi");
+
+  SaveManager manager;
+  Timings saves;
+  Timings loads;
+  QElapsedTimer timer;
+  for (int run = 0; run < runs; ++run) {
+    timer.start();
+    if (!manager.save(path, project)) {
+      std::fprintf(stderr, "Save failed: %s\n", qPrintable(path));
+      return 1;
+    }
+    saves.add(timer.nsecsElapsed());
+
+    SaveData loaded;
+    timer.start();
+    if (!manager.load(path, loaded)) {
+      std::fprintf(stderr, "Load failed: %s\n", qPrintable(path));
+      return 1;
+    }
+    loads.add(timer.nsecsElapsed());
+
+    if (loaded.tracks.size() != project.tracks.size()) {
+      std::fprintf(stderr, "Round trip lost tracks\n");
+      return 1;
+    }
+    for (int i = 0; i < trackCount; ++i) {
+      if (loaded.tracks.at(i).text != project.tracks.at(i).text) {
+        std::fprintf(stderr, "Round trip changed track %d\n", i);
+        return 1;
+      }
+    }
+  }
+
+  const double megabytes = QFileInfo(path).size() / (1024.0 * 1024.0);
+  std::printf("project: %d tracks x %d chars, %.1f MiB on disk\n", trackCount,
+              chars, megabytes);
+  std::printf("save: best %.1f ms, median %.1f ms\n", saves.best(),
+              saves.median());
+  std::printf("load: best %.1f ms, median %.1f ms (%.0f MiB/s)\n",
+              loads.best(), loads.median(),
+              megabytes / (loads.best() / 1000.0));
+  return 0;
+}
@@ -0,0 +1,301 @@
+/**
+ * @file SaveManagerFuzz.cpp
+ * @brief Fuzz and regression driver for SaveManager::decode().
+ *
+ * Built only with -DDUBINSTANTE_BUILD_FUZZERS=ON (see CMakeLists.txt).
+ *
+ * - With -DDUBINSTANTE_LIBFUZZER=ON (clang): a libFuzzer target, e.g.
+ *   `SaveManagerFuzz -rss_limit_mb=512 corpus/`.
+ * - Otherwise a standalone driver:
+ *   `SaveManagerFuzz [--iterations N] [--seed S] [files...]`
+ *   decodes the given files (corpus, crash reproducers), runs the built-in
+ *   regression cases, then decodes N random mutations of a valid project.
+ *   Exits with 1 if a malformed file is accepted, a valid project does not
+ *   round-trip, or a decode returns more than the allocation bound.
+ *
+ * Build it with -fsanitize=address to catch out-of-bounds reads as well.
+ */
+
+#include "Checksum.h"
+#include "SaveManager.h"
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QGuiApplication>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtEndian>
+
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+
+// .dbi v2 layout, as written by SaveManager::encode()
+constexpr int V2_PREFIX_SIZE = 15 + 1 + 1 + 4;
+constexpr int TOC_ENTRY_SIZE = 4 + 4 + 8 + 4 + 4;
+constexpr quint32 MAX_CHUNKS = 4096;
+constexpr char XOR_KEY = 0x5A;
+
+// Same bound as SaveManager.cpp: nothing decoded may be larger
+constexpr qint64 MAX_DECODED_BYTES = 256 * 1024 * 1024;
+
+const QByteArray HEADER("DubInstanteFile");
+
+struct Entry {
+  QByteArray type;
+  quint32 index;
+  qint64 offset; ///< In the payload area
+  quint32 size;
+};
+
+template <typename T> void appendLittleEndian(QByteArray &bytes, T value) {
+  value = qToLittleEndian(value);
+  bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+QByteArray mask(QByteArray bytes) {
+  for (char &c : bytes)
+    c ^= XOR_KEY;
+  return bytes;
+}
+
+/** v2 file with the given table of contents, CRCs included. */
+QByteArray buildV2(const QList<Entry> &entries, const QByteArray &payload) {
+  QByteArray bytes = HEADER;
+  bytes.append(char(2));
+  bytes.append(char(0));
+  appendLittleEndian<quint32>(bytes, static_cast<quint32>(entries.size()));
+
+  const qint64 base = V2_PREFIX_SIZE + entries.size() * TOC_ENTRY_SIZE + 4;
+  for (const Entry &entry : entries) {
+    const qint64 available =
+        qBound<qint64>(0, payload.size() - entry.offset, entry.size);
+    bytes.append(entry.type);
+    appendLittleEndian<quint32>(bytes, entry.index);
+    appendLittleEndian<quint64>(bytes, static_cast<quint64>(base + entry.offset));
+    appendLittleEndian<quint32>(bytes, entry.size);
+    appendLittleEndian<quint32>(
+        bytes, available > 0 ? Checksum::crc32c(0, payload.constData() +
+                                                       entry.offset,
+                                                available)
+                             : 0);
+  }
+  appendLittleEndian<quint32>(
+      bytes, Checksum::crc32c(0, bytes.constData(), bytes.size()));
+  bytes.append(payload);
+  return bytes;
+}
+
+/** Makes a mutated table of contents pass its CRC, to reach the chunks. */
+void fixTableOfContents(QByteArray &bytes) {
+  if (bytes.size() < V2_PREFIX_SIZE || !bytes.startsWith(HEADER))
+    return;
+  const quint32 count =
+      qFromLittleEndian<quint32>(bytes.constData() + V2_PREFIX_SIZE - 4);
+  const qint64 tocEnd = V2_PREFIX_SIZE + qint64(count) * TOC_ENTRY_SIZE;
+  if (count > MAX_CHUNKS || bytes.size() < tocEnd + 4)
+    return;
+  qToLittleEndian<quint32>(Checksum::crc32c(0, bytes.constData(), tocEnd),
+                           bytes.data() + tocEnd);
+}
+
+/** Decodes @p bytes; false if the result exceeds the allocation bound. */
+bool decodeWithinBounds(SaveManager &manager, const QByteArray &bytes,
+                        bool *accepted = nullptr) {
+  SaveData data;
+  const bool ok = manager.decode(bytes, data);
+  if (accepted)
+    *accepted = ok;
+  qint64 decoded = 0;
+  for (const TrackSaveData &track : data.tracks)
+    decoded += track.text.size() * qint64(sizeof(QChar));
+  return decoded <= MAX_DECODED_BYTES;
+}
+
+SaveData sampleProject() {
+  SaveData data;
+  data.videoVolume = 0.8f;
+  data.audioGain1 = 1.0f;
+  data.audioGain2 = 0.5f;
+  data.enableTrack2 = true;
+  data.scrollSpeed = 120;
+  data.isTextWhite = true;
+  data.tracks = {TrackSaveData{QStringLiteral("Bonjour   à tous"), {}},
+                 TrackSaveData{QString(5000, QChar(u'é')), {}},
+                 TrackSaveData{QString(), {}}};
+  return data;
+}
+
+} // namespace
+
+#ifdef DUBINSTANTE_LIBFUZZER
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  // Track styles hold a QFont
+  qputenv("QT_QPA_PLATFORM", "offscreen");
+  static QGuiApplication app(*argc, *argv);
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static SaveManager manager;
+  const QByteArray bytes = QByteArray::fromRawData(
+      reinterpret_cast<const char *>(data), static_cast<int>(size));
+  if (!decodeWithinBounds(manager, bytes))
+    abort();
+  return 0;
+}
+
+#else
+
+int main(int argc, char **argv) {
+  // Track styles hold a QFont
+  qputenv("QT_QPA_PLATFORM", "offscreen");
+  QGuiApplication app(argc, argv);
+
+  int iterations = 20000;
+  quint32 seed = 1;
+  QStringList files;
+  const QStringList args = app.arguments().mid(1);
+  for (int i = 0; i < args.size(); ++i) {
+    if (args.at(i) == "--iterations" && i + 1 < args.size())
+      iterations = args.at(++i).toInt();
+    else if (args.at(i) == "--seed" && i + 1 < args.size())
+      seed = args.at(++i).toUInt();
+    else
+      files << args.at(i);
+  }
+
+  SaveManager manager;
+  int failures = 0;
+  auto check = [&failures](const QString &name, bool ok) {
+    if (!ok) {
+      ++failures;
+      std::fprintf(stderr, "FAIL %s\n", qPrintable(name));
+    }
+  };
+  auto rejected = [&manager](const QByteArray &bytes) {
+    bool accepted = true;
+    return decodeWithinBounds(manager, bytes, &accepted) && !accepted;
+  };
+
+  // Given files: decoded without crashing and within bounds
+  for (const QString &path : files) {
+    QFile file(path);
+    check(path, file.open(QIODevice::ReadOnly) &&
+                    decodeWithinBounds(manager, file.readAll()));
+  }
+
+  // Valid project written by save(): round-trips
+  QTemporaryDir dir;
+  const QString projectPath = dir.filePath("sample.dbi");
+  const SaveData original = sampleProject();
+  QByteArray valid;
+  {
+    QFile file(projectPath);
+    if (manager.save(projectPath, original) && file.open(QIODevice::ReadOnly))
+      valid = file.readAll();
+  }
+  SaveData loaded;
+  check("round trip", !valid.isEmpty() && manager.decode(valid, loaded) &&
+                          loaded.tracks.size() == original.tracks.size() &&
+                          loaded.tracks.at(0).text == original.tracks.at(0).text &&
+                          loaded.tracks.at(1).text == original.tracks.at(1).text &&
+                          loaded.scrollSpeed == original.scrollSpeed);
+
+  // Every truncation is rejected
+  for (int size = 0; size < valid.size(); ++size) {
+    if (!rejected(valid.left(size))) {
+      check(QString("truncated to %1 bytes").arg(size), false);
+      break;
+    }
+  }
+
+  const QByteArray settings = mask("{}");
+
+  // Overlapping chunks: 64 tracks on the same 8 MiB would decode to 1.5 GiB
+  {
+    QByteArray payload = settings + mask(QByteArray(8 * 1024 * 1024, 'a'));
+    QList<Entry> entries = {{"SETS", 0, 0, quint32(settings.size())}};
+    for (quint32 i = 0; i < 64; ++i)
+      entries.append({"TEXT", i, settings.size(),
+                      quint32(payload.size() - settings.size())});
+    check("overlapping chunks", rejected(buildV2(entries, payload)));
+  }
+
+  // Same chunk twice
+  {
+    QByteArray payload = settings + mask("texte");
+    check("duplicate chunk",
+          rejected(buildV2({{"SETS", 0, 0, quint32(settings.size())},
+                            {"TEXT", 0, settings.size(), 5},
+                            {"TEXT", 0, settings.size(), 5}},
+                           payload)));
+  }
+
+  // Style chunk over the JSON cap
+  {
+    QByteArray payload = settings + mask(QByteArray(2 * 1024 * 1024, ' '));
+    check("oversized style",
+          rejected(buildV2({{"SETS", 0, 0, quint32(settings.size())},
+                            {"STYL", 0, settings.size(),
+                             quint32(payload.size() - settings.size())}},
+                           payload)));
+  }
+
+  // Chunk past the end of the file
+  check("chunk out of range",
+        rejected(buildV2({{"SETS", 0, 0, quint32(settings.size())},
+                          {"TEXT", 0, settings.size(), 0xFFFFFFF0u}},
+                         settings)));
+
+  // Track index past the limit
+  check("track index",
+        rejected(buildV2({{"SETS", 0, 0, quint32(settings.size())},
+                          {"TEXT", 1000, 0, quint32(settings.size())}},
+                         settings)));
+
+  // Chunk count with no table behind it
+  {
+    QByteArray bytes = HEADER;
+    bytes.append(char(2));
+    bytes.append(char(0));
+    appendLittleEndian<quint32>(bytes, 0xFFFFFFFFu);
+    bytes.append(QByteArray(64, '\0'));
+    check("chunk count", rejected(bytes));
+  }
+
+  // v1 payload size larger than the file
+  {
+    QByteArray bytes = HEADER;
+    bytes.append(char(1));
+    bytes.append(char(0));
+    appendLittleEndian<quint32>(bytes, 0xFFFFFFF0u);
+    bytes.append(QByteArray(64, '\0'));
+    check("v1 payload size", rejected(bytes));
+  }
+
+  // Random mutations of the valid project; half of them with a fixed-up
+  // table of contents so they reach the chunk decoding
+  QRandomGenerator random(seed);
+  for (int i = 0; i < iterations && !valid.isEmpty(); ++i) {
+    QByteArray bytes = valid;
+    const int flips = 1 + random.bounded(8);
+    for (int f = 0; f < flips; ++f)
+      bytes[random.bounded(bytes.size())] = char(random.bounded(256));
+    if (random.bounded(4) == 0)
+      bytes.truncate(random.bounded(bytes.size()));
+    if (random.bounded(2) == 0)
+      fixTableOfContents(bytes);
+    check(QString("mutation %1 (seed %2)").arg(i).arg(seed),
+          decodeWithinBounds(manager, bytes));
+  }
+
+  std::printf("%s: %d failure(s), %d mutations\n",
+              failures ? "FAILED" : "OK", failures, iterations);
+  return failures ? 1 : 0;
+}
+
+#endif // DUBINSTANTE_LIBFUZZER